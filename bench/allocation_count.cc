@@ -0,0 +1,30 @@
+#include "allocation_count.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<std::size_t> count{0};
+
+std::size_t allocation_count()
+{
+  return count.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size)
+{
+  count.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstddef>
+
+// the number of calls to global operator new so far, so the benchmarks can
+// report the number of heap allocations per signature. the replacement
+// operators live in their own translation unit so they aren't inlined into
+// code that was compiled against the standard ones
+std::size_t allocation_count();
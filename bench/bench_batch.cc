@@ -0,0 +1,133 @@
+#include <random>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <awssign/v4.hpp>
+
+// constants that are common to each request
+constexpr std::string_view access_key_id = "ACCESS";
+constexpr std::string_view secret_access_key = "SECRET";
+constexpr std::string_view method = "PUT";
+constexpr std::string_view uri_path = "/bucket/key";
+constexpr std::string_view query = "";
+constexpr std::string_view payload_hash = "UNSIGNED-PAYLOAD";
+constexpr std::string_view date_iso8601 = "21010101T000000Z";
+constexpr std::string_view region = "region";
+constexpr std::string_view service = "service";
+
+void noop_writer(const char*, const char*) {}
+
+struct header_type {
+  std::string_view name_string() const { return name_; }
+  std::string_view value() const { return value_; }
+
+  std::string name_;
+  std::string value_;
+};
+
+using random_engine = std::default_random_engine;
+using size_distribution = std::uniform_int_distribution<std::size_t>;
+
+static constexpr std::string_view alphanumeric_chars{
+  "abcdefghijklmnopqrstuvwxyz"
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+  "0123456789"
+};
+
+// generate random headers with medium-length names and values
+static std::vector<header_type> generate_headers(std::size_t count)
+{
+  random_engine rng; // default seed
+  auto lengths = size_distribution{12, 32};
+  auto index = size_distribution{0, alphanumeric_chars.size() - 1};
+  auto headers = std::vector<header_type>{count};
+  for (auto& h : headers) {
+    std::generate_n(std::back_inserter(h.name_), lengths(rng),
+                    [&] { return alphanumeric_chars[index(rng)]; });
+    std::generate_n(std::back_inserter(h.value_), lengths(rng),
+                    [&] { return alphanumeric_chars[index(rng)]; });
+  }
+  return headers;
+}
+
+// sign each request separately with the secret access key
+static void bench_sign(benchmark::State& state)
+{
+  using awssign::v4::sign;
+  using awssign::v4::sha256;
+  const std::size_t request_count = state.range(0);
+  const std::size_t headers_per_request = state.range(1);
+  const auto headers = generate_headers(request_count * headers_per_request);
+
+  for (auto _ : state) {
+    auto header = headers.begin();
+    for (std::size_t request = 0; request < request_count; ++request) {
+      auto end = header + headers_per_request;
+      sign<sha256>(access_key_id, secret_access_key,
+                   method, uri_path, query, header, end, payload_hash,
+                   date_iso8601, region, service, noop_writer);
+      header = end;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * request_count);
+}
+BENCHMARK(bench_sign)->ArgNames({"requests", "headers"})
+    ->ArgsProduct({{64, 1024}, {4, 16}});
+
+// sign each request separately with a signing key that is derived once
+static void bench_sign_key(benchmark::State& state)
+{
+  using awssign::v4::sign;
+  using awssign::v4::sha256;
+  const std::size_t request_count = state.range(0);
+  const std::size_t headers_per_request = state.range(1);
+  const auto headers = generate_headers(request_count * headers_per_request);
+
+  for (auto _ : state) {
+    const auto key = awssign::v4::make_signing_key<sha256>(
+        secret_access_key, date_iso8601, region, service);
+    auto header = headers.begin();
+    for (std::size_t request = 0; request < request_count; ++request) {
+      auto end = header + headers_per_request;
+      sign<sha256>(access_key_id, key,
+                   method, uri_path, query, header, end, payload_hash,
+                   date_iso8601, region, service, noop_writer);
+      header = end;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * request_count);
+}
+BENCHMARK(bench_sign_key)->ArgNames({"requests", "headers"})
+    ->ArgsProduct({{64, 1024}, {4, 16}});
+
+// sign all of the requests with one call to sign_batch()
+static void bench_sign_batch(benchmark::State& state)
+{
+  using awssign::v4::sha256;
+  using iterator = std::vector<header_type>::const_iterator;
+  using request_type = awssign::v4::sign_batch_request<
+      iterator, decltype(&noop_writer)>;
+  const std::size_t request_count = state.range(0);
+  const std::size_t headers_per_request = state.range(1);
+  const auto headers = generate_headers(request_count * headers_per_request);
+
+  auto requests = std::vector<request_type>{};
+  auto header = headers.begin();
+  for (std::size_t request = 0; request < request_count; ++request) {
+    auto end = header + headers_per_request;
+    requests.push_back(request_type{method, uri_path, query, header, end,
+                                    payload_hash, date_iso8601, noop_writer});
+    header = end;
+  }
+
+  for (auto _ : state) {
+    awssign::v4::sign_batch<sha256>(access_key_id, secret_access_key,
+                                    region, service, requests.data(),
+                                    requests.data() + requests.size());
+  }
+  state.SetItemsProcessed(state.iterations() * request_count);
+}
+BENCHMARK(bench_sign_batch)->ArgNames({"requests", "headers"})
+    ->ArgsProduct({{64, 1024}, {4, 16}});
+
+BENCHMARK_MAIN();
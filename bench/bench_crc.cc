@@ -0,0 +1,41 @@
+#include <string>
+#include <benchmark/benchmark.h>
+#include <awssign/detail/crc.hpp>
+
+// crc throughput for x-amz-checksum trailers on each backend. the second
+// argument is the backend: 0 scalar, 1 sse4.2 (crc32c only), 2 pclmul
+
+using awssign::detail::crc_backend;
+
+template <typename Crc>
+static void bench_crc(benchmark::State& state, Crc crc)
+{
+  const auto backend = static_cast<crc_backend>(state.range(1));
+  if (!awssign::detail::crc_supported(backend)) {
+    state.SkipWithError("backend not supported");
+    return;
+  }
+  const auto data = std::string(state.range(0), 'x');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(crc(0, data.data(), data.size(), backend));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+static void bench_crc32(benchmark::State& state)
+{
+  bench_crc(state, [] (auto... args) { return awssign::detail::crc32(args...); });
+}
+BENCHMARK(bench_crc32)->ArgsProduct({{64, 4 << 10, 1 << 20}, {0, 2}});
+
+static void bench_crc32c(benchmark::State& state)
+{
+  bench_crc(state, [] (auto... args) { return awssign::detail::crc32c(args...); });
+}
+BENCHMARK(bench_crc32c)->ArgsProduct({{64, 4 << 10, 1 << 20}, {0, 1, 2}});
+
+static void bench_crc64nvme(benchmark::State& state)
+{
+  bench_crc(state, [] (auto... args) { return awssign::detail::crc64nvme(args...); });
+}
+BENCHMARK(bench_crc64nvme)->ArgsProduct({{64, 4 << 10, 1 << 20}, {0, 2}});
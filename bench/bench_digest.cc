@@ -0,0 +1,246 @@
+#include <benchmark/benchmark.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <awssign/detail/digest.hpp>
+#include <awssign/detail/multi_digest.hpp>
+#include <awssign/detail/sha256.hpp>
+#include <awssign/detail/sha256_mb.hpp>
+#include <vector>
+
+// these benchmarks construct a digest/hmac for each short message, which is
+// how sign(), presign() and verify() use them. run them with several threads
+// to compare the contention of per-object algorithm lookups
+
+constexpr const char* hash_algorithm = "SHA256";
+constexpr unsigned char key[] = {'k','e','y'};
+constexpr std::string_view message =
+    "AWS4-HMAC-SHA256\n20150830T123600Z\n20150830/us-east-1/service/aws4_request\n"
+    "bb579772317eb040ac9ed261061d46c1f17a8133879d6129b6e1c25292927e63";
+
+// resolve the algorithm by name for each digest
+static void bench_digest_lookup(benchmark::State& state)
+{
+  unsigned char buffer[EVP_MAX_MD_SIZE];
+  unsigned int size = 0;
+  auto ctx = ::EVP_MD_CTX_new();
+  for (auto _ : state) {
+    ::EVP_DigestInit_ex(ctx, ::EVP_get_digestbyname(hash_algorithm), nullptr);
+    ::EVP_DigestUpdate(ctx, message.data(), message.size());
+    ::EVP_DigestFinal_ex(ctx, buffer, &size);
+    benchmark::DoNotOptimize(buffer);
+  }
+  ::EVP_MD_CTX_free(ctx);
+}
+BENCHMARK(bench_digest_lookup)->ThreadRange(1, 8)->UseRealTime();
+
+static void bench_digest_cached(benchmark::State& state)
+{
+  using awssign::detail::digest;
+  unsigned char buffer[digest::max_size];
+  for (auto _ : state) {
+    auto hash = digest{hash_algorithm};
+    hash.update(message.data(), message.size());
+    benchmark::DoNotOptimize(hash.finish(buffer));
+  }
+}
+BENCHMARK(bench_digest_cached)->ThreadRange(1, 8)->UseRealTime();
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+
+// fetch the mac and resolve the algorithm by name for each hmac
+static void bench_hmac_lookup(benchmark::State& state)
+{
+  unsigned char buffer[EVP_MAX_MD_SIZE];
+  std::size_t size = 0;
+  for (auto _ : state) {
+    auto mac = ::EVP_MAC_fetch(nullptr, "HMAC", nullptr);
+    auto ctx = ::EVP_MAC_CTX_new(mac);
+    char digest_name[] = "SHA256";
+    const OSSL_PARAM params[] = {
+      ::OSSL_PARAM_construct_utf8_string("digest", digest_name, 0),
+      ::OSSL_PARAM_construct_end()
+    };
+    ::EVP_MAC_init(ctx, key, sizeof(key), params);
+    ::EVP_MAC_update(ctx, reinterpret_cast<const unsigned char*>(message.data()),
+                     message.size());
+    ::EVP_MAC_final(ctx, buffer, &size, sizeof(buffer));
+    ::EVP_MAC_CTX_free(ctx);
+    ::EVP_MAC_free(mac);
+    benchmark::DoNotOptimize(buffer);
+  }
+}
+
+#else // OPENSSL_VERSION_NUMBER < 0x30000000L
+
+// resolve the algorithm by name and initialize HMAC_CTX for each hmac
+static void bench_hmac_lookup(benchmark::State& state)
+{
+  unsigned char buffer[EVP_MAX_MD_SIZE];
+  unsigned int size = 0;
+  for (auto _ : state) {
+    auto ctx = ::HMAC_CTX_new();
+    ::HMAC_Init_ex(ctx, key, sizeof(key),
+                   ::EVP_get_digestbyname(hash_algorithm), nullptr);
+    ::HMAC_Update(ctx, reinterpret_cast<const unsigned char*>(message.data()),
+                  message.size());
+    ::HMAC_Final(ctx, buffer, &size);
+    ::HMAC_CTX_free(ctx);
+    benchmark::DoNotOptimize(buffer);
+  }
+}
+
+#endif // OPENSSL_VERSION_NUMBER < 0x30000000L
+BENCHMARK(bench_hmac_lookup)->ThreadRange(1, 8)->UseRealTime();
+
+static void bench_hmac_cached(benchmark::State& state)
+{
+  using awssign::detail::hmac;
+  unsigned char buffer[hmac::max_size];
+  for (auto _ : state) {
+    auto hash = hmac{hash_algorithm, key, sizeof(key)};
+    hash.update(message.data(), message.size());
+    benchmark::DoNotOptimize(hash.finish(buffer));
+  }
+}
+BENCHMARK(bench_hmac_cached)->ThreadRange(1, 8)->UseRealTime();
+
+// start each hmac from a copy of a keyed prototype
+static void bench_hmac_prototype(benchmark::State& state)
+{
+  using awssign::detail::hmac;
+  const auto prototype = hmac{hash_algorithm, key, sizeof(key)};
+  unsigned char buffer[hmac::max_size];
+  for (auto _ : state) {
+    auto hash = prototype;
+    hash.update(message.data(), message.size());
+    benchmark::DoNotOptimize(hash.finish(buffer));
+  }
+}
+BENCHMARK(bench_hmac_prototype)->ThreadRange(1, 8)->UseRealTime();
+
+// compare openssl against each in-tree sha256 backend on the message sizes
+// that sign() hashes: a date, a string-to-sign and a canonical request
+static void bench_sha256_openssl(benchmark::State& state)
+{
+  const auto message = std::string(state.range(0), 'x');
+  unsigned char buffer[EVP_MAX_MD_SIZE];
+  unsigned int size = 0;
+  auto ctx = ::EVP_MD_CTX_new();
+  const auto md = ::EVP_sha256();
+  for (auto _ : state) {
+    ::EVP_DigestInit_ex(ctx, md, nullptr);
+    ::EVP_DigestUpdate(ctx, message.data(), message.size());
+    ::EVP_DigestFinal_ex(ctx, buffer, &size);
+    benchmark::DoNotOptimize(buffer);
+  }
+  ::EVP_MD_CTX_free(ctx);
+  state.SetBytesProcessed(state.iterations() * message.size());
+}
+BENCHMARK(bench_sha256_openssl)->Arg(8)->Arg(120)->Arg(400)->Arg(4096);
+
+static void bench_sha256_builtin(benchmark::State& state)
+{
+  using awssign::detail::sha256_digest;
+  using awssign::detail::sha256_backend;
+  const auto backend = static_cast<sha256_backend>(state.range(1));
+  if (!awssign::detail::sha256_supported(backend)) {
+    state.SkipWithError("backend not supported by this cpu");
+    return;
+  }
+  const auto message = std::string(state.range(0), 'x');
+  unsigned char buffer[sha256_digest::size];
+  auto hash = sha256_digest{backend};
+  for (auto _ : state) {
+    hash.init();
+    hash.update(message.data(), message.size());
+    benchmark::DoNotOptimize(hash.finish(buffer));
+  }
+  state.SetBytesProcessed(state.iterations() * message.size());
+}
+BENCHMARK(bench_sha256_builtin)
+    ->ArgNames({"size", "backend"}) // backend: 0=scalar, 1=avx2, 2=shani
+    ->ArgsProduct({{8, 120, 400, 4096}, {0, 1, 2}});
+
+// sign the string-to-sign from a keyed prototype, as sign() does
+static void bench_hmac_sha256_builtin(benchmark::State& state)
+{
+  using awssign::detail::sha256_hmac;
+  using awssign::detail::sha256_backend;
+  const auto backend = static_cast<sha256_backend>(state.range(0));
+  if (!awssign::detail::sha256_supported(backend)) {
+    state.SkipWithError("backend not supported by this cpu");
+    return;
+  }
+  const auto prototype = sha256_hmac{key, sizeof(key), backend};
+  unsigned char buffer[sha256_hmac::size];
+  for (auto _ : state) {
+    auto hash = prototype;
+    hash.update(message.data(), message.size());
+    benchmark::DoNotOptimize(hash.finish(buffer));
+  }
+}
+BENCHMARK(bench_hmac_sha256_builtin)->ArgName("backend")->DenseRange(0, 2);
+
+// hash a batch of 64 string-to-sign sized messages with each lane count.
+// items_per_second counts hashes, for comparison with bench_sha256_builtin
+static void bench_sha256_multi(benchmark::State& state)
+{
+  using awssign::detail::sha256_job;
+  const int lanes = state.range(0);
+  if (!awssign::detail::sha256_lanes_supported(lanes)) {
+    state.SkipWithError("lanes not supported by this cpu");
+    return;
+  }
+  constexpr std::size_t count = 64;
+  unsigned char digests[count][32];
+  std::vector<sha256_job> jobs;
+  for (std::size_t i = 0; i < count; i++) {
+    jobs.push_back({message.data(), message.size(), digests[i]});
+  }
+  for (auto _ : state) {
+    awssign::detail::sha256_multi(jobs.data(), jobs.data() + count, lanes);
+    benchmark::DoNotOptimize(digests);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(bench_sha256_multi)->ArgName("lanes")->Arg(4)->Arg(8)->Arg(16);
+
+// sha256, md5 and crc32c of a payload, as for x-amz-content-sha256,
+// Content-MD5 and x-amz-checksum-crc32c. the sequential passes each read the
+// whole payload, while multi_digest reads each block once
+static void bench_payload_sequential(benchmark::State& state)
+{
+  const auto payload = std::vector<char>(state.range(0), 'x');
+  unsigned char result[awssign::detail::digest::max_size];
+  for (auto _ : state) {
+    for (const char* name : {"SHA256", "MD5"}) {
+      auto hash = awssign::detail::digest{name};
+      hash.update(payload.data(), payload.size());
+      hash.finish(result);
+      benchmark::DoNotOptimize(result);
+    }
+    auto crc = awssign::detail::crc32c(0, payload.data(), payload.size());
+    benchmark::DoNotOptimize(crc);
+  }
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(bench_payload_sequential)->Arg(1 << 20)->Arg(16 << 20)->Arg(64 << 20);
+
+static void bench_payload_multi_digest(benchmark::State& state)
+{
+  using awssign::detail::payload_digest;
+  const auto payload = std::vector<char>(state.range(0), 'x');
+  unsigned char result[awssign::detail::digest::max_size];
+  for (auto _ : state) {
+    auto hash = awssign::detail::multi_digest{
+        payload_digest::sha256, payload_digest::md5, payload_digest::crc32c};
+    hash.update(payload.data(), payload.size());
+    hash.finish();
+    hash.bytes(payload_digest::sha256, result);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(bench_payload_multi_digest)->Arg(1 << 20)->Arg(16 << 20)->Arg(64 << 20);
+
+BENCHMARK_MAIN();
@@ -2,6 +2,7 @@
 #include <string>
 #include <benchmark/benchmark.h>
 #include <awssign/v4.hpp>
+#include "allocation_count.hpp"
 
 // constants that are common to each request
 constexpr const char* hash_algorithm = "SHA256";
@@ -80,6 +81,7 @@ static void bench_headers(benchmark::State& state,
                     value_lengths, value_chars, h);
   }
 
+  const std::size_t allocations = allocation_count();
   for (auto _ : state) {
     auto header = headers.begin();
     for (std::size_t request = 0; request < request_count; ++request) {
@@ -90,6 +92,9 @@ static void bench_headers(benchmark::State& state,
       header = end;
     }
   }
+  state.counters["allocs_per_sign"] = benchmark::Counter(
+      static_cast<double>(allocation_count() - allocations) / request_count,
+      benchmark::Counter::kAvgIterations);
 }
 
 const auto short_lengths = size_distribution{1, 8};
@@ -184,4 +189,177 @@ BENCHMARK_CAPTURE(bench_headers, multi_value_16,
                   std::string_view{"a"},
                   medium_lengths, alphanumeric_chars, 16);
 
+// canonicalize header values alone, without the signing around them
+static void bench_header_values(benchmark::State& state,
+                                size_distribution value_lengths,
+                                std::string_view value_chars)
+{
+  random_engine rng; // default seed
+  auto headers = std::vector<header_type>{64};
+  for (auto& h : headers) {
+    generate_header(rng, short_lengths, alphanumeric_chars,
+                    value_lengths, value_chars, h);
+  }
+  // keep the output observable, so the canonicalization isn't optimized out
+  auto writer = [] (const char* begin, const char* end) {
+    benchmark::DoNotOptimize(begin);
+    benchmark::DoNotOptimize(end);
+  };
+  for (auto _ : state) {
+    for (const auto& h : headers) {
+      const auto value = h.value();
+      awssign::v4::detail::write_canonical_header_value(
+          value.data(), value.data() + value.size(), writer);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * headers.size());
+}
+
+BENCHMARK_CAPTURE(bench_header_values, medium,
+                  medium_lengths, alphanumeric_chars);
+
+BENCHMARK_CAPTURE(bench_header_values, long,
+                  long_lengths, alphanumeric_chars);
+
+BENCHMARK_CAPTURE(bench_header_values, medium_whitespacey,
+                  medium_lengths, whitespacey_chars);
+
+BENCHMARK_CAPTURE(bench_header_values, long_whitespacey,
+                  long_lengths, whitespacey_chars);
+
+// sort and write header names alone, without the signing around them
+static void bench_header_names(benchmark::State& state,
+                               size_distribution name_lengths,
+                               std::string_view name_chars)
+{
+  using namespace awssign::v4::detail;
+  random_engine rng; // default seed
+  auto headers = std::vector<header_type>{16};
+  for (auto& h : headers) {
+    generate_header(rng, name_lengths, name_chars,
+                    short_lengths, alphanumeric_chars, h);
+  }
+  auto canonical = std::vector<canonical_header>{headers.size()};
+  auto writer = [] (const char* begin, const char* end) {
+    benchmark::DoNotOptimize(begin);
+    benchmark::DoNotOptimize(end);
+  };
+  for (auto _ : state) {
+    const auto end = sorted_canonical_headers(headers.begin(), headers.end(),
+                                              canonical.data());
+    write_canonical_headers(canonical.data(), end, writer);
+    write_signed_headers(canonical.data(), end, writer);
+  }
+  state.SetItemsProcessed(state.iterations() * headers.size());
+}
+
+BENCHMARK_CAPTURE(bench_header_names, medium_lowercase,
+                  medium_lengths, lowercase_chars);
+
+BENCHMARK_CAPTURE(bench_header_names, medium_uppercase,
+                  medium_lengths, uppercase_chars);
+
+BENCHMARK_CAPTURE(bench_header_names, long,
+                  long_lengths, alphanumeric_chars);
+
+BENCHMARK_CAPTURE(bench_header_names, long_common_prefix,
+                  // names differ only in length, so comparisons scan them
+                  long_lengths, std::string_view{"A"});
+
+// write the canonical request that verify() hashes, for a request with four
+// signed headers and the given number of unsigned ones
+static void bench_signed_headers(benchmark::State& state)
+{
+  random_engine rng; // default seed
+  auto headers = std::vector<header_type>{
+    {"Host", "bucket.s3.amazonaws.com"},
+    {"X-Amz-Date", "20150830T123600Z"},
+    {"X-Amz-Content-SHA256", "UNSIGNED-PAYLOAD"},
+    {"X-Amz-Meta-Color", "blue"},
+  };
+  for (std::size_t i = 0; i < static_cast<std::size_t>(state.range(0)); i++) {
+    generate_header(rng, medium_lengths, alphanumeric_chars,
+                    medium_lengths, alphanumeric_chars, headers.emplace_back());
+  }
+  constexpr std::string_view signed_headers =
+      "host;x-amz-content-sha256;x-amz-date;x-amz-meta-color";
+  auto writer = [] (const char* begin, const char* end) {
+    benchmark::DoNotOptimize(begin);
+    benchmark::DoNotOptimize(end);
+  };
+  for (auto _ : state) {
+    awssign::v4::detail::write_signed_canonical_request(
+        service, signed_headers, method, uri_path, query,
+        headers.begin(), headers.end(), payload_hash, writer);
+  }
+}
+BENCHMARK(bench_signed_headers)->Arg(0)->Arg(16)->Arg(64);
+
+// sort and write the canonical headers of a typical s3 request, where every
+// name is well-known
+static void bench_known_headers(benchmark::State& state)
+{
+  using namespace awssign::v4::detail;
+  const header_type headers[] = {
+    {"X-Amz-Date", "20150830T123600Z"},
+    {"X-Amz-Content-SHA256", "UNSIGNED-PAYLOAD"},
+    {"Host", "bucket.s3.amazonaws.com"},
+    {"Content-Type", "application/octet-stream"},
+    {"Content-Length", "1024"},
+    {"X-Amz-Security-Token", "token"},
+    {"X-Amz-Storage-Class", "STANDARD"},
+    {"Content-MD5", "1B2M2Y8AsgTpgAmY7PhCfg=="},
+  };
+  canonical_header canonical[std::size(headers)];
+  for (auto _ : state) {
+    const auto end = sorted_canonical_headers(std::begin(headers),
+                                              std::end(headers), canonical);
+    write_canonical_headers(canonical, end, noop_writer);
+    write_signed_headers(canonical, end, noop_writer);
+  }
+}
+BENCHMARK(bench_known_headers);
+
+// sign a typical request with mostly static headers, either sorting and
+// canonicalizing all of them or splicing the dynamic ones into a template
+static void bench_header_template(benchmark::State& state, bool use_template)
+{
+  using namespace awssign::v4;
+  const auto key = make_signing_key<sha256>(secret_access_key, date_iso8601,
+                                            region, service);
+  const header_type static_headers[] = {
+    {"Host", "bucket.s3.amazonaws.com"},
+    {"User-Agent", "aws-sdk-cpp/1.11.0 Linux/6.0 x86_64 GCC/13.2"},
+    {"Content-Type", "application/octet-stream"},
+    {"X-Amz-Security-Token", std::string(256, 'T')},
+    {"X-Amz-Meta-Color", "blue"},
+    {"X-Amz-Storage-Class", "STANDARD"},
+  };
+  const std::string_view names[] = {"X-Amz-Date", "X-Amz-Content-SHA256"};
+  const std::string_view values[] = {
+    "21010101T000000Z", "UNSIGNED-PAYLOAD"
+  };
+  const auto headers = header_template{std::begin(static_headers),
+                                       std::end(static_headers),
+                                       std::begin(names), std::end(names)};
+  auto all_headers = std::vector<header_type>{std::begin(static_headers),
+                                              std::end(static_headers)};
+  all_headers.push_back({std::string{names[0]}, std::string{values[0]}});
+  all_headers.push_back({std::string{names[1]}, std::string{values[1]}});
+  for (auto _ : state) {
+    if (use_template) {
+      sign<sha256>(access_key_id, key, method, uri_path, query,
+                   headers, values, payload_hash,
+                   date_iso8601, region, service, noop_writer);
+    } else {
+      sign<sha256>(access_key_id, key, method, uri_path, query,
+                   all_headers.begin(), all_headers.end(), payload_hash,
+                   date_iso8601, region, service, noop_writer);
+    }
+  }
+}
+
+BENCHMARK_CAPTURE(bench_header_template, sorted, false);
+BENCHMARK_CAPTURE(bench_header_template, template, true);
+
 BENCHMARK_MAIN();
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cstdint>
+#include <benchmark/benchmark.h>
+#include <awssign/detail/hex_decode.hpp>
+#include <awssign/detail/hex_encode.hpp>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define AWSSIGN_BENCH_TSC 1
+#endif
+
+// hex encoding and decoding of a sha256 digest on each backend. the
+// argument is the backend: 0 scalar, 1 ssse3, 2 avx2. on x86, the
+// cycles_per_digest counter comes from the time stamp counter, which ticks
+// at the nominal clock rate rather than counting core cycles
+
+using awssign::detail::hex_backend;
+
+static constexpr unsigned char digest[32] = {
+  0x5d, 0x67, 0x2d, 0x79, 0xc1, 0x5b, 0x13, 0x16,
+  0x2d, 0x9e, 0x7b, 0xac, 0xad, 0x0b, 0x11, 0xc9,
+  0x6a, 0x16, 0xf3, 0x3b, 0x48, 0xa4, 0xe9, 0x12,
+  0xd8, 0x25, 0x58, 0x96, 0x12, 0x07, 0xb0, 0x1a,
+};
+
+static std::uint64_t read_tsc()
+{
+#ifdef AWSSIGN_BENCH_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static void set_cycles_per_digest(benchmark::State& state,
+                                  std::uint64_t start)
+{
+#ifdef AWSSIGN_BENCH_TSC
+  state.counters["cycles_per_digest"] = benchmark::Counter(
+      static_cast<double>(read_tsc() - start),
+      benchmark::Counter::kAvgIterations);
+#endif
+}
+
+static void bench_hex_encode(benchmark::State& state)
+{
+  const auto backend = static_cast<hex_backend>(state.range(0));
+  if (!awssign::detail::hex_supported(backend)) {
+    state.SkipWithError("backend not supported");
+    return;
+  }
+  char hex[64];
+  const auto start = read_tsc();
+  for (auto _ : state) {
+    awssign::detail::hex_encode(digest, digest + sizeof(digest), hex, backend);
+    benchmark::DoNotOptimize(hex);
+  }
+  set_cycles_per_digest(state, start);
+  state.SetItemsProcessed(state.iterations()); // digests
+}
+BENCHMARK(bench_hex_encode)->DenseRange(0, 2);
+
+// the previous per-byte path, with two stream writes per input byte
+static void bench_hex_encode_per_byte(benchmark::State& state)
+{
+  char hex[64];
+  const auto start = read_tsc();
+  for (auto _ : state) {
+    char* pos = hex;
+    for (auto c : digest) {
+      awssign::detail::hex_encode(c, [&pos] (const char* begin, const char* end) {
+            pos = std::copy(begin, end, pos);
+          });
+    }
+    benchmark::DoNotOptimize(hex);
+  }
+  set_cycles_per_digest(state, start);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bench_hex_encode_per_byte);
+
+static void bench_hex_decode(benchmark::State& state)
+{
+  const auto backend = static_cast<hex_backend>(state.range(0));
+  if (!awssign::detail::hex_supported(backend)) {
+    state.SkipWithError("backend not supported");
+    return;
+  }
+  char hex[64];
+  awssign::detail::hex_encode(digest, digest + sizeof(digest), hex);
+  unsigned char decoded[32];
+  const auto start = read_tsc();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(awssign::detail::hex_decode(
+            hex, hex + sizeof(hex), decoded, backend));
+    benchmark::DoNotOptimize(decoded);
+  }
+  set_cycles_per_digest(state, start);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bench_hex_decode)->DenseRange(0, 2);
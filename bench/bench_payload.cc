@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <benchmark/benchmark.h>
+#include <awssign/v4/chunk_signer.hpp>
+#include <awssign/v4/multipart_hashes.hpp>
+#include <awssign/v4/payload_hasher.hpp>
+
+// payload hashing throughput. bytes_per_second reports GB/s for in-memory
+// bodies, and for file-backed bodies that are already in the page cache
+
+using awssign::v4::chunk_signer;
+using awssign::v4::payload_hasher;
+
+static void bench_payload_memory(benchmark::State& state)
+{
+  const auto payload = std::string(state.range(0), 'x');
+  char hex[payload_hasher::max_hex_size];
+  for (auto _ : state) {
+    auto hasher = payload_hasher{};
+    hasher.update(payload);
+    benchmark::DoNotOptimize(hasher.finish(hex));
+  }
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(bench_payload_memory)->Range(4 << 10, 64 << 20);
+
+// a temporary file of the given size, removed on destruction
+class temp_file {
+  std::FILE* file = std::tmpfile();
+ public:
+  explicit temp_file(std::size_t size) {
+    const auto chunk = std::string(1 << 20, 'x');
+    for (std::size_t n = 0; n < size; n += chunk.size()) {
+      std::fwrite(chunk.data(), 1, std::min(chunk.size(), size - n), file);
+    }
+    std::fflush(file);
+  }
+  ~temp_file() { std::fclose(file); }
+  int fd() const { return ::fileno(file); }
+};
+
+static void bench_payload_mapped(benchmark::State& state)
+{
+  const std::size_t size = state.range(0);
+  const auto file = temp_file{size};
+  char hex[payload_hasher::max_hex_size];
+  for (auto _ : state) {
+    ::lseek(file.fd(), 0, SEEK_SET);
+    auto hasher = payload_hasher{};
+    if (!hasher.update_mapped(file.fd())) {
+      state.SkipWithError("mmap failed");
+      return;
+    }
+    benchmark::DoNotOptimize(hasher.finish(hex));
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(bench_payload_mapped)->Range(4 << 10, 64 << 20);
+
+static void bench_payload_read(benchmark::State& state)
+{
+  const std::size_t size = state.range(0);
+  const auto file = temp_file{size};
+  char hex[payload_hasher::max_hex_size];
+  for (auto _ : state) {
+    ::lseek(file.fd(), 0, SEEK_SET);
+    auto hasher = payload_hasher{};
+    hasher.update_read(file.fd());
+    benchmark::DoNotOptimize(hasher.finish(hex));
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(bench_payload_read)->Range(4 << 10, 64 << 20);
+
+// sign an in-memory body as aws-chunked chunks of the given size, which
+// replaces the separate payload hash pass
+static void bench_chunk_signer(benchmark::State& state)
+{
+  const auto payload = std::string(16 << 20, 'x');
+  const std::size_t chunk_size = state.range(0);
+  const auto key = awssign::v4::make_signing_key<awssign::v4::sha256>(
+      "wJalrXUtnFEMI/K7MDENG/bPxRfiCYEXAMPLEKEY", "20130524T000000Z",
+      "us-east-1", "s3");
+  char header[chunk_signer::max_header_size];
+  for (auto _ : state) {
+    auto signer = chunk_signer{awssign::v4::sha256{}, key, "20130524T000000Z",
+                               "us-east-1", "s3", std::string(64, '0')};
+    for (std::size_t i = 0; i < payload.size(); i += chunk_size) {
+      const auto size = std::min(chunk_size, payload.size() - i);
+      benchmark::DoNotOptimize(signer.write_header(payload.data() + i, size,
+                                                   header));
+    }
+    benchmark::DoNotOptimize(signer.write_header(nullptr, 0, header));
+  }
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(bench_chunk_signer)->Range(8 << 10, 1 << 20);
+
+// a 64 MiB file in 8 MiB parts with crc32c checksums, on each pool size
+static void bench_multipart_hashes(benchmark::State& state)
+{
+  constexpr std::size_t size = 64 << 20;
+  const auto file = temp_file{size};
+  auto pool = awssign::thread_pool(state.range(0));
+  for (auto _ : state) {
+    auto hashes = awssign::v4::multipart_hashes{
+        pool, file.fd(), 8 << 20, awssign::v4::checksum_algorithm::crc32c};
+    benchmark::DoNotOptimize(hashes.composite_checksum());
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(bench_multipart_hashes)
+    ->ArgName("threads")->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+BENCHMARK_MAIN();
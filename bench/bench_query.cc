@@ -232,4 +232,62 @@ BENCHMARK_CAPTURE(bench_query, multi_value_mostly_unreserved_16,
                   std::string_view{"a"},
                   medium_lengths, mostly_unreserved_chars, 16);
 
+// canonicalize the query strings alone, without the signing around them
+static void bench_canonical_query(benchmark::State& state,
+                                  size_distribution name_lengths,
+                                  std::string_view name_chars,
+                                  size_distribution value_lengths,
+                                  std::string_view value_chars,
+                                  std::size_t params_per_request)
+{
+  random_engine rng; // default seed
+
+  constexpr std::size_t request_count = 64;
+
+  std::array<std::string, request_count> query_strings;
+  for (auto& query : query_strings) {
+    auto pos = std::back_inserter(query);
+    for (std::size_t i = 0; i < params_per_request; i++) {
+      if (i) {
+        *pos++ = '&';
+      }
+      pos = generate_param(rng, name_lengths, name_chars,
+                           value_lengths, value_chars, pos);
+    }
+  }
+  // keep the output observable, so the canonicalization isn't optimized out
+  auto writer = [] (const char* begin, const char* end) {
+    benchmark::DoNotOptimize(begin);
+    benchmark::DoNotOptimize(end);
+  };
+  for (auto _ : state) {
+    for (const auto& query : query_strings) {
+      awssign::v4::detail::write_canonical_query(
+          query.data(), query.data() + query.size(), writer);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * request_count);
+}
+
+BENCHMARK_CAPTURE(bench_canonical_query, short_unreserved_16,
+                  short_lengths, unreserved_chars,
+                  short_lengths, unreserved_chars, 16);
+
+BENCHMARK_CAPTURE(bench_canonical_query, long_unreserved_16,
+                  long_lengths, unreserved_chars,
+                  long_lengths, unreserved_chars, 16);
+
+BENCHMARK_CAPTURE(bench_canonical_query, long_mostly_reserved_16,
+                  long_lengths, mostly_reserved_chars,
+                  long_lengths, mostly_reserved_chars, 16);
+
+BENCHMARK_CAPTURE(bench_canonical_query, batch_unreserved_200,
+                  // like Entry.N.Id for sqs/sns batch calls
+                  medium_lengths, unreserved_chars,
+                  medium_lengths, unreserved_chars, 200);
+
+BENCHMARK_CAPTURE(bench_canonical_query, batch_mostly_reserved_200,
+                  medium_lengths, mostly_reserved_chars,
+                  medium_lengths, mostly_reserved_chars, 200);
+
 BENCHMARK_MAIN();
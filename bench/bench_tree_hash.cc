@@ -0,0 +1,34 @@
+#include <string>
+#include <thread>
+#include <benchmark/benchmark.h>
+#include <awssign/tree_hash.hpp>
+
+// tree hash throughput for glacier archive parts. bytes_per_second reports
+// GB/s for the serial hash and the parallel hash on a pool of the given size
+
+static void bench_tree_hash(benchmark::State& state)
+{
+  const auto payload = std::string(state.range(0), 'x');
+  unsigned char digest[awssign::tree_hash_size];
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(awssign::tree_hash(payload.data(), payload.size(),
+                                                digest));
+  }
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(bench_tree_hash)->Range(1 << 20, 64 << 20);
+
+static void bench_tree_hash_pool(benchmark::State& state)
+{
+  const auto payload = std::string(state.range(0), 'x');
+  auto pool = awssign::thread_pool(state.range(1));
+  unsigned char digest[awssign::tree_hash_size];
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(awssign::tree_hash(pool, payload.data(),
+                                                payload.size(), digest));
+  }
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(bench_tree_hash_pool)
+    ->ArgsProduct({{1 << 20, 64 << 20}, {1, 2, 4, 8}})
+    ->UseRealTime();
@@ -0,0 +1,93 @@
+#include <string>
+#include <benchmark/benchmark.h>
+#include <awssign/v4a.hpp>
+
+// SigV4a key derivation, cache lookups, signing and verification
+
+constexpr std::string_view access_key_id = "ACCESS";
+constexpr std::string_view secret_access_key = "SECRET";
+constexpr std::string_view payload_hash = "UNSIGNED-PAYLOAD";
+constexpr std::string_view date_iso8601 = "21010101T000000Z";
+constexpr std::string_view service = "service";
+
+void noop_writer(const char*, const char*) {}
+
+struct header_type {
+  std::string_view name_string() const { return name_; }
+  std::string_view value() const { return value_; }
+
+  std::string_view name_;
+  std::string_view value_;
+};
+
+const header_type headers[] = {
+  {"Host", "bucket.s3.amazonaws.com"},
+  {"X-Amz-Content-Sha256", payload_hash},
+  {"X-Amz-Date", date_iso8601},
+  {"X-Amz-Region-Set", "*"},
+};
+
+static void bench_v4a_derive_key(benchmark::State& state)
+{
+  for (auto _ : state) {
+    auto key = awssign::v4a::private_key{access_key_id, secret_access_key};
+    benchmark::DoNotOptimize(key);
+  }
+}
+BENCHMARK(bench_v4a_derive_key);
+
+static void bench_v4a_cached_key(benchmark::State& state)
+{
+  static auto cache = awssign::v4a::key_cache{1024};
+  for (auto _ : state) {
+    auto key = cache.get(access_key_id, secret_access_key);
+    benchmark::DoNotOptimize(key);
+  }
+}
+BENCHMARK(bench_v4a_cached_key)->ThreadRange(1, 8)->UseRealTime();
+
+static void bench_v4a_sign(benchmark::State& state)
+{
+  const auto key = awssign::v4a::private_key{access_key_id,
+                                             secret_access_key};
+  for (auto _ : state) {
+    awssign::v4a::sign(access_key_id, key, "PUT", "/key", "",
+                       std::begin(headers), std::end(headers), payload_hash,
+                       date_iso8601, service, noop_writer);
+  }
+}
+BENCHMARK(bench_v4a_sign);
+
+static void bench_v4a_sign_uncached(benchmark::State& state)
+{
+  for (auto _ : state) {
+    awssign::v4a::sign(access_key_id, secret_access_key, "PUT", "/key", "",
+                       std::begin(headers), std::end(headers), payload_hash,
+                       date_iso8601, service, noop_writer);
+  }
+}
+BENCHMARK(bench_v4a_sign_uncached);
+
+static void bench_v4a_verify(benchmark::State& state)
+{
+  const auto key = awssign::v4a::private_key{access_key_id,
+                                             secret_access_key};
+  std::string authorization;
+  awssign::v4a::sign(access_key_id, key, "PUT", "/key", "",
+                     std::begin(headers), std::end(headers), payload_hash,
+                     date_iso8601, service,
+                     [&] (const char* begin, const char* end) {
+                       authorization.append(begin, end);
+                     });
+  const auto signature = authorization.substr(
+      authorization.find("Signature=") + 10);
+  const auto public_key = key.public_key();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(awssign::v4a::verify(
+            date_iso8601, service,
+            "host;x-amz-content-sha256;x-amz-date;x-amz-region-set",
+            "PUT", "/key", "", std::begin(headers), std::end(headers),
+            payload_hash, public_key, signature));
+  }
+}
+BENCHMARK(bench_v4a_verify);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <awssign/detail/write.hpp>
+
+namespace awssign::detail {
+
+// write the sequence to the stream in base64-encoded form with padding
+template <typename OutputStream>
+void base64_encode(const unsigned char* begin, const unsigned char* end,
+                   OutputStream&& out)
+{
+  constexpr const char* table =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  char buffer[4];
+  for (; end - begin >= 3; begin += 3) {
+    const unsigned v = begin[0] << 16 | begin[1] << 8 | begin[2];
+    buffer[0] = table[v >> 18];
+    buffer[1] = table[(v >> 12) & 0x3f];
+    buffer[2] = table[(v >> 6) & 0x3f];
+    buffer[3] = table[v & 0x3f];
+    write(buffer, buffer + 4, out);
+  }
+  if (begin != end) {
+    const bool two = end - begin == 2;
+    const unsigned v = begin[0] << 16 | (two ? begin[1] << 8 : 0);
+    buffer[0] = table[v >> 18];
+    buffer[1] = table[(v >> 12) & 0x3f];
+    buffer[2] = two ? table[(v >> 6) & 0x3f] : '=';
+    buffer[3] = '=';
+    write(buffer, buffer + 4, out);
+  }
+}
+
+} // namespace awssign::detail
@@ -0,0 +1,439 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AWSSIGN_CRC_X86 1
+#include <immintrin.h>
+#endif
+
+namespace awssign::detail {
+
+// the reflected crcs of the x-amz-checksum-crc32, -crc32c and -crc64nvme
+// trailers. each function continues a crc from a previous result, or from 0
+enum class crc_backend {
+  scalar, // slicing-by-8 tables
+  sse42, // the crc32 instruction, for crc32c only
+  pclmul, // carry-less multiplication folding 64 bytes at a time
+};
+
+namespace crc_impl {
+
+// a polynomial in reflected bit order
+inline constexpr std::uint32_t crc32_poly = 0xedb88320;
+inline constexpr std::uint32_t crc32c_poly = 0x82f63b78;
+inline constexpr std::uint64_t crc64nvme_poly = 0x9a6c9329ac4bc9b5;
+
+// table[k][b] is the crc of byte b followed by k zero bytes
+template <typename T>
+struct tables {
+  T table[8][256] = {};
+};
+
+template <typename T>
+constexpr tables<T> make_tables(T poly)
+{
+  tables<T> t;
+  for (unsigned b = 0; b < 256; b++) {
+    T crc = b;
+    for (int i = 0; i < 8; i++) {
+      crc = (crc & 1) ? (crc >> 1) ^ poly : crc >> 1;
+    }
+    t.table[0][b] = crc;
+  }
+  for (int k = 1; k < 8; k++) {
+    for (unsigned b = 0; b < 256; b++) {
+      const T prev = t.table[k - 1][b];
+      t.table[k][b] = (prev >> 8) ^ t.table[0][prev & 0xff];
+    }
+  }
+  return t;
+}
+
+inline constexpr auto crc32_tables = make_tables<std::uint32_t>(crc32_poly);
+inline constexpr auto crc32c_tables = make_tables<std::uint32_t>(crc32c_poly);
+inline constexpr auto crc64nvme_tables =
+    make_tables<std::uint64_t>(crc64nvme_poly);
+
+[[gnu::always_inline]] inline std::uint64_t load_le64(const unsigned char* p) {
+  std::uint64_t x = 0;
+  for (int i = 7; i >= 0; i--) {
+    x = (x << 8) | p[i];
+  }
+  return x;
+}
+
+// update the crc register without the initial and final inversion
+template <typename T>
+T update_scalar(const tables<T>& t, T crc,
+                const unsigned char* p, std::size_t size)
+{
+  for (; size >= 8; size -= 8, p += 8) {
+    const std::uint64_t v = load_le64(p) ^ crc;
+    crc = t.table[7][v & 0xff] ^ t.table[6][(v >> 8) & 0xff] ^
+          t.table[5][(v >> 16) & 0xff] ^ t.table[4][(v >> 24) & 0xff] ^
+          t.table[3][(v >> 32) & 0xff] ^ t.table[2][(v >> 40) & 0xff] ^
+          t.table[1][(v >> 48) & 0xff] ^ t.table[0][v >> 56];
+  }
+  for (; size; size--, p++) {
+    crc = t.table[0][(crc ^ *p) & 0xff] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+// the bit-reflected remainder of x^n modulo a Width-bit polynomial, as the
+// 64-bit operand of a reflected carry-less multiplication
+constexpr std::uint64_t fold_constant(std::uint64_t reflected_poly,
+                                      int width, int n)
+{
+  // convert the polynomial to normal bit order
+  std::uint64_t poly = 0;
+  for (int i = 0; i < width; i++) {
+    if (reflected_poly >> i & 1) {
+      poly |= std::uint64_t{1} << (width - 1 - i);
+    }
+  }
+  const std::uint64_t mask = width == 64 ? ~std::uint64_t{0} :
+      (std::uint64_t{1} << width) - 1;
+  std::uint64_t r = 1;
+  for (int i = 0; i < n; i++) {
+    const bool carry = r >> (width - 1) & 1;
+    r = (r << 1) & mask;
+    if (carry) {
+      r ^= poly;
+    }
+  }
+  std::uint64_t reflected = 0;
+  for (int i = 0; i < 64; i++) {
+    if (r >> i & 1) {
+      reflected |= std::uint64_t{1} << (63 - i);
+    }
+  }
+  return reflected;
+}
+
+// the product of two reflected polynomials modulo the reflected polynomial
+template <typename T>
+constexpr T multiply_mod(T a, T b, T poly)
+{
+  T product = 0;
+  for (T bit = T{1} << (8 * sizeof(T) - 1); bit; bit >>= 1) {
+    if (a & bit) {
+      product ^= b;
+    }
+    b = b & 1 ? (b >> 1) ^ poly : b >> 1;
+  }
+  return product;
+}
+
+// the reflected remainder of x^n modulo the reflected polynomial
+template <typename T>
+constexpr T pow_mod(std::uint64_t n, T poly)
+{
+  T result = T{1} << (8 * sizeof(T) - 1); // x^0
+  T square = result >> 1; // x^1
+  for (; n; n >>= 1) {
+    if (n & 1) {
+      result = multiply_mod(result, square, poly);
+    }
+    square = multiply_mod(square, square, poly);
+  }
+  return result;
+}
+
+// the crc of a concatenation from the crcs of its two pieces. this works
+// because the initial and final inversions are the same
+template <typename T>
+constexpr T combine(T crc1, T crc2, std::uint64_t size2, T poly)
+{
+  return multiply_mod(pow_mod<T>(8 * size2, poly), crc1, poly) ^ crc2;
+}
+
+// constants to fold 128 bits forward by 128 or 512 bits. the reflected
+// product of two 64-bit operands comes out multiplied by x, so each
+// constant is for one less power of x
+template <typename T, T Poly>
+struct fold_constants {
+  static constexpr int width = 8 * sizeof(T);
+  static constexpr std::uint64_t k128_lo = fold_constant(Poly, width, 128 + 63);
+  static constexpr std::uint64_t k128_hi = fold_constant(Poly, width, 128 - 1);
+  static constexpr std::uint64_t k512_lo = fold_constant(Poly, width, 512 + 63);
+  static constexpr std::uint64_t k512_hi = fold_constant(Poly, width, 512 - 1);
+};
+
+inline std::uint32_t crc32_scalar(std::uint32_t crc,
+                                  const unsigned char* p, std::size_t size)
+{
+  return update_scalar(crc32_tables, crc, p, size);
+}
+
+inline std::uint32_t crc32c_scalar(std::uint32_t crc,
+                                   const unsigned char* p, std::size_t size)
+{
+  return update_scalar(crc32c_tables, crc, p, size);
+}
+
+inline std::uint64_t crc64nvme_scalar(std::uint64_t crc,
+                                      const unsigned char* p, std::size_t size)
+{
+  return update_scalar(crc64nvme_tables, crc, p, size);
+}
+
+#ifdef AWSSIGN_CRC_X86
+
+[[gnu::target("sse4.2")]]
+inline std::uint32_t crc32c_sse42(std::uint32_t crc,
+                                  const unsigned char* p, std::size_t size)
+{
+#ifdef __x86_64__
+  std::uint64_t crc64 = crc;
+  for (; size >= 8; size -= 8, p += 8) {
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    crc64 = _mm_crc32_u64(crc64, v);
+  }
+  crc = static_cast<std::uint32_t>(crc64);
+#endif
+  for (; size >= 4; size -= 4, p += 4) {
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    crc = _mm_crc32_u32(crc, v);
+  }
+  for (; size; size--, p++) {
+    crc = _mm_crc32_u8(crc, *p);
+  }
+  return crc;
+}
+
+[[gnu::target("pclmul,sse2"), gnu::always_inline]]
+inline __m128i fold(__m128i x, __m128i k, __m128i next)
+{
+  const __m128i lo = _mm_clmulepi64_si128(x, k, 0x00);
+  const __m128i hi = _mm_clmulepi64_si128(x, k, 0x11);
+  return _mm_xor_si128(_mm_xor_si128(lo, hi), next);
+}
+
+[[gnu::target("pclmul,sse2"), gnu::always_inline]]
+inline __m128i load(const unsigned char* p)
+{
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+// fold the input into one 128-bit remainder with the same crc, then reduce
+// that and the tail with the Update function. the crc register is xored
+// into the first bytes of input like the table method does
+template <typename T, T Poly, T (*Update)(T, const unsigned char*, std::size_t)>
+[[gnu::target("pclmul,sse2")]]
+T update_pclmul(T crc, const unsigned char* p, std::size_t size)
+{
+  using k = fold_constants<T, Poly>;
+  if (size < 64) {
+    return Update(crc, p, size);
+  }
+  const __m128i k128 = _mm_set_epi64x(k::k128_hi, k::k128_lo);
+  const __m128i k512 = _mm_set_epi64x(k::k512_hi, k::k512_lo);
+
+  __m128i x0 = _mm_xor_si128(load(p),
+                             _mm_set_epi64x(0, static_cast<long long>(crc)));
+  __m128i x1 = load(p + 16);
+  __m128i x2 = load(p + 32);
+  __m128i x3 = load(p + 48);
+  p += 64;
+  size -= 64;
+  for (; size >= 64; size -= 64, p += 64) {
+    x0 = fold(x0, k512, load(p));
+    x1 = fold(x1, k512, load(p + 16));
+    x2 = fold(x2, k512, load(p + 32));
+    x3 = fold(x3, k512, load(p + 48));
+  }
+  x1 = fold(x0, k128, x1);
+  x2 = fold(x1, k128, x2);
+  x3 = fold(x2, k128, x3);
+  for (; size >= 16; size -= 16, p += 16) {
+    x3 = fold(x3, k128, load(p));
+  }
+  unsigned char remainder[16];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(remainder), x3);
+  crc = Update(0, remainder, sizeof(remainder));
+  return Update(crc, p, size);
+}
+
+inline std::uint32_t crc32_pclmul(std::uint32_t crc,
+                                  const unsigned char* p, std::size_t size)
+{
+  return update_pclmul<std::uint32_t, crc32_poly, crc32_scalar>(crc, p, size);
+}
+
+[[gnu::target("sse4.2")]]
+inline std::uint32_t crc32c_pclmul(std::uint32_t crc,
+                                   const unsigned char* p, std::size_t size)
+{
+  return update_pclmul<std::uint32_t, crc32c_poly, crc32c_sse42>(crc, p, size);
+}
+
+inline std::uint64_t crc64nvme_pclmul(std::uint64_t crc,
+                                      const unsigned char* p, std::size_t size)
+{
+  return update_pclmul<std::uint64_t, crc64nvme_poly,
+                       crc64nvme_scalar>(crc, p, size);
+}
+
+#endif // AWSSIGN_CRC_X86
+
+} // namespace crc_impl
+
+// return true if the cpu supports the given backend
+inline bool crc_supported(crc_backend backend)
+{
+  switch (backend) {
+    case crc_backend::scalar:
+      return true;
+#ifdef AWSSIGN_CRC_X86
+    case crc_backend::sse42:
+      return __builtin_cpu_supports("sse4.2");
+    case crc_backend::pclmul:
+      return __builtin_cpu_supports("pclmul") &&
+          __builtin_cpu_supports("sse4.2");
+#endif
+    default:
+      return false;
+  }
+}
+
+// return the fastest backend that the cpu supports
+inline crc_backend best_crc_backend()
+{
+  static const crc_backend backend = [] {
+    if (crc_supported(crc_backend::pclmul)) {
+      return crc_backend::pclmul;
+    }
+    if (crc_supported(crc_backend::sse42)) {
+      return crc_backend::sse42;
+    }
+    return crc_backend::scalar;
+  }();
+  return backend;
+}
+
+// continue a crc32 (iso-hdlc, as in zlib) with more data
+inline std::uint32_t crc32(std::uint32_t crc, const void* data,
+                           std::size_t size,
+                           crc_backend backend = best_crc_backend())
+{
+  auto p = static_cast<const unsigned char*>(data);
+#ifdef AWSSIGN_CRC_X86
+  if (backend == crc_backend::pclmul) {
+    return ~crc_impl::crc32_pclmul(~crc, p, size);
+  }
+#endif
+  return ~crc_impl::crc32_scalar(~crc, p, size);
+}
+
+// continue a crc32c (castagnoli) with more data
+inline std::uint32_t crc32c(std::uint32_t crc, const void* data,
+                            std::size_t size,
+                            crc_backend backend = best_crc_backend())
+{
+  auto p = static_cast<const unsigned char*>(data);
+#ifdef AWSSIGN_CRC_X86
+  if (backend == crc_backend::pclmul) {
+    return ~crc_impl::crc32c_pclmul(~crc, p, size);
+  }
+  if (backend == crc_backend::sse42) {
+    return ~crc_impl::crc32c_sse42(~crc, p, size);
+  }
+#endif
+  return ~crc_impl::crc32c_scalar(~crc, p, size);
+}
+
+// continue a crc64nvme (the rocksoft polynomial) with more data
+inline std::uint64_t crc64nvme(std::uint64_t crc, const void* data,
+                               std::size_t size,
+                               crc_backend backend = best_crc_backend())
+{
+  auto p = static_cast<const unsigned char*>(data);
+#ifdef AWSSIGN_CRC_X86
+  if (backend == crc_backend::pclmul) {
+    return ~crc_impl::crc64nvme_pclmul(~crc, p, size);
+  }
+#endif
+  return ~crc_impl::crc64nvme_scalar(~crc, p, size);
+}
+
+// return the crc32 of two pieces of data, given their crc32s and the size
+// of the second piece
+inline std::uint32_t crc32_combine(std::uint32_t crc1, std::uint32_t crc2,
+                                   std::uint64_t size2)
+{
+  return crc_impl::combine(crc1, crc2, size2, crc_impl::crc32_poly);
+}
+
+// return the crc32c of two pieces of data, given their crc32cs and the size
+// of the second piece
+inline std::uint32_t crc32c_combine(std::uint32_t crc1, std::uint32_t crc2,
+                                    std::uint64_t size2)
+{
+  return crc_impl::combine(crc1, crc2, size2, crc_impl::crc32c_poly);
+}
+
+// return the crc64nvme of two pieces of data, given their crc64nvmes and the
+// size of the second piece
+inline std::uint64_t crc64nvme_combine(std::uint64_t crc1, std::uint64_t crc2,
+                                       std::uint64_t size2)
+{
+  return crc_impl::combine(crc1, crc2, size2, crc_impl::crc64nvme_poly);
+}
+
+// the crc algorithms of the x-amz-checksum-* headers
+enum class crc_algorithm {
+  crc32,
+  crc32c,
+  crc64nvme,
+};
+
+// continue a crc with more data
+inline std::uint64_t crc_update(crc_algorithm algorithm, std::uint64_t crc,
+                                const void* data, std::size_t size)
+{
+  switch (algorithm) {
+    case crc_algorithm::crc32: return crc32(crc, data, size);
+    case crc_algorithm::crc32c: return crc32c(crc, data, size);
+    case crc_algorithm::crc64nvme: return crc64nvme(crc, data, size);
+  }
+  return crc;
+}
+
+// return the crc of two pieces of data, given their crcs and the size of the
+// second piece
+inline std::uint64_t crc_combine(crc_algorithm algorithm, std::uint64_t crc1,
+                                 std::uint64_t crc2, std::uint64_t size2)
+{
+  switch (algorithm) {
+    case crc_algorithm::crc32: return crc32_combine(crc1, crc2, size2);
+    case crc_algorithm::crc32c: return crc32c_combine(crc1, crc2, size2);
+    case crc_algorithm::crc64nvme: return crc64nvme_combine(crc1, crc2, size2);
+  }
+  return crc1;
+}
+
+// the size of a crc in bytes
+constexpr std::size_t crc_size(crc_algorithm algorithm)
+{
+  return algorithm == crc_algorithm::crc64nvme ? 8 : 4;
+}
+
+// write a crc in big-endian byte order, as the x-amz-checksum-* headers
+// encode it, and return its size
+inline std::size_t crc_encode(crc_algorithm algorithm, std::uint64_t crc,
+                              unsigned char* out)
+{
+  const std::size_t size = crc_size(algorithm);
+  for (std::size_t i = 0; i < size; i++) {
+    out[i] = crc >> (8 * (size - 1 - i));
+  }
+  return size;
+}
+
+} // namespace awssign::detail
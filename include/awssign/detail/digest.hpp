@@ -1,10 +1,16 @@
 #pragma once
 
+#include <optional>
 #include <stdexcept>
 #include <utility>
 #include <openssl/err.h>
 #include <openssl/evp.h>
 #include <openssl/hmac.h>
+#include <openssl/objects.h>
+#include <awssign/detail/digest_type.hpp>
+#ifdef AWSSIGN_BUILTIN_SHA256
+#include <awssign/detail/sha256.hpp>
+#endif
 
 namespace awssign::detail {
 
@@ -19,35 +25,44 @@ auto make_digest_error(unsigned long code) {
   return digest_error{message};
 }
 
-class digest {
+// return the cached EVP_MD for the given algorithm name
+inline const ::EVP_MD* get_md(const char* digest_name)
+{
+  auto type = get_digest_type(digest_name);
+  return type ? type->md : nullptr;
+}
+
+// a digest implemented on openssl's EVP_MD interface
+class evp_digest {
   ::EVP_MD_CTX* ctx;
   const ::EVP_MD* md;
  public:
   static constexpr std::size_t max_size = EVP_MAX_MD_SIZE;
 
-  explicit digest(const char* digest_name)
-      : digest(::EVP_get_digestbyname(digest_name))
+  explicit evp_digest(const char* digest_name)
+      : evp_digest(get_md(digest_name))
+  {}
+  explicit evp_digest(const digest_type& type)
+      : evp_digest(type.md)
   {}
-  explicit digest(const EVP_MD* md)
+  explicit evp_digest(const EVP_MD* md)
       : ctx(::EVP_MD_CTX_new()), md(md) {
-    if (!ctx || !md) {
-      throw make_digest_error(::ERR_get_error());
-    }
-    if (!::EVP_DigestInit_ex(ctx, md, nullptr)) {
+    if (!ctx || !md || !::EVP_DigestInit_ex(ctx, md, nullptr)) {
+      ::EVP_MD_CTX_free(ctx);
       throw make_digest_error(::ERR_get_error());
     }
   }
-  ~digest() {
+  ~evp_digest() {
     ::EVP_MD_CTX_free(ctx);
   }
-  digest(const digest&) = delete;
-  digest& operator=(const digest&) = delete;
+  evp_digest(const evp_digest&) = delete;
+  evp_digest& operator=(const evp_digest&) = delete;
 
-  digest(digest&& o) noexcept
+  evp_digest(evp_digest&& o) noexcept
       : ctx(std::exchange(o.ctx, nullptr)),
         md(std::exchange(o.md, nullptr))
   {}
-  digest& operator=(digest&& o) {
+  evp_digest& operator=(evp_digest&& o) {
     using std::swap;
     swap(ctx, o.ctx);
     swap(md, o.md);
@@ -73,45 +88,183 @@ class digest {
   }
 };
 
-class hmac {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+
+// an hmac implemented on openssl's EVP_MAC interface
+class evp_hmac {
+  ::EVP_MAC_CTX* ctx;
+
+  static const digest_type& get_type(const char* digest_name) {
+    auto type = get_digest_type(digest_name);
+    if (!type) {
+      throw make_digest_error(::ERR_get_error());
+    }
+    return *type;
+  }
+  static const digest_type& get_type(const EVP_MD* md) {
+    return get_type(md ? ::EVP_MD_get0_name(md) : nullptr);
+  }
+ public:
+  static constexpr std::size_t max_size = EVP_MAX_MD_SIZE;
+
+  // construct without a key; a key must be provided to init() before use
+  explicit evp_hmac(const digest_type& type)
+      : ctx(::EVP_MAC_CTX_dup(type.hmac)) {
+    if (!ctx) {
+      throw make_digest_error(::ERR_get_error());
+    }
+  }
+  explicit evp_hmac(const char* digest_name)
+      : evp_hmac(get_type(digest_name))
+  {}
+  explicit evp_hmac(const EVP_MD* md)
+      : evp_hmac(get_type(md))
+  {}
+
+  evp_hmac(const digest_type& type, const unsigned char* key, int len)
+      : evp_hmac(type) {
+    init(key, len);
+  }
+  evp_hmac(const char* digest_name, const unsigned char* key, int len)
+      : evp_hmac(get_type(digest_name), key, len)
+  {}
+  evp_hmac(const EVP_MD* md, const unsigned char* key, int len)
+      : evp_hmac(get_type(md), key, len)
+  {}
+  ~evp_hmac() {
+    ::EVP_MAC_CTX_free(ctx);
+  }
+
+  // copies share the key, along with the inner and outer pad state that was
+  // hashed from it. this makes a keyed hmac a cheap prototype for repeated
+  // signatures with the same key, because the copies don't rehash the pads
+  evp_hmac(const evp_hmac& o)
+      : ctx(::EVP_MAC_CTX_dup(o.ctx)) {
+    if (!ctx) {
+      throw make_digest_error(::ERR_get_error());
+    }
+  }
+  evp_hmac& operator=(const evp_hmac& o) {
+    auto dup = ::EVP_MAC_CTX_dup(o.ctx);
+    if (!dup) {
+      throw make_digest_error(::ERR_get_error());
+    }
+    ::EVP_MAC_CTX_free(std::exchange(ctx, dup));
+    return *this;
+  }
+
+  evp_hmac(evp_hmac&& o) noexcept
+      : ctx(std::exchange(o.ctx, nullptr))
+  {}
+  evp_hmac& operator=(evp_hmac&& o) noexcept {
+    using std::swap;
+    swap(ctx, o.ctx);
+    return *this;
+  }
+
+  // reinitialize with the current key
+  void init() {
+    if (!::EVP_MAC_init(ctx, nullptr, 0, nullptr)) {
+      throw make_digest_error(::ERR_get_error());
+    }
+  }
+  // reinitialize with a new key
+  void init(const unsigned char* key, int len) {
+    if (!::EVP_MAC_init(ctx, key, len, nullptr)) {
+      throw make_digest_error(::ERR_get_error());
+    }
+  }
+  void update(const void* data, std::size_t len) {
+    auto buf = reinterpret_cast<const unsigned char*>(data);
+    if (!::EVP_MAC_update(ctx, buf, len)) {
+      throw make_digest_error(::ERR_get_error());
+    }
+  }
+  std::size_t finish(unsigned char* digest) {
+    std::size_t len = 0;
+    if (!::EVP_MAC_final(ctx, digest, &len, max_size)) {
+      throw make_digest_error(::ERR_get_error());
+    }
+    return len;
+  }
+};
+
+#else // OPENSSL_VERSION_NUMBER < 0x30000000L
+
+// an hmac implemented on openssl's HMAC_CTX interface
+class evp_hmac {
   ::HMAC_CTX* ctx;
   const ::EVP_MD* md;
  public:
   static constexpr std::size_t max_size = EVP_MAX_MD_SIZE;
 
   // construct without a key; a key must be provided to init() before use
-  explicit hmac(const char* digest_name)
-      : hmac(::EVP_get_digestbyname(digest_name))
+  explicit evp_hmac(const char* digest_name)
+      : evp_hmac(get_md(digest_name))
   {}
-  explicit hmac(const EVP_MD* md)
+  explicit evp_hmac(const digest_type& type)
+      : evp_hmac(type.md)
+  {}
+  explicit evp_hmac(const EVP_MD* md)
       : ctx(::HMAC_CTX_new()), md(md) {
     if (!ctx || !md) {
+      ::HMAC_CTX_free(ctx);
       throw make_digest_error(::ERR_get_error());
     }
     init();
   }
 
-  hmac(const char* digest_name, const unsigned char* key, int len)
-      : hmac(::EVP_get_digestbyname(digest_name), key, len)
+  evp_hmac(const char* digest_name, const unsigned char* key, int len)
+      : evp_hmac(get_md(digest_name), key, len)
   {}
-  hmac(const EVP_MD* md, const unsigned char* key, int len)
+  evp_hmac(const digest_type& type, const unsigned char* key, int len)
+      : evp_hmac(type.md, key, len)
+  {}
+  evp_hmac(const EVP_MD* md, const unsigned char* key, int len)
       : ctx(::HMAC_CTX_new()), md(md) {
     if (!ctx || !md) {
+      ::HMAC_CTX_free(ctx);
       throw make_digest_error(::ERR_get_error());
     }
     init(key, len);
   }
-  ~hmac() {
+  ~evp_hmac() {
     ::HMAC_CTX_free(ctx);
   }
-  hmac(const hmac&) = delete;
-  hmac& operator=(const hmac&) = delete;
 
-  hmac(hmac&& o) noexcept
+  // copies share the key, along with the inner and outer pad state that was
+  // hashed from it. this makes a keyed hmac a cheap prototype for repeated
+  // signatures with the same key, because the copies don't rehash the pads
+  evp_hmac(const evp_hmac& o)
+      : ctx(::HMAC_CTX_new()), md(o.md) {
+    if (!ctx) {
+      throw make_digest_error(::ERR_get_error());
+    }
+    if (!::HMAC_CTX_copy(ctx, o.ctx)) {
+      ::HMAC_CTX_free(ctx);
+      throw make_digest_error(::ERR_get_error());
+    }
+  }
+  evp_hmac& operator=(const evp_hmac& o) {
+    if (!ctx) { // moved-from
+      ctx = ::HMAC_CTX_new();
+      if (!ctx) {
+        throw make_digest_error(::ERR_get_error());
+      }
+    }
+    // reuses the existing context's digest state
+    if (!::HMAC_CTX_copy(ctx, o.ctx)) {
+      throw make_digest_error(::ERR_get_error());
+    }
+    md = o.md;
+    return *this;
+  }
+
+  evp_hmac(evp_hmac&& o) noexcept
       : ctx(std::exchange(o.ctx, nullptr)),
         md(std::exchange(o.md, nullptr))
   {}
-  hmac& operator=(hmac&& o) noexcept {
+  evp_hmac& operator=(evp_hmac&& o) noexcept {
     using std::swap;
     swap(ctx, o.ctx);
     swap(md, o.md);
@@ -144,4 +297,128 @@ class hmac {
   }
 };
 
+#endif // OPENSSL_VERSION_NUMBER < 0x30000000L
+
+#ifdef AWSSIGN_BUILTIN_SHA256
+
+inline bool is_builtin_sha256(const EVP_MD* md)
+{
+  return md && ::EVP_MD_type(md) == NID_sha256;
+}
+
+// a digest that uses the in-tree sha256_digest for SHA256, and openssl for
+// any other algorithm
+class digest {
+  std::optional<evp_digest> evp; // empty for SHA256
+  sha256_digest builtin;
+ public:
+  static constexpr std::size_t max_size = evp_digest::max_size;
+
+  explicit digest(const char* digest_name)
+      : digest(get_md(digest_name))
+  {}
+  explicit digest(const digest_type& type)
+      : digest(type.md)
+  {}
+  explicit digest(const EVP_MD* md) {
+    if (!is_builtin_sha256(md)) {
+      evp.emplace(md);
+    }
+  }
+
+  void init() {
+    if (evp) {
+      evp->init();
+    } else {
+      builtin.init();
+    }
+  }
+  void update(const void* data, std::size_t len) {
+    if (evp) {
+      evp->update(data, len);
+    } else {
+      builtin.update(data, len);
+    }
+  }
+  std::size_t finish(unsigned char* digest) {
+    return evp ? evp->finish(digest) : builtin.finish(digest);
+  }
+};
+
+// an hmac that uses the in-tree sha256_hmac for SHA256, and openssl for any
+// other algorithm
+class hmac {
+  std::optional<evp_hmac> evp; // empty for SHA256
+  sha256_hmac builtin;
+ public:
+  static constexpr std::size_t max_size = evp_hmac::max_size;
+
+  // construct without a key; a key must be provided to init() before use
+  explicit hmac(const char* digest_name)
+      : hmac(get_md(digest_name))
+  {}
+  explicit hmac(const digest_type& type) {
+    if (!is_builtin_sha256(type.md)) {
+      evp.emplace(type);
+    }
+  }
+  explicit hmac(const EVP_MD* md) {
+    if (!is_builtin_sha256(md)) {
+      evp.emplace(md);
+    }
+  }
+
+  hmac(const char* digest_name, const unsigned char* key, int len)
+      : hmac(get_md(digest_name), key, len)
+  {}
+  hmac(const digest_type& type, const unsigned char* key, int len) {
+    if (is_builtin_sha256(type.md)) {
+      builtin.init(key, len);
+    } else {
+      evp.emplace(type, key, len);
+    }
+  }
+  hmac(const EVP_MD* md, const unsigned char* key, int len) {
+    if (is_builtin_sha256(md)) {
+      builtin.init(key, len);
+    } else {
+      evp.emplace(md, key, len);
+    }
+  }
+
+  // reinitialize with the current key
+  void init() {
+    if (evp) {
+      evp->init();
+    } else {
+      builtin.init();
+    }
+  }
+  // reinitialize with a new key
+  void init(const unsigned char* key, int len) {
+    if (evp) {
+      evp->init(key, len);
+    } else {
+      builtin.init(key, len);
+    }
+  }
+  void update(const void* data, std::size_t len) {
+    if (evp) {
+      evp->update(data, len);
+    } else {
+      builtin.update(data, len);
+    }
+  }
+  std::size_t finish(unsigned char* digest) {
+    return evp ? evp->finish(digest) : builtin.finish(digest);
+  }
+};
+
+#else // !AWSSIGN_BUILTIN_SHA256
+
+using digest = evp_digest;
+using hmac = evp_hmac;
+
+#endif // !AWSSIGN_BUILTIN_SHA256
+
 } // namespace awssign::detail
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <openssl/evp.h>
+#include <openssl/opensslv.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#endif
+
+namespace awssign::detail {
+
+// the openssl handles for a hash algorithm, resolved once by name
+struct digest_type {
+  const ::EVP_MD* md = nullptr;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  // an unkeyed hmac context for this digest. hmacs are created by duplicating
+  // this context, which avoids the digest fetch in EVP_MAC_CTX_set_params()
+  ::EVP_MAC_CTX* hmac = nullptr;
+#endif
+};
+
+// a process-wide registry of digest_types. lookups walk an append-only list
+// without taking any locks, so they don't contend across threads. only the
+// first lookup of each name takes the mutex to fetch the algorithm
+class digest_registry {
+  struct node {
+    std::string name;
+    digest_type type;
+    const node* next;
+  };
+  std::atomic<const node*> head = nullptr;
+  std::mutex mutex; // serializes inserts
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  ::EVP_MAC* mac = nullptr; // HMAC
+#endif
+
+  static const node* find(const node* n, std::string_view name) {
+    for (; n; n = n->next) {
+      if (n->name == name) {
+        return n;
+      }
+    }
+    return nullptr;
+  }
+
+  // resolve the algorithm, or return an empty digest_type on failure
+  digest_type fetch(const char* name) {
+    digest_type type;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    auto md = ::EVP_MD_fetch(nullptr, name, nullptr);
+    if (!md) {
+      return type;
+    }
+    if (!mac) {
+      mac = ::EVP_MAC_fetch(nullptr, "HMAC", nullptr);
+    }
+    auto ctx = mac ? ::EVP_MAC_CTX_new(mac) : nullptr;
+    if (!ctx) {
+      ::EVP_MD_free(md);
+      return type;
+    }
+    const ::OSSL_PARAM params[] = {
+      ::OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST,
+                                         const_cast<char*>(name), 0),
+      ::OSSL_PARAM_construct_end()
+    };
+    if (!::EVP_MAC_CTX_set_params(ctx, params)) {
+      ::EVP_MAC_CTX_free(ctx);
+      ::EVP_MD_free(md);
+      return type;
+    }
+    type.md = md;
+    type.hmac = ctx;
+#else
+    type.md = ::EVP_get_digestbyname(name);
+#endif
+    return type;
+  }
+ public:
+  digest_registry() = default;
+  ~digest_registry() {
+    auto n = head.load(std::memory_order_acquire);
+    while (n) {
+      auto next = n->next;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+      ::EVP_MAC_CTX_free(n->type.hmac);
+      ::EVP_MD_free(const_cast<::EVP_MD*>(n->type.md));
+#endif
+      delete n;
+      n = next;
+    }
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    ::EVP_MAC_free(mac);
+#endif
+  }
+  digest_registry(const digest_registry&) = delete;
+  digest_registry& operator=(const digest_registry&) = delete;
+
+  // return the digest_type for the given name, or nullptr if the algorithm
+  // is not available
+  const digest_type* get(const char* name) {
+    if (!name) {
+      return nullptr;
+    }
+    if (auto n = find(head.load(std::memory_order_acquire), name); n) {
+      return &n->type;
+    }
+    auto lock = std::scoped_lock{mutex};
+    auto first = head.load(std::memory_order_relaxed);
+    if (auto n = find(first, name); n) { // raced with another insert
+      return &n->type;
+    }
+    const auto type = fetch(name);
+    if (!type.md) { // don't cache failures
+      return nullptr;
+    }
+    auto n = new node{name, type, first};
+    head.store(n, std::memory_order_release);
+    return &n->type;
+  }
+
+  static digest_registry& instance() {
+    static digest_registry registry;
+    return registry;
+  }
+};
+
+// return the cached digest_type for the given algorithm name, or nullptr if
+// the algorithm is not available
+inline const digest_type* get_digest_type(const char* name)
+{
+  return digest_registry::instance().get(name);
+}
+
+} // namespace awssign::detail
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <awssign/detail/hex_encode.hpp>
+
+namespace awssign::detail {
+
+// return the value of a lowercase hex digit, or -1. signatures are always
+// encoded in lowercase, so uppercase digits are rejected
+inline int hex_digit(char c)
+{
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  } else if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+namespace hex_impl {
+
+inline bool decode_scalar(const char* p, std::size_t count, unsigned char* out)
+{
+  for (std::size_t i = 0; i < count; i++) {
+    const int hi = hex_digit(p[2 * i]);
+    const int lo = hex_digit(p[2 * i + 1]);
+    if (hi < 0 || lo < 0) {
+      return false;
+    }
+    out[i] = (hi << 4) | lo;
+  }
+  return true;
+}
+
+#ifdef AWSSIGN_HEX_X86
+
+// convert 16 characters to their nibble values in each byte, and clear
+// 'valid' if any of them isn't a lowercase hex digit. bytes are compared as
+// signed, so characters above 0x7f land outside both ranges
+[[gnu::target("ssse3")]]
+inline __m128i nibbles(__m128i c, __m128i& valid)
+{
+  const __m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+  const __m128i alpha = _mm_sub_epi8(c, _mm_set1_epi8('a'));
+  const __m128i is_digit = _mm_and_si128(
+      _mm_cmpgt_epi8(digit, _mm_set1_epi8(-1)),
+      _mm_cmplt_epi8(digit, _mm_set1_epi8(10)));
+  const __m128i is_alpha = _mm_and_si128(
+      _mm_cmpgt_epi8(alpha, _mm_set1_epi8(-1)),
+      _mm_cmplt_epi8(alpha, _mm_set1_epi8(6)));
+  valid = _mm_and_si128(valid, _mm_or_si128(is_digit, is_alpha));
+  return _mm_or_si128(
+      _mm_and_si128(is_digit, digit),
+      _mm_and_si128(is_alpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+}
+
+// combine each pair of nibbles into one byte in the low half of its pair
+[[gnu::target("ssse3")]]
+inline __m128i pairs(__m128i n)
+{
+  return _mm_maddubs_epi16(n, _mm_set1_epi16(0x0110));
+}
+
+// decode 32 characters at a time into 16 bytes
+[[gnu::target("ssse3")]]
+inline bool decode_ssse3(const char* p, std::size_t count, unsigned char* out)
+{
+  __m128i valid = _mm_set1_epi8(-1);
+  for (; count >= 16; count -= 16, p += 32, out += 16) {
+    const __m128i lo = nibbles(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), valid);
+    const __m128i hi = nibbles(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16)), valid);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                     _mm_packus_epi16(pairs(lo), pairs(hi)));
+  }
+  if (_mm_movemask_epi8(valid) != 0xffff) {
+    return false;
+  }
+  return decode_scalar(p, count, out);
+}
+
+[[gnu::target("avx2")]]
+inline __m256i nibbles(__m256i c, __m256i& valid)
+{
+  const __m256i digit = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+  const __m256i alpha = _mm256_sub_epi8(c, _mm256_set1_epi8('a'));
+  const __m256i is_digit = _mm256_andnot_si256(
+      _mm256_cmpgt_epi8(_mm256_setzero_si256(),  digit),
+      _mm256_cmpgt_epi8(_mm256_set1_epi8(10), digit));
+  const __m256i is_alpha = _mm256_andnot_si256(
+      _mm256_cmpgt_epi8(_mm256_setzero_si256(), alpha),
+      _mm256_cmpgt_epi8(_mm256_set1_epi8(6), alpha));
+  valid = _mm256_and_si256(valid, _mm256_or_si256(is_digit, is_alpha));
+  return _mm256_or_si256(
+      _mm256_and_si256(is_digit, digit),
+      _mm256_and_si256(is_alpha, _mm256_add_epi8(alpha, _mm256_set1_epi8(10))));
+}
+
+// decode 64 characters at a time into 32 bytes
+[[gnu::target("avx2")]]
+inline bool decode_avx2(const char* p, std::size_t count, unsigned char* out)
+{
+  __m256i valid = _mm256_set1_epi8(-1);
+  const __m256i weights = _mm256_set1_epi16(0x0110);
+  for (; count >= 32; count -= 32, p += 64, out += 32) {
+    const __m256i lo = nibbles(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), valid);
+    const __m256i hi = nibbles(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32)), valid);
+    // pack works within each 128-bit lane, so put the quarters back in order
+    const __m256i packed = _mm256_packus_epi16(
+        _mm256_maddubs_epi16(lo, weights), _mm256_maddubs_epi16(hi, weights));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+                        _mm256_permute4x64_epi64(packed, 0xd8));
+  }
+  if (_mm256_movemask_epi8(valid) != -1) {
+    return false;
+  }
+  return decode_ssse3(p, count, out);
+}
+
+#endif // AWSSIGN_HEX_X86
+
+} // namespace hex_impl
+
+// decode an even number of lowercase hex digits into (end - begin) / 2
+// bytes. returns false if the length is odd or any character isn't a
+// lowercase hex digit, in which case the output is unspecified
+inline bool hex_decode(const char* begin, const char* end, unsigned char* out,
+                       hex_backend backend = best_hex_backend())
+{
+  const std::size_t size = end - begin;
+  if (size % 2) {
+    return false;
+  }
+#ifdef AWSSIGN_HEX_X86
+  if (backend == hex_backend::avx2) {
+    return hex_impl::decode_avx2(begin, size / 2, out);
+  }
+  if (backend == hex_backend::ssse3) {
+    return hex_impl::decode_ssse3(begin, size / 2, out);
+  }
+#endif
+  return hex_impl::decode_scalar(begin, size / 2, out);
+}
+
+} // namespace awssign::detail
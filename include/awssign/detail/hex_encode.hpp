@@ -1,12 +1,118 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdio>
 #include <numeric>
 #include <awssign/detail/write.hpp>
 #include <awssign/detail/transform.hpp>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AWSSIGN_HEX_X86 1
+#include <immintrin.h>
+#endif
+
 namespace awssign::detail {
 
+// the kernels of hex_encode() and hex_decode() into contiguous buffers
+enum class hex_backend {
+  scalar, // a byte at a time
+  ssse3, // 16 bytes at a time, with pshufb table lookups to encode
+  avx2, // 32 bytes at a time
+};
+
+// return true if the cpu supports the given backend
+inline bool hex_supported(hex_backend backend)
+{
+  switch (backend) {
+    case hex_backend::scalar:
+      return true;
+#ifdef AWSSIGN_HEX_X86
+    case hex_backend::ssse3:
+      return __builtin_cpu_supports("ssse3");
+    case hex_backend::avx2:
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+// return the fastest backend that the cpu supports
+inline hex_backend best_hex_backend()
+{
+  static const hex_backend backend = [] {
+    if (hex_supported(hex_backend::avx2)) {
+      return hex_backend::avx2;
+    }
+    if (hex_supported(hex_backend::ssse3)) {
+      return hex_backend::ssse3;
+    }
+    return hex_backend::scalar;
+  }();
+  return backend;
+}
+
+namespace hex_impl {
+
+inline constexpr char digits[] = "0123456789abcdef";
+
+inline char* encode_scalar(const unsigned char* p, std::size_t size,
+                           char* out)
+{
+  for (std::size_t i = 0; i < size; i++) {
+    *out++ = digits[p[i] >> 4];
+    *out++ = digits[p[i] & 0xf];
+  }
+  return out;
+}
+
+#ifdef AWSSIGN_HEX_X86
+
+[[gnu::target("ssse3")]]
+inline char* encode_ssse3(const unsigned char* p, std::size_t size, char* out)
+{
+  const __m128i table = _mm_loadu_si128(
+      reinterpret_cast<const __m128i*>(digits));
+  const __m128i mask = _mm_set1_epi8(0xf);
+  for (; size >= 16; size -= 16, p += 16, out += 32) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i hi = _mm_shuffle_epi8(
+        table, _mm_and_si128(_mm_srli_epi16(x, 4), mask));
+    const __m128i lo = _mm_shuffle_epi8(table, _mm_and_si128(x, mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                     _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16),
+                     _mm_unpackhi_epi8(hi, lo));
+  }
+  return encode_scalar(p, size, out);
+}
+
+[[gnu::target("avx2")]]
+inline char* encode_avx2(const unsigned char* p, std::size_t size, char* out)
+{
+  const __m256i table = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+      reinterpret_cast<const __m128i*>(digits)));
+  const __m256i mask = _mm256_set1_epi8(0xf);
+  for (; size >= 32; size -= 32, p += 32, out += 64) {
+    const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i hi = _mm256_shuffle_epi8(
+        table, _mm256_and_si256(_mm256_srli_epi16(x, 4), mask));
+    const __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(x, mask));
+    // unpack works within each 128-bit lane, so put the lanes back in order
+    const __m256i a = _mm256_unpacklo_epi8(hi, lo); // bytes 0-7, 16-23
+    const __m256i b = _mm256_unpackhi_epi8(hi, lo); // bytes 8-15, 24-31
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+                        _mm256_permute2x128_si256(a, b, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 32),
+                        _mm256_permute2x128_si256(a, b, 0x31));
+  }
+  return encode_ssse3(p, size, out);
+}
+
+#endif // AWSSIGN_HEX_X86
+
+} // namespace hex_impl
+
 // lowercase base16 character encoding
 template <typename OutputStream>
 void hex_encode(unsigned char c, OutputStream&& out)
@@ -16,14 +122,36 @@ void hex_encode(unsigned char c, OutputStream&& out)
   write(table[c & 0xf], out); // low 4 bits
 }
 
-// write the sequence to the stream in hex-encoded form
+// write the sequence in hex-encoded form to a buffer of at least twice its
+// size, and return the end of the output
+inline char* hex_encode(const unsigned char* begin, const unsigned char* end,
+                        char* out, hex_backend backend = best_hex_backend())
+{
+  const std::size_t size = end - begin;
+#ifdef AWSSIGN_HEX_X86
+  if (backend == hex_backend::avx2) {
+    return hex_impl::encode_avx2(begin, size, out);
+  }
+  if (backend == hex_backend::ssse3) {
+    return hex_impl::encode_ssse3(begin, size, out);
+  }
+#endif
+  return hex_impl::encode_scalar(begin, size, out);
+}
+
+// write the sequence to the stream in hex-encoded form. the input is encoded
+// in blocks, so the stream sees one write per block instead of two per byte
 template <typename OutputStream>
 void hex_encode(const unsigned char* begin, const unsigned char* end,
                 OutputStream&& out)
 {
-  transform(begin, end, [] (unsigned char c, auto out) {
-      return hex_encode(c, out);
-    }, out);
+  constexpr std::size_t block_size = 64;
+  char buffer[2 * block_size];
+  while (begin != end) {
+    const std::size_t count = std::min<std::size_t>(end - begin, block_size);
+    write(buffer, hex_encode(begin, begin + count, buffer), out);
+    begin += count;
+  }
 }
 
 } // namespace awssign::detail
@@ -1,9 +1,18 @@
 #pragma once
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iterator>
+#include <string_view>
 #include <awssign/detail/write.hpp>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AWSSIGN_LOWER_CASE_X86 1
+#include <immintrin.h>
+#endif
+
 namespace awssign::detail {
 
 constexpr inline char to_lower(char c) {
@@ -16,6 +25,292 @@ constexpr inline void to_lower(char* out, const char* in, std::size_t count) {
   }
 }
 
+// return the first 8 bytes of the string in lower case, packed big-endian
+// and padded with zeroes. comparing two prefixes as integers orders them
+// like their strings, except that equal prefixes need a full comparison
+inline std::uint64_t lower_case_prefix(std::string_view str)
+{
+  std::uint64_t x = 0;
+  if (str.empty()) {
+    return x;
+  }
+  std::memcpy(&x, str.data(), std::min<std::size_t>(str.size(), 8));
+  // set 0x20 in each byte from 'A' to 'Z', eight bytes at a time
+  constexpr std::uint64_t ones = 0x0101010101010101;
+  const std::uint64_t low7 = x & (0x7f * ones);
+  const std::uint64_t above_a = low7 + (0x80 - 'A') * ones;
+  const std::uint64_t above_z = low7 + (0x80 - 'Z' - 1) * ones;
+  const std::uint64_t upper = (above_a ^ above_z) & ~x & (0x80 * ones);
+  x |= upper >> 2;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  x = __builtin_bswap64(x);
+#endif
+  return x;
+}
+
+// the kernels of find_upper(), lower_case() and lower_case_mismatch()
+enum class lower_case_backend {
+  scalar, // a byte at a time
+  avx2, // 32 bytes at a time
+  avx512, // 64 bytes at a time, with masked loads for the tail
+};
+
+// return true if the cpu supports the given backend
+inline bool lower_case_supported(lower_case_backend backend)
+{
+  switch (backend) {
+    case lower_case_backend::scalar:
+      return true;
+#ifdef AWSSIGN_LOWER_CASE_X86
+    case lower_case_backend::avx2:
+      return __builtin_cpu_supports("avx2");
+    case lower_case_backend::avx512:
+      return __builtin_cpu_supports("avx512bw");
+#endif
+    default:
+      return false;
+  }
+}
+
+// return the fastest backend that the cpu supports
+inline lower_case_backend best_lower_case_backend()
+{
+  static const lower_case_backend backend = [] {
+    if (lower_case_supported(lower_case_backend::avx512)) {
+      return lower_case_backend::avx512;
+    }
+    if (lower_case_supported(lower_case_backend::avx2)) {
+      return lower_case_backend::avx2;
+    }
+    return lower_case_backend::scalar;
+  }();
+  return backend;
+}
+
+namespace lower_case_impl {
+
+inline bool upper(char c)
+{
+  return 'A' <= c && c <= 'Z';
+}
+
+inline std::size_t find_upper_scalar(const char* p, std::size_t count)
+{
+  return std::find_if(p, p + count, upper) - p;
+}
+
+inline void lower_case_scalar(char* out, const char* in, std::size_t count)
+{
+  to_lower(out, in, count);
+}
+
+// return the first position where l and r differ after lowering the sides
+// selected by FoldL and FoldR
+template <bool FoldL, bool FoldR>
+std::size_t mismatch_scalar(const char* l, const char* r, std::size_t count)
+{
+  std::size_t i = 0;
+  for (; i < count; i++) {
+    const char a = FoldL ? to_lower(l[i]) : l[i];
+    const char b = FoldR ? to_lower(r[i]) : r[i];
+    if (a != b) {
+      break;
+    }
+  }
+  return i;
+}
+
+#ifdef AWSSIGN_LOWER_CASE_X86
+
+// set each byte of the result to 0xff where c is in 'A'..'Z'
+[[gnu::target("avx2")]]
+inline __m256i upper_avx2(__m256i c)
+{
+  const __m256i offset = _mm256_sub_epi8(c, _mm256_set1_epi8('A'));
+  return _mm256_cmpeq_epi8(
+      _mm256_min_epu8(offset, _mm256_set1_epi8('Z' - 'A')), offset);
+}
+
+[[gnu::target("avx2")]]
+inline __m256i lower_avx2(__m256i c)
+{
+  return _mm256_or_si256(c, _mm256_and_si256(upper_avx2(c),
+                                             _mm256_set1_epi8(0x20)));
+}
+
+[[gnu::target("avx2")]]
+inline __m256i load_avx2(const char* p)
+{
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+[[gnu::target("avx2")]]
+inline std::size_t find_upper_avx2(const char* p, std::size_t count)
+{
+  std::size_t i = 0;
+  for (; count - i >= 32; i += 32) {
+    const unsigned mask = _mm256_movemask_epi8(upper_avx2(load_avx2(p + i)));
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i + find_upper_scalar(p + i, count - i);
+}
+
+[[gnu::target("avx2")]]
+inline void lower_case_avx2(char* out, const char* in, std::size_t count)
+{
+  std::size_t i = 0;
+  for (; count - i >= 32; i += 32) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        lower_avx2(load_avx2(in + i)));
+  }
+  lower_case_scalar(out + i, in + i, count - i);
+}
+
+template <bool FoldL, bool FoldR>
+[[gnu::target("avx2")]]
+std::size_t mismatch_avx2(const char* l, const char* r, std::size_t count)
+{
+  std::size_t i = 0;
+  for (; count - i >= 32; i += 32) {
+    __m256i a = load_avx2(l + i);
+    __m256i b = load_avx2(r + i);
+    if constexpr (FoldL) {
+      a = lower_avx2(a);
+    }
+    if constexpr (FoldR) {
+      b = lower_avx2(b);
+    }
+    const unsigned equal = _mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
+    if (equal != 0xffffffff) {
+      return i + __builtin_ctz(~equal);
+    }
+  }
+  return i + mismatch_scalar<FoldL, FoldR>(l + i, r + i, count - i);
+}
+
+// load up to 64 bytes, without reading past the end of the input
+[[gnu::target("avx512bw")]]
+inline __m512i load_avx512(const char* p, std::size_t count, __mmask64& mask)
+{
+  mask = count >= 64 ? ~__mmask64{0} : (__mmask64{1} << count) - 1;
+  return _mm512_maskz_loadu_epi8(mask, p);
+}
+
+[[gnu::target("avx512bw")]]
+inline __mmask64 upper_avx512(__m512i c)
+{
+  return _mm512_cmple_epu8_mask(_mm512_sub_epi8(c, _mm512_set1_epi8('A')),
+                                _mm512_set1_epi8('Z' - 'A'));
+}
+
+[[gnu::target("avx512bw")]]
+inline __m512i lower_avx512(__m512i c)
+{
+  return _mm512_mask_add_epi8(c, upper_avx512(c), c, _mm512_set1_epi8(0x20));
+}
+
+[[gnu::target("avx512bw")]]
+inline std::size_t find_upper_avx512(const char* p, std::size_t count)
+{
+  for (std::size_t i = 0; i < count; i += 64) {
+    __mmask64 valid;
+    const __m512i c = load_avx512(p + i, count - i, valid);
+    const __mmask64 mask = upper_avx512(c) & valid;
+    if (mask) {
+      return i + __builtin_ctzll(mask);
+    }
+  }
+  return count;
+}
+
+[[gnu::target("avx512bw")]]
+inline void lower_case_avx512(char* out, const char* in, std::size_t count)
+{
+  for (std::size_t i = 0; i < count; i += 64) {
+    __mmask64 valid;
+    const __m512i c = load_avx512(in + i, count - i, valid);
+    _mm512_mask_storeu_epi8(out + i, valid, lower_avx512(c));
+  }
+}
+
+template <bool FoldL, bool FoldR>
+[[gnu::target("avx512bw")]]
+std::size_t mismatch_avx512(const char* l, const char* r, std::size_t count)
+{
+  for (std::size_t i = 0; i < count; i += 64) {
+    __mmask64 valid;
+    __m512i a = load_avx512(l + i, count - i, valid);
+    __m512i b = load_avx512(r + i, count - i, valid);
+    if constexpr (FoldL) {
+      a = lower_avx512(a);
+    }
+    if constexpr (FoldR) {
+      b = lower_avx512(b);
+    }
+    const __mmask64 differ = _mm512_cmpneq_epi8_mask(a, b) & valid;
+    if (differ) {
+      return i + __builtin_ctzll(differ);
+    }
+  }
+  return count;
+}
+
+#endif // AWSSIGN_LOWER_CASE_X86
+
+} // namespace lower_case_impl
+
+// return the position of the first uppercase character, or count if the
+// input is already lower case
+inline std::size_t find_upper(const char* p, std::size_t count,
+                              lower_case_backend backend = best_lower_case_backend())
+{
+#ifdef AWSSIGN_LOWER_CASE_X86
+  if (backend == lower_case_backend::avx512) {
+    return lower_case_impl::find_upper_avx512(p, count);
+  }
+  if (backend == lower_case_backend::avx2) {
+    return lower_case_impl::find_upper_avx2(p, count);
+  }
+#endif
+  return lower_case_impl::find_upper_scalar(p, count);
+}
+
+// write the input to out in lower case
+inline void lower_case(char* out, const char* in, std::size_t count,
+                       lower_case_backend backend = best_lower_case_backend())
+{
+#ifdef AWSSIGN_LOWER_CASE_X86
+  if (backend == lower_case_backend::avx512) {
+    lower_case_impl::lower_case_avx512(out, in, count);
+    return;
+  }
+  if (backend == lower_case_backend::avx2) {
+    lower_case_impl::lower_case_avx2(out, in, count);
+    return;
+  }
+#endif
+  lower_case_impl::lower_case_scalar(out, in, count);
+}
+
+// return the first position where l and r differ, after lowering the sides
+// selected by FoldL and FoldR, or count if they're equal
+template <bool FoldL, bool FoldR>
+std::size_t lower_case_mismatch(const char* l, const char* r, std::size_t count,
+                                lower_case_backend backend = best_lower_case_backend())
+{
+#ifdef AWSSIGN_LOWER_CASE_X86
+  if (backend == lower_case_backend::avx512) {
+    return lower_case_impl::mismatch_avx512<FoldL, FoldR>(l, r, count);
+  }
+  if (backend == lower_case_backend::avx2) {
+    return lower_case_impl::mismatch_avx2<FoldL, FoldR>(l, r, count);
+  }
+#endif
+  return lower_case_impl::mismatch_scalar<FoldL, FoldR>(l, r, count);
+}
+
 // a case-converting string_view wrapper
 class lower_case_string {
   std::string_view value;
@@ -95,15 +390,82 @@ class lower_case_string {
   const_reverse_iterator crend() const { return value.crend(); }
 };
 
-// comparisons between lower_case_string and std::string_view
+namespace lower_case_impl {
+
+// inputs shorter than this are handled inline without the kernels, whose
+// setup costs more than they save
+inline constexpr std::size_t short_size = 32;
+
+template <bool Fold>
+unsigned char fold(char c)
+{
+  // compare bytes as unsigned, like std::string_view
+  return Fold ? to_lower(c) : c;
+}
+
+// most names differ within their first few characters, so compare those
+// inline before calling the kernel for the rest
+inline constexpr std::size_t prefix_size = 16;
+
+// compare the rest of the names with the kernel. kept out of line so the
+// comparison operators stay small enough to inline into the sort
+template <bool FoldL, bool FoldR>
+[[gnu::noinline]] std::size_t mismatch_rest(const char* l, const char* r,
+                                            std::size_t count)
+{
+  return lower_case_mismatch<FoldL, FoldR>(l, r, count);
+}
+
+template <bool FoldL, bool FoldR>
+bool equal(std::string_view l, std::string_view r)
+{
+  if (l.size() != r.size()) {
+    return false;
+  }
+  const std::size_t count = l.size();
+  std::size_t i = 0;
+  for (; i < count && i < prefix_size; i++) {
+    if (fold<FoldL>(l[i]) != fold<FoldR>(r[i])) {
+      return false;
+    }
+  }
+  return i == count || mismatch_rest<FoldL, FoldR>(
+      l.data() + i, r.data() + i, count - i) == count - i;
+}
+
+template <bool FoldL, bool FoldR>
+bool less(std::string_view l, std::string_view r)
+{
+  const std::size_t count = std::min(l.size(), r.size());
+  std::size_t i = 0;
+  for (; i < count && i < prefix_size; i++) {
+    const auto a = fold<FoldL>(l[i]);
+    const auto b = fold<FoldR>(r[i]);
+    if (a != b) {
+      return a < b;
+    }
+  }
+  if (i != count) {
+    i += mismatch_rest<FoldL, FoldR>(l.data() + i, r.data() + i, count - i);
+    if (i != count) {
+      return fold<FoldL>(l[i]) < fold<FoldR>(r[i]);
+    }
+  }
+  return l.size() < r.size();
+}
+
+} // namespace lower_case_impl
+
+// comparisons between lower_case_string and std::string_view. these lower
+// case a block at a time instead of through const_iterator
 inline bool operator==(lower_case_string l, lower_case_string r) {
-  return std::equal(l.begin(), l.end(), r.begin(), r.end());
+  return lower_case_impl::equal<true, true>(l, r);
 }
 inline bool operator==(lower_case_string l, std::string_view r) {
-  return std::equal(l.begin(), l.end(), r.begin(), r.end());
+  return lower_case_impl::equal<true, false>(l, r);
 }
 inline bool operator==(std::string_view l, lower_case_string r) {
-  return std::equal(l.begin(), l.end(), r.begin(), r.end());
+  return lower_case_impl::equal<false, true>(l, r);
 }
 
 inline bool operator!=(lower_case_string l, lower_case_string r) {
@@ -117,13 +479,13 @@ inline bool operator!=(std::string_view l, lower_case_string r) {
 }
 
 inline bool operator<(lower_case_string l, lower_case_string r) {
-  return std::lexicographical_compare(l.begin(), l.end(), r.begin(), r.end());
+  return lower_case_impl::less<true, true>(l, r);
 }
 inline bool operator<(lower_case_string l, std::string_view r) {
-  return std::lexicographical_compare(l.begin(), l.end(), r.begin(), r.end());
+  return lower_case_impl::less<true, false>(l, r);
 }
 inline bool operator<(std::string_view l, lower_case_string r) {
-  return std::lexicographical_compare(l.begin(), l.end(), r.begin(), r.end());
+  return lower_case_impl::less<false, true>(l, r);
 }
 
 inline bool operator<=(lower_case_string l, lower_case_string r) {
@@ -137,13 +499,13 @@ inline bool operator<=(std::string_view l, lower_case_string r) {
 }
 
 inline bool operator>(lower_case_string l, lower_case_string r) {
-  return std::lexicographical_compare(r.begin(), r.end(), l.begin(), l.end());
+  return lower_case_impl::less<true, true>(r, l);
 }
 inline bool operator>(lower_case_string l, std::string_view r) {
-  return std::lexicographical_compare(r.begin(), r.end(), l.begin(), l.end());
+  return lower_case_impl::less<false, true>(r, l);
 }
 inline bool operator>(std::string_view l, lower_case_string r) {
-  return std::lexicographical_compare(r.begin(), r.end(), l.begin(), l.end());
+  return lower_case_impl::less<true, false>(r, l);
 }
 
 inline bool operator>=(lower_case_string l, lower_case_string r) {
@@ -165,18 +527,29 @@ class lower_case_stream {
   explicit lower_case_stream(OutputStream& out) : out(out) {}
 
   void operator()(const char* begin, const char* end) {
-    char buffer[buffer_size];
     std::size_t input_remaining = std::distance(begin, end);
+    if (input_remaining < lower_case_impl::short_size) {
+      char buffer[lower_case_impl::short_size];
+      to_lower(buffer, begin, input_remaining);
+      write(buffer, buffer + input_remaining, out);
+      return;
+    }
+    if (find_upper(begin, input_remaining) == input_remaining) {
+      // already lower case, so pass it through without copying
+      write(begin, end, out);
+      return;
+    }
+    char buffer[buffer_size];
     while (input_remaining > buffer_size) {
       constexpr auto count = buffer_size;
-      to_lower(buffer, begin, count);
+      lower_case(buffer, begin, count);
       write(buffer, buffer + count, out);
 
       input_remaining -= count;
       begin += count;
     }
     const std::size_t count = input_remaining;
-    to_lower(buffer, begin, count);
+    lower_case(buffer, begin, count);
     write(buffer, buffer + count, out);
   }
 };
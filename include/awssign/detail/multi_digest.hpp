@@ -0,0 +1,133 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <optional>
+#include <awssign/detail/base64_encode.hpp>
+#include <awssign/detail/crc.hpp>
+#include <awssign/detail/digest.hpp>
+#include <awssign/detail/hex_encode.hpp>
+#include <awssign/detail/output_stream.hpp>
+
+namespace awssign::detail {
+
+// the algorithms of the payload headers: x-amz-content-sha256 (hex),
+// Content-MD5 (base64) and the x-amz-checksum-* headers (base64)
+enum class payload_digest {
+  sha256,
+  md5,
+  sha1,
+  crc32,
+  crc32c,
+  crc64nvme,
+};
+
+// computes several payload digests in one pass over the data. the input is
+// fed to every algorithm one block at a time, so each block is read from
+// memory once and stays in the l1 cache for the remaining algorithms
+//
+// example:
+//
+//   auto hash = multi_digest{payload_digest::sha256, payload_digest::md5};
+//   hash.update(data, size);
+//   hash.finish();
+//   char sha256[multi_digest::max_hex_size];
+//   const auto sha256_size = hash.hex(payload_digest::sha256, sha256);
+//   char md5[multi_digest::max_base64_size];
+//   const auto md5_size = hash.base64(payload_digest::md5, md5);
+//
+class multi_digest {
+  static constexpr int count = 6;
+  std::optional<digest> hashes[3]; // sha256, md5, sha1
+  bool crc_enabled[3] = {}; // indexed by crc_algorithm
+  std::uint64_t crcs[3] = {};
+  unsigned char results[count][digest::max_size];
+  std::size_t result_sizes[count] = {};
+
+  static int index(payload_digest algorithm) {
+    return static_cast<int>(algorithm);
+  }
+  static const char* digest_name(int i) {
+    constexpr const char* names[] = {"SHA256", "MD5", "SHA1"};
+    return names[i];
+  }
+ public:
+  // each algorithm processes this much input before the next one starts
+  static constexpr std::size_t block_size = 16 * 1024;
+  static constexpr std::size_t max_hex_size = 2 * digest::max_size;
+  static constexpr std::size_t max_base64_size = 4 * digest::max_size / 3 + 4;
+
+  explicit multi_digest(std::initializer_list<payload_digest> algorithms) {
+    for (auto algorithm : algorithms) {
+      const int i = index(algorithm);
+      if (i < 3) {
+        if (!hashes[i]) {
+          hashes[i].emplace(digest_name(i));
+        }
+      } else {
+        crc_enabled[i - 3] = true;
+      }
+    }
+  }
+
+  void update(const void* data, std::size_t size) {
+    auto p = static_cast<const unsigned char*>(data);
+    while (size) {
+      const std::size_t n = std::min(size, block_size);
+      for (auto& hash : hashes) {
+        if (hash) {
+          hash->update(p, n);
+        }
+      }
+      for (int i = 0; i < 3; i++) {
+        if (crc_enabled[i]) {
+          crcs[i] = crc_update(crc_algorithm(i), crcs[i], p, n);
+        }
+      }
+      p += n;
+      size -= n;
+    }
+  }
+
+  // finish every digest. the results are then available from bytes(), hex()
+  // and base64()
+  void finish() {
+    for (int i = 0; i < 3; i++) {
+      if (hashes[i]) {
+        result_sizes[i] = hashes[i]->finish(results[i]);
+      }
+    }
+    for (int i = 0; i < 3; i++) {
+      if (crc_enabled[i]) {
+        result_sizes[3 + i] = crc_encode(crc_algorithm(i), crcs[i],
+                                         results[3 + i]);
+      }
+    }
+  }
+
+  // return the raw digest, or an empty result if it wasn't requested
+  std::size_t bytes(payload_digest algorithm, unsigned char* out) const {
+    const int i = index(algorithm);
+    return std::distance(out, std::copy_n(results[i], result_sizes[i], out));
+  }
+
+  // write the hex-encoded digest, and return the number of characters
+  std::size_t hex(payload_digest algorithm, char* out) const {
+    const int i = index(algorithm);
+    char* pos = hex_encode(results[i], results[i] + result_sizes[i], out);
+    return std::distance(out, pos);
+  }
+
+  // write the base64-encoded digest, and return the number of characters
+  std::size_t base64(payload_digest algorithm, char* out) const {
+    const int i = index(algorithm);
+    char* pos = out;
+    base64_encode(results[i], results[i] + result_sizes[i],
+                  output_stream{pos});
+    return std::distance(out, pos);
+  }
+};
+
+} // namespace awssign::detail
@@ -23,7 +23,7 @@ inline char percent_decode(char c)
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 224-239
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 240-255
   };
-  return table[c];
+  return table[static_cast<unsigned char>(c)];
 }
 
 inline char percent_decode(char c1, char c2)
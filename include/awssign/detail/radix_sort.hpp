@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+#include <utility>
+
+namespace awssign::detail {
+
+// ranges up to this size are sorted by comparison
+inline constexpr std::size_t radix_sort_threshold = 64;
+
+namespace radix_sort_impl {
+
+// bucket 0 holds the keys that end before depth, and the rest are ordered by
+// the byte at depth
+inline std::size_t bucket(std::string_view key, std::size_t depth)
+{
+  if (depth >= key.size()) {
+    return 0;
+  }
+  return 1 + static_cast<unsigned char>(key[depth]);
+}
+
+template <typename T, typename Key>
+void sort(T* first, T* last, T* scratch, const Key& key, std::size_t depth)
+{
+  constexpr std::size_t bucket_count = 257;
+  for (;;) {
+    const std::size_t size = last - first;
+    if (size <= radix_sort_threshold) {
+      // the first depth bytes are equal, so compare the rest
+      std::sort(first, last, [&key, depth] (const T& l, const T& r) {
+          return key(l).substr(depth) < key(r).substr(depth);
+        });
+      return;
+    }
+    // count the keys in each bucket, then turn the counts into offsets
+    std::size_t offsets[bucket_count + 1] = {};
+    for (auto i = first; i != last; ++i) {
+      ++offsets[bucket(key(*i), depth) + 1];
+    }
+    std::size_t largest = 0;
+    std::size_t largest_size = 0;
+    for (std::size_t b = 0; b < bucket_count; b++) {
+      if (offsets[b + 1] > largest_size) {
+        largest = b;
+        largest_size = offsets[b + 1];
+      }
+      offsets[b + 1] += offsets[b];
+    }
+    if (largest_size == size) {
+      if (largest == 0) {
+        return; // the keys are all equal
+      }
+      // skip a common prefix without recursing
+      ++depth;
+      continue;
+    }
+    // scatter into the scratch buffer. afterwards, offsets[b] is the end of
+    // bucket b
+    for (auto i = first; i != last; ++i) {
+      scratch[offsets[bucket(key(*i), depth)]++] = std::move(*i);
+    }
+    std::move(scratch, scratch + size, first);
+
+    // recurse into the smaller buckets, which are at most half the range, and
+    // loop on the largest. bucket 0 is already sorted
+    for (std::size_t b = 1; b < bucket_count; b++) {
+      const std::size_t begin = offsets[b - 1];
+      const std::size_t end = offsets[b];
+      if (b != largest && end - begin > 1) {
+        sort(first + begin, first + end, scratch, key, depth + 1);
+      }
+    }
+    if (largest == 0) {
+      return;
+    }
+    last = first + offsets[largest];
+    first = first + offsets[largest - 1];
+    ++depth;
+  }
+}
+
+} // namespace radix_sort_impl
+
+// an unstable msd radix sort of the elements by key(element), a
+// std::string_view, in byte order. ranges up to radix_sort_threshold are
+// sorted by comparison, and larger ones need a scratch buffer of at least
+// (last - first) elements
+template <typename T, typename Key>
+void radix_sort(T* first, T* last, T* scratch, Key key)
+{
+  radix_sort_impl::sort(first, last, scratch, key, 0);
+}
+
+} // namespace awssign::detail
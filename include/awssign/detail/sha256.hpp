@@ -0,0 +1,352 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AWSSIGN_SHA256_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace awssign::detail {
+
+// compress a number of 64-byte blocks into the 8-word sha256 state
+using sha256_blocks_fn = void (*)(std::uint32_t* state,
+                                  const unsigned char* data,
+                                  std::size_t blocks);
+
+enum class sha256_backend {
+  scalar, // portable c++
+  avx2, // portable c++, compiled for avx2 and bmi2 (rorx)
+  shani, // x86 sha extensions
+};
+
+namespace sha256_impl {
+
+alignas(16) inline constexpr std::uint32_t k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+  0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+  0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+  0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+  0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+  0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+inline constexpr std::uint32_t initial_state[8] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+  0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+[[gnu::always_inline]] inline std::uint32_t rotr(std::uint32_t x, int n) {
+  return (x >> n) | (x << (32 - n));
+}
+
+[[gnu::always_inline]] inline std::uint32_t load_be32(const unsigned char* p) {
+  return std::uint32_t(p[0]) << 24 | std::uint32_t(p[1]) << 16 |
+         std::uint32_t(p[2]) << 8 | std::uint32_t(p[3]);
+}
+
+[[gnu::always_inline]] inline void store_be32(std::uint32_t x, unsigned char* p) {
+  p[0] = x >> 24;
+  p[1] = x >> 16;
+  p[2] = x >> 8;
+  p[3] = x;
+}
+
+// the portable compression function. it's inlined into each backend so the
+// compiler can schedule it for that backend's instruction set
+[[gnu::always_inline]] inline void blocks_generic(std::uint32_t* state,
+                                                  const unsigned char* data,
+                                                  std::size_t blocks)
+{
+  for (; blocks; blocks--, data += 64) {
+    std::uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+      w[i] = load_be32(data + 4 * i);
+    }
+    for (int i = 16; i < 64; i++) {
+      const auto s0 = rotr(w[i-15], 7) ^ rotr(w[i-15], 18) ^ (w[i-15] >> 3);
+      const auto s1 = rotr(w[i-2], 17) ^ rotr(w[i-2], 19) ^ (w[i-2] >> 10);
+      w[i] = w[i-16] + s0 + w[i-7] + s1;
+    }
+    auto a = state[0], b = state[1], c = state[2], d = state[3];
+    auto e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+      const auto s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+      const auto ch = (e & f) ^ (~e & g);
+      const auto t1 = h + s1 + ch + k[i] + w[i];
+      const auto s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+      const auto maj = (a & b) ^ (a & c) ^ (b & c);
+      const auto t2 = s0 + maj;
+      h = g; g = f; f = e; e = d + t1;
+      d = c; c = b; b = a; a = t1 + t2;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+  }
+}
+
+inline void blocks_scalar(std::uint32_t* state, const unsigned char* data,
+                          std::size_t blocks)
+{
+  blocks_generic(state, data, blocks);
+}
+
+#ifdef AWSSIGN_SHA256_X86
+
+[[gnu::target("avx2,bmi2")]]
+inline void blocks_avx2(std::uint32_t* state, const unsigned char* data,
+                        std::size_t blocks)
+{
+  blocks_generic(state, data, blocks);
+}
+
+[[gnu::target("sha,sse4.1")]]
+inline void blocks_shani(std::uint32_t* state, const unsigned char* data,
+                         std::size_t blocks)
+{
+  const auto mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+                                   0x0405060700010203ULL);
+  // load the state as ABEF and CDGH, which is what sha256rnds2 expects
+  auto tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state));
+  auto state1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4));
+  tmp = _mm_shuffle_epi32(tmp, 0xb1); // CDAB
+  state1 = _mm_shuffle_epi32(state1, 0x1b); // EFGH
+  auto state0 = _mm_alignr_epi8(tmp, state1, 8); // ABEF
+  state1 = _mm_blend_epi16(state1, tmp, 0xf0); // CDGH
+
+  for (; blocks; blocks--, data += 64) {
+    const auto abef = state0;
+    const auto cdgh = state1;
+    __m128i msg[4];
+#pragma GCC unroll 16
+    for (int i = 0; i < 16; i++) {
+      auto& m = msg[i % 4];
+      if (i < 4) {
+        m = _mm_shuffle_epi8(_mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(data + 16 * i)), mask);
+      } else {
+        // W[t] = W[t-16] + s0(W[t-15]) + W[t-7] + s1(W[t-2])
+        const auto& prev = msg[(i + 3) % 4];
+        m = _mm_sha256msg1_epu32(m, msg[(i + 1) % 4]);
+        m = _mm_add_epi32(m, _mm_alignr_epi8(prev, msg[(i + 2) % 4], 4));
+        m = _mm_sha256msg2_epu32(m, prev);
+      }
+      auto wk = _mm_add_epi32(m, _mm_load_si128(
+              reinterpret_cast<const __m128i*>(k + 4 * i)));
+      state1 = _mm_sha256rnds2_epu32(state1, state0, wk);
+      wk = _mm_shuffle_epi32(wk, 0x0e);
+      state0 = _mm_sha256rnds2_epu32(state0, state1, wk);
+    }
+    state0 = _mm_add_epi32(state0, abef);
+    state1 = _mm_add_epi32(state1, cdgh);
+  }
+
+  tmp = _mm_shuffle_epi32(state0, 0x1b); // FEBA
+  state1 = _mm_shuffle_epi32(state1, 0xb1); // DCHG
+  state0 = _mm_blend_epi16(tmp, state1, 0xf0); // DCBA
+  state1 = _mm_alignr_epi8(state1, tmp, 8); // HGFE
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state), state0);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), state1);
+}
+
+inline bool cpu_has_sha()
+{
+  unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+  return (ebx & bit_SHA) && __builtin_cpu_supports("sse4.1");
+}
+
+#endif // AWSSIGN_SHA256_X86
+
+} // namespace sha256_impl
+
+// return true if the cpu supports the given backend
+inline bool sha256_supported(sha256_backend backend)
+{
+  switch (backend) {
+    case sha256_backend::scalar:
+      return true;
+#ifdef AWSSIGN_SHA256_X86
+    case sha256_backend::avx2:
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2");
+    case sha256_backend::shani:
+      return sha256_impl::cpu_has_sha();
+#endif
+    default:
+      return false;
+  }
+}
+
+// return the compression function for the given backend, which must be
+// supported by the cpu
+inline sha256_blocks_fn get_sha256_blocks(sha256_backend backend)
+{
+  switch (backend) {
+#ifdef AWSSIGN_SHA256_X86
+    case sha256_backend::avx2:
+      return sha256_impl::blocks_avx2;
+    case sha256_backend::shani:
+      return sha256_impl::blocks_shani;
+#endif
+    default:
+      return sha256_impl::blocks_scalar;
+  }
+}
+
+// return the fastest backend that the cpu supports
+inline sha256_backend best_sha256_backend()
+{
+  static const auto backend = [] {
+    if (sha256_supported(sha256_backend::shani)) {
+      return sha256_backend::shani;
+    }
+    if (sha256_supported(sha256_backend::avx2)) {
+      return sha256_backend::avx2;
+    }
+    return sha256_backend::scalar;
+  }();
+  return backend;
+}
+
+// an in-tree sha256 digest with the same interface as digest. this avoids
+// the overhead of the EVP layer, which dominates for short messages
+class sha256_digest {
+  std::uint32_t state[8];
+  std::uint64_t length; // total bytes hashed
+  unsigned char buffer[64]; // partial block
+  sha256_blocks_fn blocks;
+
+  friend class sha256_hmac;
+ public:
+  static constexpr std::size_t size = 32;
+  static constexpr std::size_t block_size = 64;
+
+  explicit sha256_digest(sha256_backend backend = best_sha256_backend())
+      : blocks(get_sha256_blocks(backend)) {
+    init();
+  }
+
+  void init() {
+    init(sha256_impl::initial_state, 0);
+  }
+  // resume from an intermediate state after a whole number of blocks
+  void init(const std::uint32_t* s, std::uint64_t len) {
+    std::memcpy(state, s, sizeof(state));
+    length = len;
+  }
+  void update(const void* data, std::size_t len) {
+    auto p = static_cast<const unsigned char*>(data);
+    const std::size_t buffered = length % block_size;
+    length += len;
+    if (buffered) {
+      const std::size_t count = std::min(len, block_size - buffered);
+      std::memcpy(buffer + buffered, p, count);
+      if (buffered + count < block_size) {
+        return;
+      }
+      blocks(state, buffer, 1);
+      p += count;
+      len -= count;
+    }
+    if (len >= block_size) {
+      blocks(state, p, len / block_size);
+      p += len & ~(block_size - 1);
+      len &= block_size - 1;
+    }
+    std::memcpy(buffer, p, len);
+  }
+  std::size_t finish(unsigned char* digest) {
+    // pad with 0x80, zeroes, then the 64-bit big-endian bit length
+    std::size_t buffered = length % block_size;
+    buffer[buffered++] = 0x80;
+    if (buffered > block_size - 8) {
+      std::memset(buffer + buffered, 0, block_size - buffered);
+      blocks(state, buffer, 1);
+      buffered = 0;
+    }
+    std::memset(buffer + buffered, 0, block_size - 8 - buffered);
+    const std::uint64_t bits = length * 8;
+    sha256_impl::store_be32(bits >> 32, buffer + block_size - 8);
+    sha256_impl::store_be32(bits, buffer + block_size - 4);
+    blocks(state, buffer, 1);
+    for (int i = 0; i < 8; i++) {
+      sha256_impl::store_be32(state[i], digest + 4 * i);
+    }
+    return size;
+  }
+};
+
+// an in-tree hmac-sha256 with the same interface as hmac. the inner and outer
+// pad states are saved, so init() and copies don't rehash the key
+class sha256_hmac {
+  std::uint32_t inner_state[8]; // after the inner pad
+  std::uint32_t outer_state[8]; // after the outer pad
+  sha256_digest inner;
+ public:
+  static constexpr std::size_t size = sha256_digest::size;
+
+  explicit sha256_hmac(sha256_backend backend = best_sha256_backend())
+      : inner(backend) {
+    init(nullptr, 0);
+  }
+  sha256_hmac(const unsigned char* key, int len,
+              sha256_backend backend = best_sha256_backend())
+      : inner(backend) {
+    init(key, len);
+  }
+
+  // the intermediate states after hashing the inner and outer pads
+  const std::uint32_t* inner_pad_state() const { return inner_state; }
+  const std::uint32_t* outer_pad_state() const { return outer_state; }
+
+  // reinitialize with the current key
+  void init() {
+    inner.init(inner_state, sha256_digest::block_size);
+  }
+  // reinitialize with a new key
+  void init(const unsigned char* key, int len) {
+    constexpr auto block_size = sha256_digest::block_size;
+    unsigned char pad[block_size] = {};
+    if (static_cast<std::size_t>(len) > block_size) {
+      inner.init();
+      inner.update(key, len);
+      inner.finish(pad);
+    } else if (len > 0) {
+      std::memcpy(pad, key, len);
+    }
+    for (auto& c : pad) { c ^= 0x36; }
+    std::memcpy(inner_state, sha256_impl::initial_state, sizeof(inner_state));
+    inner.blocks(inner_state, pad, 1);
+    for (auto& c : pad) { c ^= 0x36 ^ 0x5c; }
+    std::memcpy(outer_state, sha256_impl::initial_state, sizeof(outer_state));
+    inner.blocks(outer_state, pad, 1);
+    init();
+  }
+  void update(const void* data, std::size_t len) {
+    inner.update(data, len);
+  }
+  std::size_t finish(unsigned char* digest) {
+    unsigned char inner_digest[size];
+    inner.finish(inner_digest);
+    inner.init(outer_state, sha256_digest::block_size);
+    inner.update(inner_digest, size);
+    return inner.finish(digest);
+  }
+};
+
+} // namespace awssign::detail
@@ -0,0 +1,277 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <awssign/detail/sha256.hpp>
+
+namespace awssign::detail {
+
+// a message for the multi-buffer sha256 engine
+struct sha256_job {
+  const void* data;
+  std::size_t size;
+  unsigned char* digest; // receives sha256_digest::size bytes
+  // resume from an intermediate state, or start from the initial state if null
+  const std::uint32_t* state = nullptr;
+  std::uint64_t prefix = 0; // bytes already hashed into state, a multiple of 64
+};
+
+// compress one 64-byte block in each of the lanes. the state is stored word
+// by word, so state[word * Lanes + lane] is word 'word' of lane 'lane'
+using sha256_lanes_fn = void (*)(std::uint32_t* state,
+                                 const unsigned char* const* blocks);
+
+namespace sha256_mb_impl {
+
+template <int Lanes>
+struct vector {
+  typedef std::uint32_t type __attribute__((vector_size(4 * Lanes)));
+};
+
+// a macro rather than a function, because passing wide vectors by value to a
+// function without the matching target attribute changes the abi
+#define AWSSIGN_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+// run the portable compression function on a vector of independent states.
+// gcc lowers the vector operations to the instruction set of the caller
+template <int Lanes>
+[[gnu::always_inline]] inline void blocks_lanes(std::uint32_t* state,
+                                                const unsigned char* const* blocks)
+{
+  using V = typename vector<Lanes>::type;
+  V s[8];
+  std::memcpy(s, state, sizeof(s));
+
+  // transpose each lane's big-endian words into vectors
+  V w[16];
+  for (int i = 0; i < 16; i++) {
+    for (int lane = 0; lane < Lanes; lane++) {
+      w[i][lane] = sha256_impl::load_be32(blocks[lane] + 4 * i);
+    }
+  }
+
+  V a = s[0], b = s[1], c = s[2], d = s[3];
+  V e = s[4], f = s[5], g = s[6], h = s[7];
+  for (int i = 0; i < 64; i++) {
+    if (i >= 16) { // extend the message schedule in a ring of 16 words
+      const V w15 = w[(i - 15) & 15];
+      const V w2 = w[(i - 2) & 15];
+      const V s0 = AWSSIGN_ROTR(w15, 7) ^ AWSSIGN_ROTR(w15, 18) ^ (w15 >> 3);
+      const V s1 = AWSSIGN_ROTR(w2, 17) ^ AWSSIGN_ROTR(w2, 19) ^ (w2 >> 10);
+      w[i & 15] += s0 + w[(i - 7) & 15] + s1;
+    }
+    const V s1 = AWSSIGN_ROTR(e, 6) ^ AWSSIGN_ROTR(e, 11) ^ AWSSIGN_ROTR(e, 25);
+    const V ch = (e & f) ^ (~e & g);
+    const V t1 = h + s1 + ch + sha256_impl::k[i] + w[i & 15];
+    const V s0 = AWSSIGN_ROTR(a, 2) ^ AWSSIGN_ROTR(a, 13) ^ AWSSIGN_ROTR(a, 22);
+    const V maj = (a & b) ^ (a & c) ^ (b & c);
+    const V t2 = s0 + maj;
+    h = g; g = f; f = e; e = d + t1;
+    d = c; c = b; b = a; a = t1 + t2;
+  }
+  s[0] += a; s[1] += b; s[2] += c; s[3] += d;
+  s[4] += e; s[5] += f; s[6] += g; s[7] += h;
+  std::memcpy(state, s, sizeof(s));
+}
+
+#undef AWSSIGN_ROTR
+
+inline void blocks_x4(std::uint32_t* state, const unsigned char* const* blocks)
+{
+  blocks_lanes<4>(state, blocks); // sse2 on x86-64
+}
+
+#ifdef AWSSIGN_SHA256_X86
+
+[[gnu::target("avx2")]]
+inline void blocks_x8(std::uint32_t* state, const unsigned char* const* blocks)
+{
+  blocks_lanes<8>(state, blocks);
+}
+
+[[gnu::target("avx512f")]]
+inline void blocks_x16(std::uint32_t* state, const unsigned char* const* blocks)
+{
+  blocks_lanes<16>(state, blocks);
+}
+
+#endif // AWSSIGN_SHA256_X86
+
+// a job's progress in a lane. the job's whole blocks are read in place, and
+// its last partial block and padding are copied into 'tail'
+struct lane {
+  sha256_job* job = nullptr;
+  std::size_t block = 0; // index of the next block
+  std::size_t whole_blocks = 0; // blocks read from job->data
+  std::size_t total_blocks = 0; // whole_blocks + tail blocks
+  unsigned char tail[128];
+
+  void start(sha256_job* j) {
+    job = j;
+    block = 0;
+    whole_blocks = j->size / 64;
+    const std::size_t remainder = j->size % 64;
+    std::memcpy(tail, static_cast<const unsigned char*>(j->data) + 64 * whole_blocks,
+                remainder);
+    tail[remainder] = 0x80;
+    const std::size_t tail_size = remainder + 9 > 64 ? 128 : 64;
+    std::memset(tail + remainder + 1, 0, tail_size - remainder - 9);
+    const std::uint64_t bits = (j->prefix + j->size) * 8;
+    sha256_impl::store_be32(bits >> 32, tail + tail_size - 8);
+    sha256_impl::store_be32(bits, tail + tail_size - 4);
+    total_blocks = whole_blocks + tail_size / 64;
+  }
+  const unsigned char* next() const {
+    if (block < whole_blocks) {
+      return static_cast<const unsigned char*>(job->data) + 64 * block;
+    }
+    return tail + 64 * (block - whole_blocks);
+  }
+};
+
+// feed jobs through the lanes, refilling each lane as soon as its job
+// finishes so that lanes stay busy when message lengths differ
+template <int Lanes>
+void run(sha256_job* begin, sha256_job* end, sha256_lanes_fn blocks)
+{
+  std::uint32_t state[8 * Lanes];
+  lane lanes[Lanes];
+  const unsigned char* next[Lanes];
+  static constexpr unsigned char idle[64] = {};
+
+  auto start = [&] (int i, sha256_job* job) {
+    lanes[i].start(job);
+    const auto s = job->state ? job->state : sha256_impl::initial_state;
+    for (int word = 0; word < 8; word++) {
+      state[word * Lanes + i] = s[word];
+    }
+  };
+
+  int active = 0;
+  for (int i = 0; i < Lanes; i++) {
+    if (begin != end) {
+      start(i, begin++);
+      active++;
+    }
+  }
+  while (active) {
+    for (int i = 0; i < Lanes; i++) {
+      next[i] = lanes[i].job ? lanes[i].next() : idle;
+    }
+    blocks(state, next);
+    for (int i = 0; i < Lanes; i++) {
+      auto& l = lanes[i];
+      if (!l.job || ++l.block < l.total_blocks) {
+        continue;
+      }
+      for (int word = 0; word < 8; word++) {
+        sha256_impl::store_be32(state[word * Lanes + i],
+                                l.job->digest + 4 * word);
+      }
+      if (begin != end) {
+        start(i, begin++);
+      } else {
+        l.job = nullptr;
+        active--;
+      }
+    }
+  }
+}
+
+} // namespace sha256_mb_impl
+
+// return the widest lane count that the cpu supports
+inline int best_sha256_lanes()
+{
+#ifdef AWSSIGN_SHA256_X86
+  static const int lanes = __builtin_cpu_supports("avx512f") ? 16 :
+                           __builtin_cpu_supports("avx2") ? 8 : 4;
+  return lanes;
+#else
+  return 4;
+#endif
+}
+
+// return true if the cpu supports the given lane count
+inline bool sha256_lanes_supported(int lanes)
+{
+  return lanes == 4 || (lanes > 4 && lanes <= best_sha256_lanes() &&
+                        (lanes == 8 || lanes == 16));
+}
+
+// hash a batch of independent messages with the multi-buffer engine, using
+// the given number of lanes
+inline void sha256_multi(sha256_job* begin, sha256_job* end, int lanes)
+{
+  switch (lanes) {
+#ifdef AWSSIGN_SHA256_X86
+    case 16:
+      return sha256_mb_impl::run<16>(begin, end, sha256_mb_impl::blocks_x16);
+    case 8:
+      return sha256_mb_impl::run<8>(begin, end, sha256_mb_impl::blocks_x8);
+#endif
+    default:
+      return sha256_mb_impl::run<4>(begin, end, sha256_mb_impl::blocks_x4);
+  }
+}
+
+// hash a batch of independent messages. a single message doesn't fill any
+// lanes, so it's hashed with the single-buffer sha256_digest instead. the sha
+// extensions keep up with 8 lanes, so they're only beaten by 16
+inline void sha256_multi(sha256_job* begin, sha256_job* end)
+{
+  static const bool multi = best_sha256_lanes() == 16 ||
+      best_sha256_backend() != sha256_backend::shani;
+  if (multi && std::distance(begin, end) > 1) {
+    return sha256_multi(begin, end, best_sha256_lanes());
+  }
+  for (; begin != end; ++begin) {
+    auto hash = sha256_digest{};
+    if (begin->state) {
+      hash.init(begin->state, begin->prefix);
+    }
+    hash.update(begin->data, begin->size);
+    hash.finish(begin->digest);
+  }
+}
+
+// an hmac message for the multi-buffer engine
+struct sha256_hmac_job {
+  const sha256_hmac* key; // a keyed hmac whose pad states are used
+  const void* data;
+  std::size_t size;
+  unsigned char* digest; // receives sha256_hmac::size bytes
+};
+
+// sign a batch of independent messages with the multi-buffer engine. the
+// inner hashes resume from each key's inner pad state, then the outer hashes
+// resume from the outer pad states
+inline void sha256_hmac_multi(sha256_hmac_job* begin, sha256_hmac_job* end)
+{
+  constexpr std::size_t batch_size = 64;
+  constexpr std::size_t size = sha256_digest::size;
+  constexpr std::size_t block_size = sha256_digest::block_size;
+  sha256_job jobs[batch_size];
+  unsigned char inner_digests[batch_size][size];
+
+  while (begin != end) {
+    const std::size_t count = std::min<std::size_t>(
+        std::distance(begin, end), batch_size);
+    for (std::size_t i = 0; i < count; i++) {
+      const auto& j = begin[i];
+      jobs[i] = sha256_job{j.data, j.size, inner_digests[i],
+                           j.key->inner_pad_state(), block_size};
+    }
+    sha256_multi(jobs, jobs + count);
+    for (std::size_t i = 0; i < count; i++) {
+      const auto& j = begin[i];
+      jobs[i] = sha256_job{inner_digests[i], size, j.digest,
+                           j.key->outer_pad_state(), block_size};
+    }
+    sha256_multi(jobs, jobs + count);
+    begin += count;
+  }
+}
+
+} // namespace awssign::detail
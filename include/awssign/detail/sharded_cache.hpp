@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <openssl/crypto.h>
+#include <awssign/detail/sha256.hpp>
+
+namespace awssign::detail {
+
+// caches are keyed on a sha256 of the inputs to a key derivation, so they
+// never hold the secrets themselves
+using cache_key = std::array<unsigned char, sha256_digest::size>;
+
+// hash the '\0'-separated parts, and clear the hash state afterwards
+inline cache_key make_cache_key(std::initializer_list<std::string_view> parts)
+{
+  auto hash = sha256_digest{};
+  bool first = true;
+  for (const auto& part : parts) {
+    if (!first) {
+      hash.update("", 1);
+    }
+    first = false;
+    hash.update(part.data(), part.size());
+  }
+  cache_key result;
+  hash.finish(result.data());
+  ::OPENSSL_cleanse(&hash, sizeof(hash));
+  return result;
+}
+
+// a bounded, thread-safe cache of shared values. entries are spread over
+// independently-locked shards to limit contention between threads, and each
+// shard evicts entries with the CLOCK algorithm once it reaches capacity.
+// values are created and destroyed outside of the shard locks
+template <typename Value>
+class sharded_cache {
+  struct entry {
+    cache_key key;
+    std::shared_ptr<const Value> value;
+    bool referenced;
+  };
+  // pad shards out to separate cache lines
+  struct alignas(64) shard {
+    std::mutex mutex;
+    std::vector<entry> entries;
+    std::size_t hand = 0; // CLOCK hand
+  };
+  std::unique_ptr<shard[]> shards;
+  std::size_t shard_count;
+  std::size_t shard_capacity;
+
+  static entry* find(shard& s, const cache_key& key)
+  {
+    for (auto& e : s.entries) {
+      if (e.key == key) {
+        return &e;
+      }
+    }
+    return nullptr;
+  }
+
+  // return the entry to overwrite, advancing the CLOCK hand past any entries
+  // that were referenced since its last pass
+  static entry& evict(shard& s)
+  {
+    for (;;) {
+      entry& e = s.entries[s.hand];
+      s.hand = (s.hand + 1) % s.entries.size();
+      if (!e.referenced) {
+        return e;
+      }
+      e.referenced = false;
+    }
+  }
+ public:
+  // construct a cache that holds up to 'capacity' values, divided evenly
+  // between 'shard_count' shards
+  sharded_cache(std::size_t capacity, std::size_t shard_count)
+      : shards(std::make_unique<shard[]>(std::max<std::size_t>(shard_count, 1))),
+        shard_count(std::max<std::size_t>(shard_count, 1)),
+        shard_capacity(std::max<std::size_t>(
+                (capacity + this->shard_count - 1) / this->shard_count, 1))
+  {}
+
+  // return the value for the given key. on a cache miss, the value is
+  // created with make() and inserted into the cache
+  template <typename Make>
+  std::shared_ptr<const Value> get(const cache_key& key, Make&& make)
+  {
+    std::size_t hash;
+    std::memcpy(&hash, key.data(), sizeof(hash));
+    shard& s = shards[hash % shard_count];
+    {
+      auto lock = std::scoped_lock{s.mutex};
+      if (auto e = find(s, key); e) {
+        e->referenced = true;
+        return e->value;
+      }
+    }
+    // create the value without holding the shard lock
+    auto value = std::make_shared<const Value>(make());
+    std::shared_ptr<const Value> evicted; // freed after unlocking
+    auto lock = std::scoped_lock{s.mutex};
+    // another thread may have raced to insert the same key
+    if (find(s, key)) {
+      return value;
+    }
+    if (s.entries.size() < shard_capacity) {
+      s.entries.push_back(entry{key, value, false});
+    } else {
+      entry& e = evict(s);
+      e.key = key;
+      evicted = std::exchange(e.value, value);
+      e.referenced = false;
+    }
+    return value;
+  }
+
+  // remove all entries from the cache
+  void clear()
+  {
+    for (std::size_t i = 0; i < shard_count; i++) {
+      std::vector<entry> entries; // freed after unlocking
+      auto lock = std::scoped_lock{shards[i].mutex};
+      entries.swap(shards[i].entries);
+      shards[i].hand = 0;
+    }
+  }
+
+  // return the maximum number of cached entries
+  std::size_t capacity() const { return shard_count * shard_capacity; }
+};
+
+} // namespace awssign::detail
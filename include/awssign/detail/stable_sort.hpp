@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+namespace awssign::detail {
+
+// ranges up to this size are insertion sorted
+inline constexpr std::size_t insertion_sort_threshold = 16;
+
+template <typename T, typename Compare>
+void insertion_sort(T* first, T* last, Compare less)
+{
+  if (first == last) {
+    return;
+  }
+  for (auto i = first + 1; i != last; ++i) {
+    if (!less(*i, *(i - 1))) {
+      continue; // already in place
+    }
+    T value = std::move(*i);
+    auto j = i;
+    do {
+      *j = std::move(*(j - 1));
+      --j;
+    } while (j != first && less(value, *(j - 1)));
+    *j = std::move(value);
+  }
+}
+
+// bottom-up merge sort that alternates between the range and a scratch
+// buffer of the same size
+template <typename T, typename Compare>
+void merge_sort(T* first, T* last, T* scratch, Compare less)
+{
+  const std::size_t size = last - first;
+  for (std::size_t i = 0; i < size; i += insertion_sort_threshold) {
+    const std::size_t n = std::min(insertion_sort_threshold, size - i);
+    insertion_sort(first + i, first + i + n, less);
+  }
+  T* from = first;
+  T* to = scratch;
+  for (std::size_t width = insertion_sort_threshold; width < size; width *= 2) {
+    for (std::size_t i = 0; i < size; i += 2 * width) {
+      const std::size_t mid = std::min(i + width, size);
+      const std::size_t end = std::min(i + 2 * width, size);
+      // std::merge takes from the first range on ties, so this is stable
+      std::merge(std::make_move_iterator(from + i),
+                 std::make_move_iterator(from + mid),
+                 std::make_move_iterator(from + mid),
+                 std::make_move_iterator(from + end),
+                 to + i, less);
+    }
+    std::swap(from, to);
+  }
+  if (from != first) {
+    std::move(from, from + size, first);
+  }
+}
+
+// a stable sort that never allocates. small ranges are insertion sorted,
+// ranges that are already sorted are left alone, and larger ranges are merge
+// sorted with a scratch buffer of at least (last - first) elements. the
+// scratch buffer is only used when the range is larger than
+// insertion_sort_threshold
+template <typename T, typename Compare = std::less<>>
+void stable_sort(T* first, T* last, T* scratch, Compare less = Compare{})
+{
+  const std::size_t size = last - first;
+  if (size <= insertion_sort_threshold) {
+    // linear for sorted input
+    insertion_sort(first, last, less);
+  } else if (!std::is_sorted(first, last, less)) {
+    merge_sort(first, last, scratch, less);
+  }
+}
+
+} // namespace awssign::detail
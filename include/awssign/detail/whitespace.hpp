@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AWSSIGN_WHITESPACE_X86 1
+#include <immintrin.h>
+#endif
+
+namespace awssign::detail {
+
+inline bool whitespace(unsigned char c)
+{
+  switch (c) {
+    case ' ':
+    case '\f':
+    case '\n':
+    case '\r':
+    case '\t':
+    case '\v':
+      return true;
+    default:
+      return false;
+  }
+}
+
+// the kernels of find_whitespace_run()
+enum class whitespace_backend {
+  scalar, // a byte at a time
+  sse2, // 16 bytes at a time
+  avx2, // 32 bytes at a time
+};
+
+// return true if the cpu supports the given backend
+inline bool whitespace_supported(whitespace_backend backend)
+{
+  switch (backend) {
+    case whitespace_backend::scalar:
+      return true;
+#ifdef AWSSIGN_WHITESPACE_X86
+    case whitespace_backend::sse2:
+      return __builtin_cpu_supports("sse2");
+    case whitespace_backend::avx2:
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+// return the fastest backend that the cpu supports
+inline whitespace_backend best_whitespace_backend()
+{
+  static const whitespace_backend backend = [] {
+    if (whitespace_supported(whitespace_backend::avx2)) {
+      return whitespace_backend::avx2;
+    }
+    if (whitespace_supported(whitespace_backend::sse2)) {
+      return whitespace_backend::sse2;
+    }
+    return whitespace_backend::scalar;
+  }();
+  return backend;
+}
+
+namespace whitespace_impl {
+
+// a run needs collapsing if it's longer than one character, or if its only
+// character isn't a space. the caller guarantees that end[-1] isn't
+// whitespace, so p[1] is in bounds whenever p[0] is whitespace
+inline const char* find_run_scalar(const char* p, const char* end)
+{
+  for (; p != end; ++p) {
+    if (whitespace(*p) && (*p != ' ' || whitespace(p[1]))) {
+      return p;
+    }
+  }
+  return end;
+}
+
+#ifdef AWSSIGN_WHITESPACE_X86
+
+// set a bit for each whitespace character: ' ', or '\t' through '\r'
+[[gnu::target("sse2")]]
+inline unsigned whitespace_mask(__m128i c, __m128i& spaces)
+{
+  spaces = _mm_cmpeq_epi8(c, _mm_set1_epi8(' '));
+  const __m128i control = _mm_sub_epi8(c, _mm_set1_epi8('\t'));
+  const __m128i in_range = _mm_cmpeq_epi8(
+      _mm_min_epu8(control, _mm_set1_epi8('\r' - '\t')), control);
+  return _mm_movemask_epi8(_mm_or_si128(spaces, in_range));
+}
+
+// classify 16 bytes at a time. each block also loads the next block's first
+// byte, so it stops while more than 16 bytes remain
+[[gnu::target("sse2")]]
+inline const char* find_run_sse2(const char* p, const char* end)
+{
+  for (; end - p > 16; p += 16) {
+    __m128i spaces, unused;
+    const unsigned ws = whitespace_mask(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), spaces);
+    if (!ws) {
+      continue;
+    }
+    const unsigned next = whitespace_mask(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1)), unused);
+    const unsigned space = _mm_movemask_epi8(spaces);
+    const unsigned runs = ws & (~space | next);
+    if (runs) {
+      return p + __builtin_ctz(runs);
+    }
+  }
+  return find_run_scalar(p, end);
+}
+
+[[gnu::target("avx2")]]
+inline unsigned whitespace_mask(__m256i c, __m256i& spaces)
+{
+  spaces = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(' '));
+  const __m256i control = _mm256_sub_epi8(c, _mm256_set1_epi8('\t'));
+  const __m256i in_range = _mm256_cmpeq_epi8(
+      _mm256_min_epu8(control, _mm256_set1_epi8('\r' - '\t')), control);
+  return _mm256_movemask_epi8(_mm256_or_si256(spaces, in_range));
+}
+
+[[gnu::target("avx2")]]
+inline const char* find_run_avx2(const char* p, const char* end)
+{
+  for (; end - p > 32; p += 32) {
+    __m256i spaces, unused;
+    const unsigned ws = whitespace_mask(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), spaces);
+    if (!ws) {
+      continue;
+    }
+    const unsigned next = whitespace_mask(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1)), unused);
+    const unsigned space = _mm256_movemask_epi8(spaces);
+    const unsigned runs = ws & (~space | next);
+    if (runs) {
+      return p + __builtin_ctz(runs);
+    }
+  }
+  return find_run_sse2(p, end);
+}
+
+#endif // AWSSIGN_WHITESPACE_X86
+
+} // namespace whitespace_impl
+
+// return the first whitespace character in [begin, end) that starts a run
+// of whitespace other than a single space, or end. end[-1] must not be
+// whitespace
+inline const char* find_whitespace_run(
+    const char* begin, const char* end,
+    whitespace_backend backend = best_whitespace_backend())
+{
+#ifdef AWSSIGN_WHITESPACE_X86
+  if (backend == whitespace_backend::avx2) {
+    return whitespace_impl::find_run_avx2(begin, end);
+  }
+  if (backend == whitespace_backend::sse2) {
+    return whitespace_impl::find_run_sse2(begin, end);
+  }
+#endif
+  return whitespace_impl::find_run_scalar(begin, end);
+}
+
+} // namespace awssign::detail
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace awssign {
+
+// a work-stealing thread pool. each worker has its own task queue, and tasks
+// submitted from a worker go to that worker's queue. a worker runs its newest
+// task first, and when its queue is empty it steals the oldest task from
+// another worker's queue
+class thread_pool {
+  using task_type = std::function<void()>;
+
+  struct alignas(64) queue_type {
+    std::mutex mutex;
+    std::deque<task_type> tasks;
+  };
+  std::vector<std::unique_ptr<queue_type>> queues;
+  std::vector<std::thread> threads;
+
+  std::mutex mutex; // for sleeping workers
+  std::condition_variable cond;
+  std::atomic<std::size_t> pending{0}; // tasks in all queues
+  std::atomic<std::size_t> next{0}; // round-robin for outside submissions
+  bool stopping = false;
+
+  // the pool and queue index of the current worker thread
+  static thread_local const thread_pool* current_pool;
+  static thread_local std::size_t current_index;
+
+  bool pop(std::size_t index, task_type& task) {
+    // take the newest task from our own queue
+    {
+      auto& q = *queues[index];
+      auto lock = std::scoped_lock{q.mutex};
+      if (!q.tasks.empty()) {
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+        return true;
+      }
+    }
+    // steal the oldest task from another queue
+    for (std::size_t i = 1; i < queues.size(); i++) {
+      auto& q = *queues[(index + i) % queues.size()];
+      auto lock = std::scoped_lock{q.mutex};
+      if (!q.tasks.empty()) {
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // run one queued task, if there is one
+  bool run_one(std::size_t index, task_type& task) {
+    if (!pop(index, task)) {
+      return false;
+    }
+    pending.fetch_sub(1, std::memory_order_relaxed);
+    task();
+    task = nullptr;
+    return true;
+  }
+
+  void run(std::size_t index) {
+    current_pool = this;
+    current_index = index;
+    task_type task;
+    for (;;) {
+      if (run_one(index, task)) {
+        continue;
+      }
+      auto lock = std::unique_lock{mutex};
+      if (stopping) { // and the queues are drained
+        return;
+      }
+      cond.wait(lock, [this] {
+          return stopping || pending.load(std::memory_order_relaxed) > 0;
+        });
+    }
+  }
+ public:
+  // start the given number of worker threads, or one per cpu by default
+  explicit thread_pool(std::size_t count = std::thread::hardware_concurrency())
+  {
+    count = std::max<std::size_t>(count, 1);
+    for (std::size_t i = 0; i < count; i++) {
+      queues.push_back(std::make_unique<queue_type>());
+    }
+    for (std::size_t i = 0; i < count; i++) {
+      threads.emplace_back([this, i] { run(i); });
+    }
+  }
+  // finish the queued tasks and join the worker threads
+  ~thread_pool() {
+    {
+      auto lock = std::scoped_lock{mutex};
+      stopping = true;
+    }
+    cond.notify_all();
+    for (auto& t : threads) {
+      t.join();
+    }
+  }
+  thread_pool(const thread_pool&) = delete;
+  thread_pool& operator=(const thread_pool&) = delete;
+
+  std::size_t size() const { return threads.size(); }
+
+  // queue a task for execution on one of the worker threads. the task must
+  // not throw
+  template <typename Function>
+  void submit(Function&& f) {
+    const std::size_t index = current_pool == this ? current_index :
+        next.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    // count the task before it can be popped, so pending never wraps below 0
+    pending.fetch_add(1, std::memory_order_relaxed);
+    try {
+      auto& q = *queues[index];
+      auto lock = std::scoped_lock{q.mutex};
+      q.tasks.emplace_back(std::forward<Function>(f));
+    } catch (...) {
+      pending.fetch_sub(1, std::memory_order_relaxed);
+      throw;
+    }
+    {
+      // synchronize with workers that are about to wait
+      auto lock = std::scoped_lock{mutex};
+    }
+    cond.notify_one();
+  }
+
+  // run f(i) for each i in [0, count) on the pool, and wait for all of them
+  // to finish. the calling thread runs queued tasks while it waits, so this
+  // can be called from a worker thread without deadlocking the pool. if any
+  // call throws, the first exception is rethrown after all of them finish
+  template <typename Function>
+  void parallel_for(std::size_t count, Function&& f) {
+    struct state_type {
+      std::atomic<std::size_t> remaining;
+      std::exception_ptr error;
+      std::mutex mutex;
+    } state;
+    state.remaining.store(count, std::memory_order_relaxed);
+
+    for (std::size_t i = 0; i < count; i++) {
+      submit([this, &state, &f, i] {
+          try {
+            f(i);
+          } catch (...) {
+            auto lock = std::scoped_lock{state.mutex};
+            if (!state.error) {
+              state.error = std::current_exception();
+            }
+          }
+          // the state may be gone once remaining reaches 0
+          if (state.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            {
+              // synchronize with the thread that's about to wait
+              auto lock = std::scoped_lock{mutex};
+            }
+            cond.notify_all();
+          }
+        });
+    }
+
+    // help with the queued tasks, which include ours
+    const std::size_t index = current_pool == this ? current_index : 0;
+    task_type task;
+    while (state.remaining.load(std::memory_order_acquire) != 0) {
+      if (run_one(index, task)) {
+        continue;
+      }
+      auto lock = std::unique_lock{mutex};
+      cond.wait(lock, [this, &state] {
+          return state.remaining.load(std::memory_order_acquire) == 0 ||
+              pending.load(std::memory_order_relaxed) > 0;
+        });
+    }
+    if (state.error) {
+      std::rethrow_exception(state.error);
+    }
+  }
+};
+
+inline thread_local const thread_pool* thread_pool::current_pool = nullptr;
+inline thread_local std::size_t thread_pool::current_index = 0;
+
+} // namespace awssign
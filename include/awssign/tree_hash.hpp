@@ -0,0 +1,200 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <vector>
+#include <awssign/detail/digest.hpp>
+#include <awssign/detail/hex_encode.hpp>
+#include <awssign/detail/output_stream.hpp>
+#include <awssign/thread_pool.hpp>
+
+namespace awssign {
+
+// the sha256 tree hash for the x-amz-sha256-tree-hash header of glacier
+// uploads. the payload is split into 1MiB chunks, and the hashes of each
+// level are combined pairwise until one remains. an odd hash at the end of
+// a level is promoted to the next level unchanged
+
+inline constexpr std::size_t tree_hash_chunk_size = 1024 * 1024;
+inline constexpr std::size_t tree_hash_size = 32;
+
+namespace detail {
+
+// hash the concatenation of two child hashes
+inline void tree_hash_combine(const unsigned char* left,
+                              const unsigned char* right,
+                              unsigned char* parent)
+{
+  auto hash = digest{"SHA256"};
+  hash.update(left, tree_hash_size);
+  hash.update(right, tree_hash_size);
+  hash.finish(parent);
+}
+
+} // namespace detail
+
+// computes the tree hash of a payload as it arrives. each chunk is hashed
+// as soon as it's complete, and complete subtrees are merged on a stack like
+// a binary counter, so memory use is logarithmic in the payload size
+class tree_hasher {
+  detail::digest leaf;
+  std::size_t leaf_size = 0; // bytes hashed into leaf
+  struct subtree {
+    unsigned char hash[tree_hash_size];
+    std::size_t chunks; // a power of two
+  };
+  std::vector<subtree> stack;
+
+  void push(const unsigned char* hash) {
+    subtree t;
+    std::copy_n(hash, tree_hash_size, t.hash);
+    t.chunks = 1;
+    // merge equal-sized subtrees
+    while (!stack.empty() && stack.back().chunks == t.chunks) {
+      auto& left = stack.back();
+      detail::tree_hash_combine(left.hash, t.hash, t.hash);
+      t.chunks += left.chunks;
+      stack.pop_back();
+    }
+    stack.push_back(t);
+  }
+  void finish_leaf() {
+    unsigned char hash[tree_hash_size];
+    leaf.finish(hash);
+    leaf.init();
+    leaf_size = 0;
+    push(hash);
+  }
+ public:
+  tree_hasher() : leaf("SHA256") {}
+
+  void update(const void* data, std::size_t size) {
+    auto p = static_cast<const unsigned char*>(data);
+    while (size) {
+      const std::size_t count = std::min(size, tree_hash_chunk_size - leaf_size);
+      leaf.update(p, count);
+      leaf_size += count;
+      p += count;
+      size -= count;
+      if (leaf_size == tree_hash_chunk_size) {
+        finish_leaf();
+      }
+    }
+  }
+
+  // write the tree hash of tree_hash_size bytes. an empty payload has the
+  // hash of an empty chunk
+  std::size_t finish(unsigned char* digest) {
+    if (leaf_size || stack.empty()) {
+      finish_leaf();
+    }
+    // the remaining subtrees shrink from left to right, so promoting odd
+    // hashes is the same as folding them from the right
+    unsigned char hash[tree_hash_size];
+    std::copy_n(stack.back().hash, tree_hash_size, hash);
+    for (auto i = std::next(stack.rbegin()); i != stack.rend(); ++i) {
+      detail::tree_hash_combine(i->hash, hash, hash);
+    }
+    stack.clear();
+    std::copy_n(hash, tree_hash_size, digest);
+    return tree_hash_size;
+  }
+
+  // write the hex-encoded tree hash of 2 * tree_hash_size characters
+  std::size_t finish_hex(char* hex) {
+    unsigned char digest[tree_hash_size];
+    finish(digest);
+    char* pos = detail::hex_encode(digest, digest + tree_hash_size, hex);
+    return std::distance(hex, pos);
+  }
+};
+
+// compute the tree hash of a payload in memory
+inline std::size_t tree_hash(const void* data, std::size_t size,
+                             unsigned char* digest)
+{
+  auto hasher = tree_hasher{};
+  hasher.update(data, size);
+  return hasher.finish(digest);
+}
+
+// compute the tree hash of a payload in memory, hashing its chunks in
+// parallel on the thread pool. each level is stored in one array, and each
+// parent has an atomic count of its unfinished children. the task that
+// finishes the last child of a parent goes on to hash the parent, so levels
+// are combined as soon as their children are ready
+inline std::size_t tree_hash(thread_pool& pool,
+                             const void* data, std::size_t size,
+                             unsigned char* digest)
+{
+  const std::size_t leaves = std::max<std::size_t>(
+      1, (size + tree_hash_chunk_size - 1) / tree_hash_chunk_size);
+  if (leaves == 1) {
+    return tree_hash(data, size, digest);
+  }
+
+  struct state_type {
+    const unsigned char* data;
+    std::size_t size;
+    std::vector<std::size_t> level_offsets; // index of each level's first node
+    std::vector<std::size_t> level_sizes;
+    std::unique_ptr<unsigned char[]> hashes; // tree_hash_size per node
+    std::unique_ptr<std::atomic<int>[]> children; // unfinished, per node
+
+    unsigned char* hash(std::size_t level, std::size_t i) {
+      return hashes.get() + (level_offsets[level] + i) * tree_hash_size;
+    }
+
+    // hash the leaf, then any parents whose children are now finished
+    void run(std::size_t i) {
+      const std::size_t offset = i * tree_hash_chunk_size;
+      auto hash = detail::digest{"SHA256"};
+      hash.update(data + offset, std::min(tree_hash_chunk_size, size - offset));
+      hash.finish(this->hash(0, i));
+
+      for (std::size_t level = 1; level < level_sizes.size(); level++) {
+        i /= 2;
+        if (children[level_offsets[level] + i].fetch_sub(
+                1, std::memory_order_acq_rel) != 1) {
+          return; // the sibling will finish the parent
+        }
+        const auto left = this->hash(level - 1, 2 * i);
+        if (2 * i + 1 < level_sizes[level - 1]) {
+          detail::tree_hash_combine(left, left + tree_hash_size,
+                                    this->hash(level, i));
+        } else { // promote
+          std::copy_n(left, tree_hash_size, this->hash(level, i));
+        }
+      }
+    }
+  } state;
+  state.data = static_cast<const unsigned char*>(data);
+  state.size = size;
+
+  std::size_t nodes = 0;
+  for (std::size_t n = leaves; ; n = (n + 1) / 2) {
+    state.level_offsets.push_back(nodes);
+    state.level_sizes.push_back(n);
+    nodes += n;
+    if (n == 1) {
+      break;
+    }
+  }
+  state.hashes = std::make_unique<unsigned char[]>(nodes * tree_hash_size);
+  state.children = std::make_unique<std::atomic<int>[]>(nodes);
+  for (std::size_t level = 1; level < state.level_sizes.size(); level++) {
+    const std::size_t below = state.level_sizes[level - 1];
+    for (std::size_t i = 0; i < state.level_sizes[level]; i++) {
+      state.children[state.level_offsets[level] + i].store(
+          2 * i + 1 < below ? 2 : 1, std::memory_order_relaxed);
+    }
+  }
+  pool.parallel_for(leaves, [&state] (std::size_t i) { state.run(i); });
+  std::copy_n(state.hash(state.level_sizes.size() - 1, 0),
+              tree_hash_size, digest);
+  return tree_hash_size;
+}
+
+} // namespace awssign
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <awssign/v4/header_template.hpp>
 #include <awssign/v4/presign.hpp>
 #include <awssign/v4/sign.hpp>
+#include <awssign/v4/signing_key_cache.hpp>
 #include <awssign/v4/verify.hpp>
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <awssign/detail/base64_encode.hpp>
+#include <awssign/detail/crc.hpp>
+#include <awssign/detail/output_stream.hpp>
+
+namespace awssign::v4 {
+
+// the algorithms of the x-amz-checksum-* headers and trailers
+enum class checksum_algorithm {
+  crc32,
+  crc32c,
+  crc64nvme,
+};
+
+// return the header name for the checksum algorithm, which is also the
+// value of the x-amz-trailer header when it's sent as a trailer
+constexpr std::string_view checksum_header_name(checksum_algorithm algorithm)
+{
+  switch (algorithm) {
+    case checksum_algorithm::crc32: return "x-amz-checksum-crc32";
+    case checksum_algorithm::crc32c: return "x-amz-checksum-crc32c";
+    case checksum_algorithm::crc64nvme: return "x-amz-checksum-crc64nvme";
+  }
+  return {};
+}
+
+namespace detail {
+
+constexpr awssign::detail::crc_algorithm to_crc_algorithm(
+    checksum_algorithm algorithm)
+{
+  using awssign::detail::crc_algorithm;
+  switch (algorithm) {
+    case checksum_algorithm::crc32: return crc_algorithm::crc32;
+    case checksum_algorithm::crc32c: return crc_algorithm::crc32c;
+    case checksum_algorithm::crc64nvme: return crc_algorithm::crc64nvme;
+  }
+  return crc_algorithm::crc32;
+}
+
+} // namespace detail
+
+// computes a payload checksum for an x-amz-checksum-* header or trailer
+//
+// example:
+//
+//   auto crc = checksum{checksum_algorithm::crc32c};
+//   crc.update(data, size);
+//   char value[checksum::max_base64_size];
+//   const auto size = crc.finish(value);
+//
+class checksum {
+  checksum_algorithm algorithm_;
+  std::uint64_t crc = 0;
+ public:
+  // the base64 encoding of the largest checksum, 8 bytes of crc64nvme
+  static constexpr std::size_t max_base64_size = 12;
+
+  explicit checksum(checksum_algorithm algorithm) noexcept
+      : algorithm_(algorithm)
+  {}
+
+  checksum_algorithm algorithm() const { return algorithm_; }
+  std::string_view header_name() const {
+    return checksum_header_name(algorithm_);
+  }
+
+  void update(const void* data, std::size_t size) {
+    crc = awssign::detail::crc_update(detail::to_crc_algorithm(algorithm_),
+                                      crc, data, size);
+  }
+
+  // continue the checksum with 'size' more bytes of data whose checksum is
+  // 'value', as if that data had been passed to update()
+  void combine(std::uint64_t value, std::uint64_t size) {
+    crc = awssign::detail::crc_combine(detail::to_crc_algorithm(algorithm_),
+                                       crc, value, size);
+  }
+
+  // return the checksum of the data so far
+  std::uint64_t value() const { return crc; }
+
+  // write the base64 encoding of the big-endian checksum to the buffer, which
+  // must hold at least max_base64_size bytes. returns the number of
+  // characters written
+  std::size_t finish(char* base64) const {
+    unsigned char buffer[8] = {};
+    const auto bytes = awssign::detail::crc_encode(
+        detail::to_crc_algorithm(algorithm_), crc, buffer);
+    char* pos = base64;
+    awssign::detail::base64_encode(buffer, buffer + bytes,
+                                   awssign::detail::output_stream{pos});
+    return std::distance(base64, pos);
+  }
+};
+
+} // namespace awssign::v4
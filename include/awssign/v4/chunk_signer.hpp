@@ -0,0 +1,277 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <awssign/detail/write.hpp>
+#include <awssign/v4/checksum.hpp>
+#include <awssign/v4/detail/chunk_chain.hpp>
+#include <awssign/v4/hash_algorithm.hpp>
+#include <awssign/v4/signing_key.hpp>
+
+namespace awssign::v4 {
+
+// the x-amz-content-sha256 header value of an aws-chunked request whose
+// chunks are signed with sha256. this is also the 'payload_hash' argument
+// to sign() for the request's seed signature
+inline constexpr std::string_view streaming_payload_hash =
+    "STREAMING-AWS4-HMAC-SHA256-PAYLOAD";
+
+// the x-amz-content-sha256 header value of an aws-chunked request whose
+// chunks and trailing checksum are signed with sha256
+inline constexpr std::string_view streaming_trailer_payload_hash =
+    "STREAMING-AWS4-HMAC-SHA256-PAYLOAD-TRAILER";
+
+// the x-amz-content-sha256 header value of an aws-chunked request whose
+// chunks aren't signed, but have a trailing checksum
+inline constexpr std::string_view unsigned_trailer_payload_hash =
+    "STREAMING-UNSIGNED-PAYLOAD-TRAILER";
+
+// the crlf that follows each chunk's data
+inline constexpr std::string_view chunk_trailer = "\r\n";
+
+// signs the chunks of an aws-chunked payload. the seed signature is the
+// Signature= of the request's Authorization header, and each chunk's
+// signature covers the chunk's hash and the previous chunk's signature
+//
+// each chunk is sent as its header, the chunk data, and chunk_trailer. the
+// last chunk is empty. with a checksum algorithm, the checksum of the data
+// is sent after the last chunk's header as a signed trailer, and
+// write_trailer() replaces the last chunk_trailer
+//
+// example:
+//
+//   auto signer = chunk_signer{sha256{}, key, date, region, service, seed};
+//   char header[chunk_signer::max_header_size];
+//   const auto header_size = signer.write_header(data, size, header);
+//   // send header, data and chunk_trailer with one writev()
+//
+class chunk_signer {
+  detail::chunk_chain chain;
+  std::size_t chunk_size = 0;
+  std::optional<checksum> trailer_checksum;
+ public:
+  // the largest header that write_header() writes: 16 hex digits of size,
+  // ";chunk-signature=", the signature and a crlf
+  static constexpr std::size_t max_header_size =
+      16 + 17 + detail::chunk_chain::max_hex_size + 2;
+
+  template <typename Hash, // sha256 or named_hash
+            typename = std::enable_if_t<detail::is_hash_algorithm_v<Hash>>>
+  chunk_signer(const Hash& hash_algorithm,
+               const signing_key& key,
+               std::string_view date,
+               std::string_view region,
+               std::string_view service,
+               std::string_view seed_signature)
+      : chain(hash_algorithm, key, date, region, service, seed_signature)
+  {}
+  chunk_signer(const char* hash_algorithm,
+               const signing_key& key,
+               std::string_view date,
+               std::string_view region,
+               std::string_view service,
+               std::string_view seed_signature)
+      : chunk_signer(detail::named_hash{hash_algorithm}, key,
+                     date, region, service, seed_signature)
+  {}
+
+  // sign a payload with a trailing checksum, for a request signed with
+  // streaming_trailer_payload_hash
+  template <typename Hash, // sha256 or named_hash
+            typename = std::enable_if_t<detail::is_hash_algorithm_v<Hash>>>
+  chunk_signer(const Hash& hash_algorithm,
+               const signing_key& key,
+               std::string_view date,
+               std::string_view region,
+               std::string_view service,
+               std::string_view seed_signature,
+               checksum_algorithm trailer)
+      : chain(hash_algorithm, key, date, region, service, seed_signature),
+        trailer_checksum(trailer)
+  {}
+  chunk_signer(const char* hash_algorithm,
+               const signing_key& key,
+               std::string_view date,
+               std::string_view region,
+               std::string_view service,
+               std::string_view seed_signature,
+               checksum_algorithm trailer)
+      : chunk_signer(detail::named_hash{hash_algorithm}, key,
+                     date, region, service, seed_signature, trailer)
+  {}
+
+  // hash part of the current chunk's data. this allows a chunk to be hashed
+  // as it's read, before its header is written
+  void update(const void* data, std::size_t size) {
+    chain.update(data, size);
+    if (trailer_checksum) {
+      trailer_checksum->update(data, size);
+    }
+    chunk_size += size;
+  }
+
+  // sign the current chunk, and write its header to the buffer, which must
+  // hold at least max_header_size bytes. returns the size of the header.
+  // the signer is then ready for the next chunk
+  std::size_t write_header(char* header) {
+    const auto signature = chain.sign();
+
+    char* pos = detail::write_chunk_size(chunk_size, header);
+    pos = std::copy_n(";chunk-signature=", 17, pos);
+    pos = std::copy(signature.begin(), signature.end(), pos);
+    *pos++ = '\r';
+    *pos++ = '\n';
+    chunk_size = 0;
+    return std::distance(header, pos);
+  }
+
+  // hash a whole chunk, sign it, and write its header
+  std::size_t write_header(const void* data, std::size_t size, char* header) {
+    update(data, size);
+    return write_header(header);
+  }
+
+  // after the last chunk's header, sign the trailing checksum and write the
+  // trailer: the checksum, the trailer signature and the final crlf. the
+  // signer must have been constructed with a checksum_algorithm, otherwise
+  // throws std::logic_error
+  template <typename OutputStream>
+  void write_trailer(OutputStream&& out) {
+    using awssign::detail::write;
+    if (!trailer_checksum) {
+      throw std::logic_error("chunk_signer: no trailer checksum algorithm");
+    }
+    char value[checksum::max_base64_size];
+    const auto value_size = trailer_checksum->finish(value);
+    const auto name = trailer_checksum->header_name();
+    chain.update(name.data(), name.size());
+    chain.update(":", 1);
+    chain.update(value, value_size);
+    chain.update("\n", 1);
+    const auto signature = chain.sign_trailer();
+
+    write(name, out);
+    write(':', out);
+    write(value, value + value_size, out);
+    write("\r\nx-amz-trailer-signature:", out);
+    write(signature, out);
+    write("\r\n\r\n", out);
+  }
+
+  // return the signature of the last chunk or trailer that was signed, or
+  // the seed
+  std::string_view signature() const {
+    return chain.signature();
+  }
+
+  // return the Content-Length of an aws-chunked body for a payload of the
+  // given size, split into chunks of max_chunk_size bytes and a final empty
+  // chunk, and any trailer. x-amz-decoded-content-length is the payload size
+  std::size_t encoded_size(std::size_t payload_size,
+                           std::size_t max_chunk_size) const {
+    // the header and trailer around a chunk of the given size
+    auto framing = [this] (std::size_t size) {
+      std::size_t digits = 1;
+      while (size >>= 4) {
+        digits++;
+      }
+      return digits + 17 + chain.size() + 2 + chunk_trailer.size();
+    };
+    const std::size_t full = payload_size / max_chunk_size;
+    const std::size_t remainder = payload_size % max_chunk_size;
+    std::size_t total = payload_size + full * framing(max_chunk_size);
+    if (remainder) {
+      total += framing(remainder);
+    }
+    if (trailer_checksum) {
+      char value[checksum::max_base64_size];
+      total += trailer_checksum->header_name().size() + 1 +
+          trailer_checksum->finish(value) + 2 +
+          std::string_view{"x-amz-trailer-signature:"}.size() +
+          chain.size() + 2;
+    }
+    return total + framing(0);
+  }
+};
+
+// writes the chunks of an aws-chunked payload that isn't signed, for a
+// request signed with unsigned_trailer_payload_hash. the checksum of the
+// data is sent after the last chunk's header as a trailer
+//
+// each chunk is sent as its header, the chunk data, and chunk_trailer. the
+// last chunk is empty, and is followed by write_trailer() instead
+class unsigned_chunk_writer {
+  checksum trailer_checksum;
+  std::size_t chunk_size = 0;
+ public:
+  // the largest header that write_header() writes: 16 hex digits and a crlf
+  static constexpr std::size_t max_header_size = 16 + 2;
+
+  explicit unsigned_chunk_writer(checksum_algorithm trailer) noexcept
+      : trailer_checksum(trailer)
+  {}
+
+  void update(const void* data, std::size_t size) {
+    trailer_checksum.update(data, size);
+    chunk_size += size;
+  }
+
+  // write the current chunk's header to the buffer, which must hold at least
+  // max_header_size bytes. returns the size of the header
+  std::size_t write_header(char* header) {
+    char* pos = detail::write_chunk_size(chunk_size, header);
+    *pos++ = '\r';
+    *pos++ = '\n';
+    chunk_size = 0;
+    return std::distance(header, pos);
+  }
+
+  // checksum a whole chunk, and write its header
+  std::size_t write_header(const void* data, std::size_t size, char* header) {
+    update(data, size);
+    return write_header(header);
+  }
+
+  // after the last chunk's header, write the checksum trailer and the final
+  // crlf
+  template <typename OutputStream>
+  void write_trailer(OutputStream&& out) const {
+    using awssign::detail::write;
+    char value[checksum::max_base64_size];
+    const auto value_size = trailer_checksum.finish(value);
+    write(trailer_checksum.header_name(), out);
+    write(':', out);
+    write(value, value + value_size, out);
+    write("\r\n\r\n", out);
+  }
+
+  // return the Content-Length of the aws-chunked body for a payload of the
+  // given size, split into chunks of max_chunk_size bytes
+  std::size_t encoded_size(std::size_t payload_size,
+                           std::size_t max_chunk_size) const {
+    // the header and trailer around a chunk of the given size
+    auto framing = [] (std::size_t size) {
+      std::size_t digits = 1;
+      while (size >>= 4) {
+        digits++;
+      }
+      return digits + 2 + chunk_trailer.size();
+    };
+    const std::size_t full = payload_size / max_chunk_size;
+    const std::size_t remainder = payload_size % max_chunk_size;
+    std::size_t total = payload_size + full * framing(max_chunk_size);
+    if (remainder) {
+      total += framing(remainder);
+    }
+    char value[checksum::max_base64_size];
+    total += trailer_checksum.header_name().size() + 1 +
+        trailer_checksum.finish(value) + 2;
+    return total + framing(0);
+  }
+};
+
+} // namespace awssign::v4
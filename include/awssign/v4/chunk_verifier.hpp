@@ -0,0 +1,368 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <openssl/crypto.h>
+#include <awssign/v4/checksum.hpp>
+#include <awssign/v4/detail/chunk_chain.hpp>
+#include <awssign/v4/hash_algorithm.hpp>
+#include <awssign/v4/signing_key.hpp>
+
+namespace awssign::v4 {
+
+enum class chunk_status {
+  partial, // all input was consumed in the middle of a chunk
+  chunk, // a chunk's signature was verified
+  complete, // the final empty chunk's signature was verified
+  // errors
+  invalid_size, // not a hex chunk size, or more than 16 digits
+  invalid_extension, // expected ";chunk-signature="
+  invalid_signature, // not a hex signature of the expected size
+  missing_crlf, // expected a crlf after the chunk header or data
+  signature_mismatch, // the chunk's signature doesn't match
+  unexpected_data, // input after the final chunk
+  invalid_trailer, // a malformed or missing trailer
+  checksum_mismatch, // the trailing checksum doesn't match the data
+};
+
+// return true if the status is one of the errors
+inline bool failed(chunk_status status)
+{
+  return status > chunk_status::complete;
+}
+
+// verifies the chunks of an aws-chunked payload as they arrive. each call to
+// parse() consumes input until a chunk is verified or the input runs out, and
+// writes the chunk's data to the output stream straight from the input
+// buffer. data isn't authenticated until parse() returns chunk_status::chunk
+// or chunk_status::complete for it, so the caller must not commit it before
+// then. the first error fails the whole payload
+//
+// with a checksum algorithm, the final chunk is followed by trailers that
+// must include that checksum of the data. for signed payloads, the trailers
+// must end with a valid x-amz-trailer-signature
+//
+// example:
+//
+//   auto verifier = chunk_verifier{sha256{}, key, date, region, service,
+//                                  seed};
+//   const char* pos = buffer;
+//   while (pos != buffer + size) {
+//     const auto status = verifier.parse(pos, buffer + size, out);
+//     if (failed(status)) {
+//       return reject(status);
+//     }
+//     if (status == chunk_status::chunk) {
+//       commit();
+//     }
+//   }
+//
+class chunk_verifier {
+  enum class state_type {
+    size, extension, signature, header_cr, header_lf,
+    data, data_cr, data_lf, trailer, trailer_lf, done, failed
+  };
+  static constexpr std::string_view extension = ";chunk-signature=";
+  static constexpr std::string_view trailer_signature_name =
+      "x-amz-trailer-signature";
+
+  std::optional<detail::chunk_chain> chain; // empty for unsigned payloads
+  std::optional<checksum> trailer_checksum;
+  state_type state = state_type::size;
+  chunk_status error = chunk_status::partial;
+  std::uint64_t chunk_size = 0;
+  std::uint64_t remaining = 0; // data bytes left in the chunk
+  std::uint64_t total_size = 0; // data bytes in verified chunks
+  std::size_t matched = 0; // characters of size, extension or signature
+  char received[detail::chunk_chain::max_hex_size];
+  // the current trailer line
+  char line[128];
+  std::size_t line_size = 0;
+  bool trailer_signed = false; // saw x-amz-trailer-signature
+  bool checksum_found = false;
+  bool checksum_matched = false;
+
+  static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') {
+      return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      return c - 'A' + 10;
+    }
+    return -1;
+  }
+
+  chunk_status fail(chunk_status status) {
+    state = state_type::failed;
+    error = status;
+    return status;
+  }
+
+  // compare in constant time
+  bool signature_matches(std::string_view signature) const {
+    return signature.size() == chain->size() &&
+        ::CRYPTO_memcmp(signature.data(), received, signature.size()) == 0;
+  }
+
+  // a data chunk and its crlf were consumed, check its signature
+  chunk_status finish_chunk() {
+    if (chain && !signature_matches(chain->sign())) {
+      return fail(chunk_status::signature_mismatch);
+    }
+    total_size += chunk_size;
+    state = state_type::size;
+    chunk_size = 0;
+    matched = 0;
+    return chunk_status::chunk;
+  }
+
+  // a trailer line and its crlf were consumed
+  chunk_status parse_trailer() {
+    const auto trailer = std::string_view{line, line_size};
+    const auto colon = trailer.find(':');
+    if (colon == 0 || colon == trailer.npos || trailer_signed) {
+      return fail(chunk_status::invalid_trailer);
+    }
+    const auto name = trailer.substr(0, colon);
+    const auto value = trailer.substr(colon + 1);
+    if (chain && name == trailer_signature_name) {
+      if (value.size() != chain->size() ||
+          !std::all_of(value.begin(), value.end(),
+                       [] (char c) { return hex_digit(c) >= 0; })) {
+        return fail(chunk_status::invalid_trailer);
+      }
+      std::copy(value.begin(), value.end(), received);
+      trailer_signed = true;
+      return chunk_status::partial;
+    }
+    if (chain) { // the canonical trailer is signed
+      chain->update(trailer.data(), trailer.size());
+      chain->update("\n", 1);
+    }
+    if (name == trailer_checksum->header_name()) {
+      char expected[checksum::max_base64_size];
+      const auto size = trailer_checksum->finish(expected);
+      checksum_found = true;
+      checksum_matched = value == std::string_view{expected, size};
+    }
+    return chunk_status::partial;
+  }
+
+  // the empty line after the trailers was consumed
+  chunk_status finish_trailers() {
+    if (trailer_checksum) {
+      if (chain && !trailer_signed) {
+        return fail(chunk_status::invalid_trailer);
+      }
+      if (chain && !signature_matches(chain->sign_trailer())) {
+        return fail(chunk_status::signature_mismatch);
+      }
+      if (!checksum_found) {
+        return fail(chunk_status::invalid_trailer);
+      }
+      if (!checksum_matched) {
+        return fail(chunk_status::checksum_mismatch);
+      }
+    }
+    state = state_type::done;
+    return chunk_status::complete;
+  }
+ public:
+  template <typename Hash, // sha256 or named_hash
+            typename = std::enable_if_t<detail::is_hash_algorithm_v<Hash>>>
+  chunk_verifier(const Hash& hash_algorithm,
+                 const signing_key& key,
+                 std::string_view date,
+                 std::string_view region,
+                 std::string_view service,
+                 std::string_view seed_signature)
+      : chain(std::in_place, hash_algorithm, key,
+              date, region, service, seed_signature)
+  {}
+  chunk_verifier(const char* hash_algorithm,
+                 const signing_key& key,
+                 std::string_view date,
+                 std::string_view region,
+                 std::string_view service,
+                 std::string_view seed_signature)
+      : chunk_verifier(detail::named_hash{hash_algorithm}, key,
+                       date, region, service, seed_signature)
+  {}
+
+  // verify a signed payload with a trailing checksum, for a request signed
+  // with streaming_trailer_payload_hash
+  template <typename Hash, // sha256 or named_hash
+            typename = std::enable_if_t<detail::is_hash_algorithm_v<Hash>>>
+  chunk_verifier(const Hash& hash_algorithm,
+                 const signing_key& key,
+                 std::string_view date,
+                 std::string_view region,
+                 std::string_view service,
+                 std::string_view seed_signature,
+                 checksum_algorithm trailer)
+      : chain(std::in_place, hash_algorithm, key,
+              date, region, service, seed_signature),
+        trailer_checksum(trailer)
+  {}
+
+  // verify the trailing checksum of an unsigned payload, for a request signed
+  // with unsigned_trailer_payload_hash
+  explicit chunk_verifier(checksum_algorithm trailer)
+      : trailer_checksum(trailer)
+  {}
+
+  // parse input from pos up to end, and advance pos past the input that was
+  // consumed. chunk data is hashed in place and written to the output stream
+  template <typename OutputStream>
+  chunk_status parse(const char*& pos, const char* end, OutputStream&& out)
+  {
+    while (pos != end) {
+      switch (state) {
+        case state_type::size:
+          if (const int digit = hex_digit(*pos); digit >= 0) {
+            if (matched == 16) {
+              return fail(chunk_status::invalid_size);
+            }
+            chunk_size = (chunk_size << 4) | digit;
+            matched++;
+            pos++;
+          } else if (matched) { // the extension or crlf must follow
+            state = chain ? state_type::extension : state_type::header_cr;
+            matched = 0;
+          } else {
+            return fail(chunk_status::invalid_size);
+          }
+          break;
+        case state_type::extension:
+          if (*pos != extension[matched]) {
+            return fail(chunk_status::invalid_extension);
+          }
+          pos++;
+          if (++matched == extension.size()) {
+            state = state_type::signature;
+            matched = 0;
+          }
+          break;
+        case state_type::signature:
+          if (hex_digit(*pos) < 0) {
+            return fail(chunk_status::invalid_signature);
+          }
+          received[matched++] = *pos++;
+          if (matched == chain->size()) {
+            state = state_type::header_cr;
+          }
+          break;
+        case state_type::header_cr:
+          if (*pos != '\r') {
+            return fail(chain && hex_digit(*pos) >= 0
+                        ? chunk_status::invalid_signature
+                        : chunk_status::missing_crlf);
+          }
+          pos++;
+          state = state_type::header_lf;
+          break;
+        case state_type::header_lf:
+          if (*pos != '\n') {
+            return fail(chunk_status::missing_crlf);
+          }
+          pos++;
+          remaining = chunk_size;
+          if (chunk_size) {
+            state = state_type::data;
+            break;
+          }
+          // the final chunk is followed by any trailers
+          if (chain && !signature_matches(chain->sign())) {
+            return fail(chunk_status::signature_mismatch);
+          }
+          state = state_type::trailer;
+          line_size = 0;
+          break;
+        case state_type::data: {
+          const auto count = static_cast<std::size_t>(std::min<std::uint64_t>(
+              remaining, end - pos));
+          if (chain) {
+            chain->update(pos, count);
+          }
+          if (trailer_checksum) {
+            trailer_checksum->update(pos, count);
+          }
+          out(pos, pos + count);
+          pos += count;
+          remaining -= count;
+          if (remaining == 0) {
+            state = state_type::data_cr;
+          }
+          break;
+        }
+        case state_type::data_cr:
+          if (*pos != '\r') {
+            return fail(chunk_status::missing_crlf);
+          }
+          pos++;
+          state = state_type::data_lf;
+          break;
+        case state_type::data_lf:
+          if (*pos != '\n') {
+            return fail(chunk_status::missing_crlf);
+          }
+          pos++;
+          return finish_chunk();
+        case state_type::trailer:
+          if (*pos == '\r') {
+            pos++;
+            state = state_type::trailer_lf;
+          } else if (!trailer_checksum) { // no trailers expected
+            return fail(chunk_status::missing_crlf);
+          } else if (line_size == sizeof(line)) {
+            return fail(chunk_status::invalid_trailer);
+          } else {
+            line[line_size++] = *pos++;
+          }
+          break;
+        case state_type::trailer_lf:
+          if (*pos != '\n') {
+            return fail(chunk_status::missing_crlf);
+          }
+          pos++;
+          if (line_size == 0) {
+            return finish_trailers();
+          }
+          if (const auto status = parse_trailer(); failed(status)) {
+            return status;
+          }
+          state = state_type::trailer;
+          line_size = 0;
+          break;
+        case state_type::done:
+          return fail(chunk_status::unexpected_data);
+        case state_type::failed:
+          return error;
+      }
+    }
+    if (state == state_type::failed) {
+      return error;
+    }
+    return state == state_type::done ? chunk_status::complete
+                                     : chunk_status::partial;
+  }
+
+  // return true once the final chunk and any trailers were verified
+  bool is_complete() const { return state == state_type::done; }
+
+  // return the number of data bytes in verified chunks. once complete, this
+  // must match the x-amz-decoded-content-length header
+  std::uint64_t decoded_size() const { return total_size; }
+
+  // return the signature of the last chunk or trailer that was verified, or
+  // the seed. unsigned payloads have no signature
+  std::string_view signature() const {
+    return chain ? chain->signature() : std::string_view{};
+  }
+};
+
+} // namespace awssign::v4
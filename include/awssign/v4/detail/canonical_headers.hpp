@@ -1,32 +1,22 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <iterator>
 #include <awssign/detail/lower_case.hpp>
+#include <awssign/detail/stable_sort.hpp>
 #include <awssign/detail/transform.hpp>
+#include <awssign/detail/whitespace.hpp>
 #include <awssign/detail/write.hpp>
+#include <awssign/v4/detail/known_headers.hpp>
 
 namespace awssign::v4::detail {
 
 using awssign::detail::lower_case_string;
 using awssign::detail::transform_if;
+using awssign::detail::whitespace;
 using awssign::detail::write;
 
-inline bool whitespace(unsigned char c)
-{
-  switch (c) {
-    case ' ':
-    case '\f':
-    case '\n':
-    case '\r':
-    case '\t':
-    case '\v':
-      return true;
-    default:
-      return false;
-  }
-}
-
 // return the string with any leading/tailing whitespace trimmed
 std::string_view trim(std::string_view str)
 {
@@ -54,57 +44,129 @@ template <typename OutputStream>
 void write_canonical_header_value(const char* begin, const char* end,
                                   OutputStream&& out)
 {
-  // skip leading whitespace
-  auto i = std::find_if_not(begin, end, whitespace);
-  for (;;) {
-    auto next = std::find_if(i, end, whitespace);
-    if (i != next) {
-      write(i, next, out);
-    }
-    if (next == end) {
-      break;
-    }
-    // skip past any remaining whitespace
-    i = std::find_if_not(std::next(next), end, whitespace);
-    if (i == end) { // skip trailing whitespace
-      break;
+  const auto value = trim(std::string_view{begin, std::size_t(end - begin)});
+  if (value.empty()) {
+    return;
+  }
+  auto i = value.data();
+  end = i + value.size();
+  auto run = awssign::detail::find_whitespace_run(i, end);
+  if (run == end) {
+    // most values have no runs to collapse, and are written in one span
+    write(i, end, out);
+    return;
+  }
+  write(i, run, out);
+  // collapse the rest into a buffer, so the stream sees one write per buffer
+  // instead of several per run. this loop is branchless, because runs in
+  // these values are usually short and frequent
+  constexpr std::size_t buffer_size = 128;
+  char buffer[buffer_size];
+  std::size_t size = 0;
+  bool previous = false; // was the previous character whitespace?
+  for (auto p = run; p != end; ++p) {
+    if (size > buffer_size - 2) {
+      write(buffer, buffer + size, out);
+      size = 0;
     }
-    // write a single space
-    write(' ', out);
+    const unsigned char c = *p;
+    const bool ws = (c == ' ') | (static_cast<unsigned char>(c - '\t') < 5);
+    // a space for the end of each run, then any other character
+    buffer[size] = ' ';
+    size += previous & !ws;
+    buffer[size] = c;
+    size += !ws;
+    previous = ws;
   }
+  write(buffer, buffer + size, out);
 }
 
 struct canonical_header {
   lower_case_string name;
   std::string_view value;
+  int rank = -1; // index into known_header_names, or -1
+  std::uint64_t key = 0; // lower_case_prefix() of the name
 
   canonical_header() = default;
   canonical_header(std::string_view name, std::string_view value)
-      : name(trim(name)), value(value) {}
+      : name(trim(name)), value(value), rank(known_header_rank(this->name))
+  {
+    if (rank >= 0) {
+      // use the canonical spelling, which is already lower case
+      this->name = known_header_names[rank];
+    }
+    key = awssign::detail::lower_case_prefix(this->name);
+  }
 };
 
-// sort by canonical header name
+// sort by canonical header name. well-known names compare by rank, and most
+// other comparisons are decided by the first 8 bytes of the lowercase names
 inline bool operator<(const canonical_header& l, const canonical_header& r)
 {
+  if (l.rank >= 0 && r.rank >= 0) {
+    return l.rank < r.rank;
+  }
+  if (l.key != r.key) {
+    return l.key < r.key;
+  }
   return l.name < r.name;
 }
 
-template <typename InputIterator,
-          typename OutputIterator>
-OutputIterator sorted_canonical_headers(InputIterator begin,
-                                        InputIterator end,
-                                        OutputIterator out)
+// return true if the headers have the same canonical name. a well-known
+// name can't equal a name that wasn't recognized
+inline bool same_name(const canonical_header& l, const canonical_header& r)
+{
+  if (l.rank >= 0 || r.rank >= 0) {
+    return l.rank == r.rank;
+  }
+  return l.key == r.key && l.name == r.name;
+}
+
+// write a well-known name as-is, or the header name in lower case
+template <typename OutputStream>
+void write_canonical_header_name(const canonical_header& header,
+                                 OutputStream&& out)
+{
+  if (header.rank >= 0) {
+    write(known_header_names[header.rank], out);
+  } else {
+    write(header.name, out);
+  }
+}
+
+// initialize the canonical header array and stable sort it by canonical
+// name. headers beyond insertion_sort_threshold need a scratch array of the
+// same size
+template <typename InputIterator>
+canonical_header* sorted_canonical_headers(InputIterator begin,
+                                           InputIterator end,
+                                           canonical_header* out,
+                                           canonical_header* scratch)
 {
-  // initialize the canonical header array
   auto o = out;
   for (auto i = begin; i != end; ++o, ++i) {
     *o = canonical_header{i->name_string(), i->value()};
   }
-  // stable sort headers by canonical name
-  std::stable_sort(out, o);
+  // std::stable_sort() would try to allocate its own buffer
+  awssign::detail::stable_sort(out, o, scratch);
   return o;
 }
 
+template <typename InputIterator>
+canonical_header* sorted_canonical_headers(InputIterator begin,
+                                           InputIterator end,
+                                           canonical_header* out)
+{
+  const std::size_t count = std::distance(begin, end);
+  canonical_header* scratch = nullptr;
+  if (count > awssign::detail::insertion_sort_threshold) {
+    // stack-allocate the scratch array
+    scratch = static_cast<canonical_header*>(
+        ::alloca(count * sizeof(canonical_header)));
+  }
+  return sorted_canonical_headers(begin, end, out, scratch);
+}
+
 // write out the sorted headers in canonical format
 template <typename HeaderIterator, // forward canonical_header iterator
           typename OutputStream>
@@ -112,25 +174,25 @@ void write_canonical_headers(HeaderIterator header0,
                              HeaderIterator headerN,
                              OutputStream&& out)
 {
-  lower_case_string last_name;
+  const canonical_header* last = nullptr;
   for (auto o = header0; o != headerN; ++o) {
-    if (last_name == o->name) {
+    if (last && same_name(*last, *o)) {
       // comma-separate values with the same header name
       write(',', out);
       write_canonical_header_value(o->value.begin(), o->value.end(), out);
     } else {
-      if (!last_name.empty()) {
+      if (last) {
         // finish the previous line
         write('\n', out);
       }
-      last_name = o->name;
+      last = &*o;
       // write name:value
-      write_canonical_header_name(o->name, out);
+      write_canonical_header_name(*o, out);
       write(':', out);
       write_canonical_header_value(o->value.begin(), o->value.end(), out);
     }
   }
-  if (!last_name.empty()) {
+  if (last) {
     // finish the last line
     write('\n', out);
   }
@@ -143,16 +205,16 @@ void write_signed_headers(HeaderIterator header0,
                           HeaderIterator headerN,
                           OutputStream&& out)
 {
-  lower_case_string last_name;
+  const canonical_header* last = nullptr;
   for (auto o = header0; o != headerN; ++o) {
-    if (last_name == o->name) {
+    if (last && same_name(*last, *o)) {
       continue; // skip duplicate header names
     }
-    if (!last_name.empty()) { // separate header names with ;
+    if (last) { // separate header names with ;
       write(';', out);
     }
-    last_name = o->name;
-    write_canonical_header_name(o->name, out);
+    last = &*o;
+    write_canonical_header_name(*o, out);
   }
 }
 
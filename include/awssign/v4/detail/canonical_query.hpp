@@ -2,9 +2,13 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <awssign/detail/percent_decode.hpp>
 #include <awssign/detail/percent_encode.hpp>
-#include <awssign/detail/percent_decoded_iterator.hpp>
 #include <awssign/detail/percent_decoded_stream.hpp>
+#include <awssign/detail/radix_sort.hpp>
 #include <awssign/detail/transform.hpp>
 #include <awssign/detail/transform_stream.hpp>
 #include <awssign/detail/write.hpp>
@@ -13,7 +17,6 @@ namespace awssign::v4::detail {
 
 using awssign::detail::need_percent_encode;
 using awssign::detail::percent_decoded;
-using awssign::detail::percent_decoded_iterator;
 using awssign::detail::percent_encode;
 using awssign::detail::percent_encode_twice;
 using awssign::detail::transform_if;
@@ -38,6 +41,30 @@ OutputIterator parse_query_parameters(const char* begin, const char* end,
   return out;
 }
 
+// percent-decode a parameter into the key that it sorts by, where '+' sorts
+// as ' '. the key is never longer than the parameter. returns the key's end
+inline char* write_parameter_sort_key(const char* begin, const char* end,
+                                      char* out)
+{
+  using awssign::detail::percent_decode;
+  for (;;) {
+    // copy up to the next escape
+    const char* escape = std::find(begin, end, '%');
+    out = std::replace_copy(begin, escape, out, '+', ' ');
+    if (escape == end) {
+      return out;
+    }
+    if (end - escape < 3) {
+      *out++ = 0; // truncated escape
+      return out;
+    }
+    const char c = percent_decode(percent_decode(escape[1]),
+                                  percent_decode(escape[2]));
+    *out++ = c == '+' ? ' ' : c;
+    begin = escape + 3;
+  }
+}
+
 template <typename OutputStream>
 void write_canonical_parameter_name(const char* begin, const char* end,
                                     OutputStream&& out)
@@ -94,33 +121,50 @@ void write_canonical_query(const char* begin, const char* end,
       return;
     }
   }
-  const auto count = 1 + std::count(begin, end, '&');
+  const std::size_t count = 1 + std::count(begin, end, '&');
   struct parameter {
     const char* begin;
     const char* end;
+    std::string_view key; // percent-decoded, for sorting
   };
   const auto params = static_cast<parameter*>(
       ::alloca(count * sizeof(parameter)));
 
   const auto params_end = parse_query_parameters(begin, end, params);
 
-  // sort parameters by canonical query name and value
-  struct parameter_less {
-    char transform(char c) const {
-      return c == '+' ? ' ' : c;
-    }
-    bool operator()(char l, char r) const {
-      return transform(l) < transform(r);
-    }
-    bool operator()(const parameter& l, const parameter& r) const {
-      // sort in percent-decoded form
-      using iterator = percent_decoded_iterator<const char*>;
-      return std::lexicographical_compare(
-          iterator{l.begin, l.end}, iterator{},
-          iterator{r.begin, r.end}, iterator{}, *this);
+  // decode each parameter once, so the sort compares plain bytes. decoded
+  // keys share one buffer that's no larger than the query
+  constexpr std::size_t max_stack_keys = 16384;
+  const std::size_t keys_size = std::distance(begin, end);
+  std::unique_ptr<char[]> heap_keys;
+  char* keys;
+  if (keys_size <= max_stack_keys) {
+    keys = static_cast<char*>(::alloca(keys_size));
+  } else {
+    heap_keys.reset(new char[keys_size]);
+    keys = heap_keys.get();
+  }
+  for (auto param = params; param != params_end; ++param) {
+    const std::size_t size = std::distance(param->begin, param->end);
+    if (!std::memchr(param->begin, '%', size) &&
+        !std::memchr(param->begin, '+', size)) {
+      // most parameters sort as they are
+      param->key = std::string_view{param->begin, size};
+      continue;
     }
-  };
-  std::sort(params, params_end, parameter_less{});
+    char* key_end = write_parameter_sort_key(param->begin, param->end, keys);
+    param->key = std::string_view{keys, std::size_t(key_end - keys)};
+    keys = key_end;
+  }
+
+  // sort parameters by canonical query name and value
+  parameter* scratch = nullptr;
+  if (count > awssign::detail::radix_sort_threshold) {
+    // stack-allocate the scratch array
+    scratch = static_cast<parameter*>(::alloca(count * sizeof(parameter)));
+  }
+  awssign::detail::radix_sort(params, params_end, scratch,
+                              [] (const parameter& p) { return p.key; });
 
   // write the sorted parameters in canonical form
   bool first = true;
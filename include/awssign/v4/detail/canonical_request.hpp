@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string_view>
+#include <type_traits>
 #include <awssign/detail/write.hpp>
 #include <awssign/v4/detail/canonical_headers.hpp>
 #include <awssign/v4/detail/canonical_query.hpp>
@@ -9,15 +10,17 @@
 
 namespace awssign::v4::detail {
 
-/// write the canonical request to output
-template <typename HeaderIterator,
+/// write the canonical request to output, using the uri encoding rules of s3
+/// if S3 is true. write_headers(out) writes the CanonicalHeaders, a blank
+/// line and the SignedHeaders
+template <bool S3,
+          typename WriteHeaders,
           typename OutputStream>
-void write_canonical_request(std::string_view service,
+void write_canonical_request(std::bool_constant<S3>,
                              std::string_view method,
                              std::string_view uri_path,
                              std::string_view query,
-                             HeaderIterator header0,
-                             HeaderIterator headerN,
+                             WriteHeaders&& write_headers,
                              std::string_view payload_hash,
                              OutputStream&& out)
 {
@@ -27,7 +30,7 @@ void write_canonical_request(std::string_view service,
   write(method, out);
   write('\n', out);
   //   CanonicalURI + '\n' +
-  if (service == "s3") {
+  if constexpr (S3) {
     write_s3_canonical_uri(uri_path.begin(), uri_path.end(), out);
   } else {
     write_canonical_uri(uri_path.begin(), uri_path.end(), out);
@@ -37,13 +40,56 @@ void write_canonical_request(std::string_view service,
   write_canonical_query(query.begin(), query.end(), out);
   write('\n', out);
   //   CanonicalHeaders + '\n' +
-  write_canonical_headers(header0, headerN, out);
-  write('\n', out);
   //   SignedHeaders + '\n' +
-  write_signed_headers(header0, headerN, out);
+  write_headers(out);
   write('\n', out);
   //   HexEncode(Hash(RequestPayload))
   write(payload_hash, out);
 }
 
+/// write the canonical request to output, using the uri encoding rules of s3
+/// if S3 is true. callers that write many requests for the same service can
+/// choose the rules once
+template <bool S3,
+          typename HeaderIterator,
+          typename OutputStream>
+void write_canonical_request(std::bool_constant<S3> s3,
+                             std::string_view method,
+                             std::string_view uri_path,
+                             std::string_view query,
+                             HeaderIterator header0,
+                             HeaderIterator headerN,
+                             std::string_view payload_hash,
+                             OutputStream&& out)
+{
+  auto write_headers = [&] (auto& stream) {
+    write_canonical_headers(header0, headerN, stream);
+    awssign::detail::write('\n', stream);
+    write_signed_headers(header0, headerN, stream);
+  };
+  write_canonical_request(s3, method, uri_path, query, write_headers,
+                          payload_hash, out);
+}
+
+/// write the canonical request to output
+template <typename HeaderIterator,
+          typename OutputStream>
+void write_canonical_request(std::string_view service,
+                             std::string_view method,
+                             std::string_view uri_path,
+                             std::string_view query,
+                             HeaderIterator header0,
+                             HeaderIterator headerN,
+                             std::string_view payload_hash,
+                             OutputStream&& out)
+{
+  if (service == "s3") {
+    write_canonical_request(std::true_type{}, method, uri_path, query,
+                            header0, headerN, payload_hash, out);
+  } else {
+    write_canonical_request(std::false_type{}, method, uri_path, query,
+                            header0, headerN, payload_hash, out);
+  }
+}
+
 } // namespace awssign::v4::detail
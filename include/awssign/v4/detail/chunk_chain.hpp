@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+#include <awssign/detail/digest.hpp>
+#include <awssign/detail/digest_stream.hpp>
+#include <awssign/detail/hex_encode.hpp>
+#include <awssign/detail/output_stream.hpp>
+#include <awssign/detail/write.hpp>
+#include <awssign/v4/detail/string_to_sign.hpp>
+#include <awssign/v4/hash_algorithm.hpp>
+#include <awssign/v4/signing_key.hpp>
+
+namespace awssign::v4::detail {
+
+// write a chunk size in hex without leading zeroes, and return the end
+inline char* write_chunk_size(std::uint64_t size, char* pos)
+{
+  int shift = 60;
+  while (shift > 0 && (size >> shift) == 0) {
+    shift -= 4;
+  }
+  for (; shift >= 0; shift -= 4) {
+    *pos++ = "0123456789abcdef"[(size >> shift) & 0xf];
+  }
+  return pos;
+}
+
+// the chained signatures of an aws-chunked payload. each chunk's string to
+// sign contains the previous chunk's signature (or the seed signature), the
+// hash of an empty string and the hash of the chunk's data. the signature of
+// the trailing headers is chained to the final chunk's
+class chunk_chain {
+ public:
+  static constexpr std::size_t max_hex_size =
+      2 * awssign::detail::digest::max_size;
+ private:
+  // hmacs with the key, algorithm, date and scope lines already hashed.
+  // each chunk's signature starts from a copy of one of them
+  awssign::detail::hmac scope_hmac;
+  awssign::detail::hmac trailer_hmac;
+  awssign::detail::digest chunk_hash; // or the trailing headers' hash
+  std::size_t signature_size; // hex encoded
+  char previous[max_hex_size] = {}; // the last signature, or the seed
+  char empty_hash[max_hex_size]; // hash of an empty string
+
+  static std::size_t finish_hex(awssign::detail::digest& hash, char* hex) {
+    unsigned char buffer[awssign::detail::digest::max_size];
+    const auto size = hash.finish(buffer);
+    char* pos = awssign::detail::hex_encode(buffer, buffer + size, hex);
+    return std::distance(hex, pos);
+  }
+
+  template <typename Hash>
+  static awssign::detail::hmac make_scope_hmac(const Hash& hash_algorithm,
+                                               std::string_view suffix,
+                                               const signing_key& key,
+                                               std::string_view date,
+                                               std::string_view region,
+                                               std::string_view service)
+  {
+    using awssign::detail::write;
+    auto hash = key.hmac();
+    {
+      auto out = awssign::detail::buffered_digest_stream(hash);
+      hash_algorithm.write_signing_algorithm(out);
+      write(suffix, out);
+      write('\n', out);
+      write(date, out);
+      write('\n', out);
+      write_scope(date, region, service, out);
+      write('\n', out);
+    } // flush
+    return hash;
+  }
+
+  // sign the chunk or trailer hash, starting from one of the hmacs
+  std::string_view sign(const awssign::detail::hmac& prototype,
+                        bool chunk) {
+    char chunk_hex[max_hex_size];
+    finish_hex(chunk_hash, chunk_hex);
+    chunk_hash.init();
+
+    auto hash = prototype;
+    hash.update(previous, signature_size);
+    hash.update("\n", 1);
+    if (chunk) {
+      hash.update(empty_hash, signature_size);
+      hash.update("\n", 1);
+    }
+    hash.update(chunk_hex, signature_size);
+    unsigned char buffer[awssign::detail::hmac::max_size];
+    const auto size = hash.finish(buffer);
+    awssign::detail::hex_encode(buffer, buffer + size, previous);
+    return signature();
+  }
+ public:
+  template <typename Hash, // sha256 or named_hash
+            typename = std::enable_if_t<is_hash_algorithm_v<Hash>>>
+  chunk_chain(const Hash& hash_algorithm,
+              const signing_key& key,
+              std::string_view date,
+              std::string_view region,
+              std::string_view service,
+              std::string_view seed_signature)
+      : scope_hmac(make_scope_hmac(hash_algorithm, "-PAYLOAD", key,
+                                   date, region, service)),
+        trailer_hmac(make_scope_hmac(hash_algorithm, "-TRAILER", key,
+                                     date, region, service)),
+        chunk_hash(hash_algorithm.type())
+  {
+    signature_size = finish_hex(chunk_hash, empty_hash);
+    chunk_hash.init();
+    std::copy_n(seed_signature.data(),
+                std::min(seed_signature.size(), sizeof(previous)), previous);
+  }
+
+  // the size of a hex-encoded signature
+  std::size_t size() const { return signature_size; }
+
+  // hash part of the current chunk's data, or of the trailing headers in
+  // their canonical form of "name:value\n" each
+  void update(const void* data, std::size_t size) {
+    chunk_hash.update(data, size);
+  }
+
+  // sign the current chunk and return its signature, which the next chunk's
+  // signature is chained to
+  std::string_view sign() {
+    return sign(scope_hmac, true);
+  }
+
+  // sign the trailing headers after the final chunk
+  std::string_view sign_trailer() {
+    return sign(trailer_hmac, false);
+  }
+
+  // return the signature of the last chunk that was signed, or the seed
+  std::string_view signature() const {
+    return {previous, signature_size};
+  }
+};
+
+} // namespace awssign::v4::detail
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <awssign/detail/lower_case.hpp>
+
+namespace awssign::v4::detail {
+
+// header names that are commonly signed, in their canonical spelling. they
+// are sorted, so an index into this array is also a sort rank
+inline constexpr std::string_view known_header_names[] = {
+  "cache-control",
+  "content-disposition",
+  "content-encoding",
+  "content-language",
+  "content-length",
+  "content-md5",
+  "content-type",
+  "date",
+  "expect",
+  "expires",
+  "host",
+  "if-match",
+  "if-modified-since",
+  "if-none-match",
+  "if-unmodified-since",
+  "range",
+  "transfer-encoding",
+  "user-agent",
+  "x-amz-acl",
+  "x-amz-checksum-crc32",
+  "x-amz-checksum-crc32c",
+  "x-amz-checksum-crc64nvme",
+  "x-amz-checksum-sha1",
+  "x-amz-checksum-sha256",
+  "x-amz-content-sha256",
+  "x-amz-copy-source",
+  "x-amz-copy-source-range",
+  "x-amz-date",
+  "x-amz-decoded-content-length",
+  "x-amz-expected-bucket-owner",
+  "x-amz-grant-full-control",
+  "x-amz-grant-read",
+  "x-amz-grant-write",
+  "x-amz-metadata-directive",
+  "x-amz-object-lock-mode",
+  "x-amz-region-set",
+  "x-amz-request-payer",
+  "x-amz-sdk-checksum-algorithm",
+  "x-amz-security-token",
+  "x-amz-server-side-encryption",
+  "x-amz-storage-class",
+  "x-amz-tagging",
+  "x-amz-tagging-directive",
+  "x-amz-target",
+  "x-amz-trailer",
+  "x-amz-user-agent",
+  "x-amz-website-redirect-location",
+};
+
+inline constexpr int known_header_count = std::size(known_header_names);
+
+namespace known_header_impl {
+
+inline constexpr std::size_t min_size = 4;
+inline constexpr std::size_t max_size = 64;
+inline constexpr unsigned table_bits = 8;
+
+// multiplier chosen so that no two known names share a slot
+inline constexpr std::uint32_t seed = 46441;
+
+// hash the length and three characters of the name. setting 0x20 folds the
+// case of letters and leaves '-' and digits alone, so the hash ignores case
+// without a call to to_lower()
+constexpr std::uint32_t hash(std::string_view name)
+{
+  const std::size_t n = name.size();
+  const std::uint32_t key = static_cast<std::uint32_t>(n & 0xff)
+      | static_cast<std::uint32_t>(name[n / 2] | 0x20) << 8
+      | static_cast<std::uint32_t>(name[n - 2] | 0x20) << 16
+      | static_cast<std::uint32_t>(name[n - 1] | 0x20) << 24;
+  return (key * seed) >> (32 - table_bits);
+}
+
+struct table {
+  std::int8_t slots[1 << table_bits];
+};
+
+constexpr table make_table()
+{
+  table t{};
+  for (auto& slot : t.slots) {
+    slot = -1;
+  }
+  for (int i = 0; i < known_header_count; i++) {
+    if (i > 0 && !(known_header_names[i - 1] < known_header_names[i])) {
+      throw "known header names are not sorted";
+    }
+    auto& slot = t.slots[hash(known_header_names[i])];
+    if (slot != -1) {
+      throw "known header names collide"; // not a constant expression
+    }
+    slot = i;
+  }
+  return t;
+}
+
+inline constexpr table slots = make_table();
+
+} // namespace known_header_impl
+
+// return the rank of a well-known header name, ignoring case, or -1
+constexpr int known_header_rank(std::string_view name)
+{
+  using namespace known_header_impl;
+  if (name.size() < min_size || name.size() > max_size) {
+    return -1;
+  }
+  const int rank = slots.slots[hash(name)];
+  if (rank < 0) {
+    return -1;
+  }
+  const std::string_view known = known_header_names[rank];
+  if (known.size() != name.size()) {
+    return -1;
+  }
+  for (std::size_t i = 0; i < name.size(); i++) {
+    if (awssign::detail::to_lower(name[i]) != known[i]) {
+      return -1;
+    }
+  }
+  return rank;
+}
+
+} // namespace awssign::v4::detail
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <awssign/detail/lower_case.hpp>
+#include <awssign/v4/detail/canonical_headers.hpp>
+
+namespace awssign::v4::detail {
+
+// a header name from SignedHeaders=, with the same sort key as
+// canonical_header
+struct signed_header_name {
+  std::string_view name;
+  std::uint64_t key;
+};
+
+// return the number of names in SignedHeaders=, for sizing the array that's
+// passed to parse_signed_headers()
+inline std::size_t max_signed_headers(std::string_view signed_headers)
+{
+  return 1 + std::count(signed_headers.begin(), signed_headers.end(), ';');
+}
+
+// SignedHeaders= comes from the client, so the names that it may list beyond
+// the request's own headers are limited. this bounds the array of names
+inline constexpr std::size_t max_missing_signed_headers = 16;
+
+// split the semicolon-separated list of header names into a sorted array,
+// skipping empty names. returns the end of the array
+inline signed_header_name* parse_signed_headers(std::string_view signed_headers,
+                                                signed_header_name* out)
+{
+  auto o = out;
+  while (!signed_headers.empty()) {
+    const auto pos = signed_headers.find(';');
+    const auto name = signed_headers.substr(0, pos);
+    if (!name.empty()) {
+      *o++ = signed_header_name{name, awssign::detail::lower_case_prefix(name)};
+    }
+    if (pos == signed_headers.npos) {
+      break;
+    }
+    signed_headers.remove_prefix(pos + 1);
+  }
+  // sort in the same order as compare(), which puts the case-folded prefix
+  // first. clients send lowercase names in sorted order, so this is usually
+  // a single pass
+  auto less = [] (const signed_header_name& l, const signed_header_name& r) {
+    if (l.key != r.key) {
+      return l.key < r.key;
+    }
+    return l.name < r.name;
+  };
+  if (!std::is_sorted(out, o, less)) {
+    std::sort(out, o, less);
+  }
+  return o;
+}
+
+// compare a header's canonical name with a signed header name
+inline int compare(const canonical_header& header,
+                   const signed_header_name& signed_name)
+{
+  if (header.key != signed_name.key) {
+    return header.key < signed_name.key ? -1 : 1;
+  }
+  if (header.name == signed_name.name) {
+    return 0;
+  }
+  return header.name < signed_name.name ? -1 : 1;
+}
+
+// remove the headers whose names aren't signed, keeping the rest in order.
+// both ranges must be sorted, so this is one linear merge. returns the new
+// end of the headers
+inline canonical_header* select_signed_headers(canonical_header* header0,
+                                               canonical_header* headerN,
+                                               const signed_header_name* name0,
+                                               const signed_header_name* nameN)
+{
+  auto out = header0;
+  for (auto h = header0; h != headerN && name0 != nameN;) {
+    const int c = compare(*h, *name0);
+    if (c < 0) {
+      ++h; // not signed
+    } else if (c > 0) {
+      ++name0; // signed but not present
+    } else {
+      // keep the name for any other values of the same header
+      *out++ = *h++;
+    }
+  }
+  return out;
+}
+
+} // namespace awssign::v4::detail
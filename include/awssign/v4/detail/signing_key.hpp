@@ -1,39 +1,59 @@
 #pragma once
 
+#include <algorithm>
+#include <memory>
 #include <string_view>
+#include <type_traits>
+#include <vector>
 #include <awssign/detail/digest.hpp>
+#include <awssign/detail/sha256_mb.hpp>
+#include <awssign/v4/hash_algorithm.hpp>
 
 namespace awssign::v4::detail {
 
 using awssign::detail::hmac;
 
 // use the given hash algorithm to derive the signing key
-std::size_t build_signing_key(const char* hash_algorithm,
+template <typename Hash, // sha256 or named_hash
+          typename = std::enable_if_t<is_hash_algorithm_v<Hash>>>
+std::size_t build_signing_key(const Hash& hash_algorithm,
                               std::string_view secret_access_key,
                               std::string_view date,
                               std::string_view region,
                               std::string_view service,
                               unsigned char* signing_key)
 {
-  // DateKey = HMAC("AWS4"+"<SecretAccessKey>", "<YYYYMMDD>")
-  unsigned char aws4_key[256] = {'A','W','S','4'};
-  const int aws4_key_len = 4 + secret_access_key.copy(
-      reinterpret_cast<char*>(aws4_key) + 4, sizeof(aws4_key) - 4);
-  auto hash = hmac{hash_algorithm, aws4_key, aws4_key_len};
+  constexpr std::size_t digest_size = Hash::digest_size;
+
+  // DateKey = HMAC("AWS4"+"<SecretAccessKey>", "<YYYYMMDD>"). hmac hashes
+  // keys that are longer than a block, so the whole secret is used
+  unsigned char aws4_key_buffer[256];
+  std::unique_ptr<unsigned char[]> long_aws4_key;
+  const std::size_t aws4_key_len = 4 + secret_access_key.size();
+  unsigned char* aws4_key = aws4_key_buffer;
+  if (aws4_key_len > sizeof(aws4_key_buffer)) {
+    long_aws4_key = std::make_unique<unsigned char[]>(aws4_key_len);
+    aws4_key = long_aws4_key.get();
+  }
+  std::copy_n("AWS4", 4, aws4_key);
+  secret_access_key.copy(reinterpret_cast<char*>(aws4_key) + 4,
+                         secret_access_key.size());
+  auto hash = hmac{hash_algorithm.type(), aws4_key,
+                   static_cast<int>(aws4_key_len)};
   hash.update(date.data(), 8);
-  unsigned char date_key[hmac::max_size];
+  unsigned char date_key[digest_size];
   const int date_key_len = hash.finish(date_key);
 
   // DateRegionKey = HMAC(<DateKey>, "<aws-region>")
   hash.init(date_key, date_key_len);
   hash.update(region.data(), region.size());
-  unsigned char region_key[hmac::max_size];
+  unsigned char region_key[digest_size];
   const int region_key_len = hash.finish(region_key);
 
   // DateRegionServiceKey = HMAC(<DateRegionKey>, "<aws-service>")
   hash.init(region_key, region_key_len);
   hash.update(service.data(), service.size());
-  unsigned char service_key[hmac::max_size];
+  unsigned char service_key[digest_size];
   const int service_key_len = hash.finish(service_key);
 
   // SigningKey = HMAC(<DateRegionServiceKey>, "aws4_request")
@@ -43,4 +63,124 @@ std::size_t build_signing_key(const char* hash_algorithm,
   return hash.finish(signing_key);
 }
 
+// use the given hash algorithm tag to derive the signing key
+template <typename Hash> // sha256
+std::size_t build_signing_key(std::string_view secret_access_key,
+                              std::string_view date,
+                              std::string_view region,
+                              std::string_view service,
+                              unsigned char* signing_key)
+{
+  return build_signing_key(Hash{}, secret_access_key,
+                           date, region, service, signing_key);
+}
+
+// use the named hash algorithm to derive the signing key
+inline std::size_t build_signing_key(const char* hash_algorithm,
+                                     std::string_view secret_access_key,
+                                     std::string_view date,
+                                     std::string_view region,
+                                     std::string_view service,
+                                     unsigned char* signing_key)
+{
+  return build_signing_key(named_hash{hash_algorithm}, secret_access_key,
+                           date, region, service, signing_key);
+}
+
+// use the multi-buffer sha256 engine to derive the signing keys for a range of
+// credential scopes, whose elements have the members 'secret_access_key',
+// 'date', 'region' and 'service'. each key is written to
+// signing_keys[i * sha256::digest_size]
+template <typename ScopeIterator>
+void build_signing_keys(const sha256&,
+                        ScopeIterator begin,
+                        ScopeIterator end,
+                        unsigned char* signing_keys)
+{
+  using awssign::detail::sha256_digest;
+  using awssign::detail::sha256_job;
+  constexpr std::size_t batch_size = 64;
+  constexpr std::size_t digest_size = sha256::digest_size;
+  constexpr std::size_t block_size = sha256_digest::block_size;
+
+  // each hmac round hashes ipad+message, then opad+inner digest. the keys of
+  // the first round are "AWS4"+secret, and the later rounds are keyed with the
+  // output of the previous round
+  unsigned char keys[batch_size][block_size];
+  std::size_t key_sizes[batch_size];
+  unsigned char inner_digests[batch_size][digest_size];
+  unsigned char outer[batch_size][block_size + digest_size];
+  sha256_job jobs[batch_size];
+  std::vector<unsigned char> inner; // ipad+message for each scope
+  std::size_t inner_offsets[batch_size];
+
+  while (begin != end) {
+    std::size_t count = 0;
+    auto scope = begin;
+    for (; scope != end && count < batch_size; ++scope, ++count) {
+      // DateKey = HMAC("AWS4"+"<SecretAccessKey>", "<YYYYMMDD>")
+      const std::string_view secret = scope->secret_access_key;
+      if (4 + secret.size() > block_size) { // long keys are hashed first
+        auto hash = sha256_digest{};
+        hash.update("AWS4", 4);
+        hash.update(secret.data(), secret.size());
+        key_sizes[count] = hash.finish(keys[count]);
+      } else {
+        std::copy_n("AWS4", 4, keys[count]);
+        key_sizes[count] = 4 + secret.copy(
+            reinterpret_cast<char*>(keys[count]) + 4, block_size - 4);
+      }
+    }
+
+    for (int round = 0; round < 4; round++) {
+      inner.clear();
+      scope = begin;
+      for (std::size_t i = 0; i < count; ++i, ++scope) {
+        std::string_view message;
+        switch (round) {
+          case 0: message = std::string_view{scope->date}.substr(0, 8); break;
+          case 1: message = scope->region; break; // DateRegionKey
+          case 2: message = scope->service; break; // DateRegionServiceKey
+          default: message = "aws4_request"; break; // SigningKey
+        }
+        inner_offsets[i] = inner.size();
+        inner.resize(inner.size() + block_size + message.size());
+        auto pad = inner.data() + inner_offsets[i];
+        std::fill_n(std::copy_n(keys[i], key_sizes[i], pad),
+                    block_size - key_sizes[i], 0);
+        for (std::size_t j = 0; j < block_size; j++) {
+          pad[j] ^= 0x36;
+        }
+        std::copy(message.begin(), message.end(), pad + block_size);
+
+        auto opad = outer[i];
+        std::fill_n(std::copy_n(keys[i], key_sizes[i], opad),
+                    block_size - key_sizes[i], 0);
+        for (std::size_t j = 0; j < block_size; j++) {
+          opad[j] ^= 0x5c;
+        }
+      }
+      for (std::size_t i = 0; i < count; i++) {
+        const std::size_t end_offset = i + 1 < count ?
+            inner_offsets[i + 1] : inner.size();
+        jobs[i] = sha256_job{inner.data() + inner_offsets[i],
+                             end_offset - inner_offsets[i], inner_digests[i]};
+      }
+      awssign::detail::sha256_multi(jobs, jobs + count);
+
+      for (std::size_t i = 0; i < count; i++) {
+        std::copy_n(inner_digests[i], digest_size, outer[i] + block_size);
+        jobs[i] = sha256_job{outer[i], sizeof(outer[i]), keys[i]};
+        key_sizes[i] = digest_size;
+      }
+      awssign::detail::sha256_multi(jobs, jobs + count);
+    }
+
+    for (std::size_t i = 0; i < count; i++) {
+      signing_keys = std::copy_n(keys[i], digest_size, signing_keys);
+    }
+    begin = scope;
+  }
+}
+
 } // namespace awssign::v4::detail
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <string_view>
+#include <type_traits>
 #include <awssign/detail/write.hpp>
+#include <awssign/v4/hash_algorithm.hpp>
 
 namespace awssign::v4::detail {
 
@@ -20,16 +22,17 @@ void write_scope(std::string_view date, std::string_view region,
 }
 
 // write the string to sign
-template <typename OutputStream>
-void write_string_to_sign(std::string_view hash_algorithm,
+template <typename Hash, // sha256 or named_hash
+          typename OutputStream,
+          typename = std::enable_if_t<is_hash_algorithm_v<Hash>>>
+void write_string_to_sign(const Hash& hash_algorithm,
                           std::string_view date,
                           std::string_view region,
                           std::string_view service,
                           std::string_view canonical_request_hash,
                           OutputStream&& out)
 {
-  write("AWS4-HMAC-", out);
-  write(hash_algorithm, out);
+  hash_algorithm.write_signing_algorithm(out);
   write('\n', out);
   write(date, out);
   write('\n', out);
@@ -38,4 +41,31 @@ void write_string_to_sign(std::string_view hash_algorithm,
   write(canonical_request_hash, out);
 }
 
+// write the string to sign for the given hash algorithm tag
+template <typename Hash, // sha256
+          typename OutputStream>
+void write_string_to_sign(std::string_view date,
+                          std::string_view region,
+                          std::string_view service,
+                          std::string_view canonical_request_hash,
+                          OutputStream&& out)
+{
+  write_string_to_sign(Hash{}, date, region, service, canonical_request_hash,
+                       std::forward<OutputStream>(out));
+}
+
+// write the string to sign for the named hash algorithm
+template <typename OutputStream>
+void write_string_to_sign(const char* hash_algorithm,
+                          std::string_view date,
+                          std::string_view region,
+                          std::string_view service,
+                          std::string_view canonical_request_hash,
+                          OutputStream&& out)
+{
+  write_string_to_sign(named_hash{hash_algorithm}, date, region, service,
+                       canonical_request_hash,
+                       std::forward<OutputStream>(out));
+}
+
 } // namespace awssign::v4::detail
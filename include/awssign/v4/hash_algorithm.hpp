@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string_view>
+#include <type_traits>
+#include <awssign/detail/digest.hpp>
+#include <awssign/detail/write.hpp>
+
+namespace awssign::v4 {
+
+// hash algorithm tags for compile-time algorithm selection, as an alternative
+// to the 'const char* hash_algorithm' arguments. with a tag, buffers are sized
+// exactly, the algorithm name is a constant, and the digest is resolved once
+//
+// example:
+//
+//   sign<v4::sha256>(access_key_id, secret_access_key, method, uri_path,
+//                    query, header0, headerN, payload_hash,
+//                    date, region, service, out);
+//
+struct sha256 {
+  static constexpr std::string_view name = "SHA256";
+  static constexpr std::string_view signing_algorithm = "AWS4-HMAC-SHA256";
+  static constexpr std::size_t digest_size = 32;
+
+  static const awssign::detail::digest_type& type() {
+    static const auto type = awssign::detail::get_digest_type("SHA256");
+    if (!type) {
+      throw awssign::detail::make_digest_error(::ERR_get_error());
+    }
+    return *type;
+  }
+
+  template <typename OutputStream>
+  static void write_signing_algorithm(OutputStream&& out) {
+    awssign::detail::write(signing_algorithm, out);
+  }
+};
+
+namespace detail {
+
+// a hash algorithm selected at runtime by name
+struct named_hash {
+  const char* name;
+
+  static constexpr std::size_t digest_size = awssign::detail::digest::max_size;
+
+  const awssign::detail::digest_type& type() const {
+    auto type = awssign::detail::get_digest_type(name);
+    if (!type) {
+      throw awssign::detail::make_digest_error(::ERR_get_error());
+    }
+    return *type;
+  }
+
+  template <typename OutputStream>
+  void write_signing_algorithm(OutputStream&& out) const {
+    awssign::detail::write("AWS4-HMAC-", out);
+    awssign::detail::write(name, out);
+  }
+};
+
+// detect hash algorithm types like sha256 and named_hash
+template <typename T, typename = void>
+struct is_hash_algorithm : std::false_type {};
+
+template <typename T>
+struct is_hash_algorithm<T, std::void_t<decltype(T::digest_size)>>
+    : std::true_type {};
+
+template <typename T>
+inline constexpr bool is_hash_algorithm_v = is_hash_algorithm<T>::value;
+
+} // namespace detail
+
+} // namespace awssign::v4
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <awssign/detail/stable_sort.hpp>
+#include <awssign/detail/write.hpp>
+#include <awssign/v4/detail/canonical_headers.hpp>
+#include <awssign/v4/detail/canonical_request.hpp>
+#include <awssign/v4/sign.hpp>
+
+namespace awssign::v4 {
+
+// the canonical headers of requests that send the same headers every time,
+// except for a few whose values change. the static headers are sorted and
+// canonicalized once, along with the SignedHeaders, and signing only has to
+// canonicalize the dynamic values and splice them in
+//
+// example:
+//
+//   const header_type static_headers[] = {
+//     {"Host", "bucket.s3.amazonaws.com"},
+//     {"User-Agent", "client/1.0"},
+//   };
+//   const std::string_view dynamic_names[] = {
+//     "X-Amz-Date", "X-Amz-Content-SHA256"
+//   };
+//   const auto headers = header_template{
+//       std::begin(static_headers), std::end(static_headers),
+//       std::begin(dynamic_names), std::end(dynamic_names)};
+//   ...
+//   const std::string_view values[] = {date, payload_hash};
+//   sign<sha256>(access_key_id, key, method, uri_path, query,
+//                headers, values, payload_hash,
+//                date, region, service, out);
+//
+class header_template {
+  // a position in the text where a dynamic value is written
+  struct slot {
+    std::size_t offset;
+    std::size_t value; // index into the values
+  };
+  // CanonicalHeaders, a blank line and SignedHeaders, without the dynamic
+  // values
+  std::string text;
+  std::size_t signed_offset = 0; // where the SignedHeaders start
+  std::vector<slot> slots; // sorted by offset
+  std::size_t value_count = 0;
+
+  struct entry {
+    detail::canonical_header header;
+    std::size_t value; // index into the values, or npos if static
+  };
+  static constexpr std::size_t npos = std::string_view::npos;
+
+ public:
+  // build the template from the static headers and the names of the dynamic
+  // headers. a dynamic name that's also a static header's name has its value
+  // listed after the static values
+  template <typename HeaderIterator, // forward iterator of http headers
+            typename NameIterator> // forward iterator of std::string_view
+  header_template(HeaderIterator header0, HeaderIterator headerN,
+                  NameIterator name0, NameIterator nameN)
+  {
+    using detail::canonical_header;
+    auto entries = std::vector<entry>{};
+    for (auto h = header0; h != headerN; ++h) {
+      entries.push_back({canonical_header{h->name_string(), h->value()}, npos});
+    }
+    for (auto n = name0; n != nameN; ++n) {
+      entries.push_back({canonical_header{*n, {}}, value_count++});
+    }
+    auto scratch = std::vector<entry>(entries.size());
+    awssign::detail::stable_sort(
+        entries.data(), entries.data() + entries.size(), scratch.data(),
+        [] (const entry& l, const entry& r) { return l.header < r.header; });
+
+    auto out = [this] (const char* begin, const char* end) {
+      text.append(begin, end);
+    };
+    const entry* last = nullptr;
+    for (const auto& e : entries) {
+      if (last && same_name(last->header, e.header)) {
+        // comma-separate values with the same header name
+        text += ',';
+      } else {
+        if (last) {
+          text += '\n';
+        }
+        last = &e;
+        detail::write_canonical_header_name(e.header, out);
+        text += ':';
+      }
+      if (e.value == npos) {
+        const auto& value = e.header.value;
+        detail::write_canonical_header_value(value.begin(), value.end(), out);
+      } else {
+        slots.push_back({text.size(), e.value});
+      }
+    }
+    if (last) {
+      text += '\n';
+    }
+    text += '\n';
+    signed_offset = text.size();
+    last = nullptr;
+    for (const auto& e : entries) {
+      if (last && same_name(last->header, e.header)) {
+        continue; // skip duplicate header names
+      }
+      if (last) {
+        text += ';';
+      }
+      last = &e;
+      detail::write_canonical_header_name(e.header, out);
+    }
+  }
+
+  // the number of values that write_canonical_headers() expects
+  std::size_t dynamic_count() const { return value_count; }
+
+  // the cached SignedHeaders
+  std::string_view signed_headers() const {
+    return std::string_view{text}.substr(signed_offset);
+  }
+
+  // write the CanonicalHeaders, a blank line and the SignedHeaders, with one
+  // value for each dynamic name in the order they were given
+  template <typename OutputStream>
+  void write_canonical_headers(const std::string_view* values,
+                               OutputStream&& out) const
+  {
+    using awssign::detail::write;
+    const char* pos = text.data();
+    for (const auto& s : slots) {
+      write(pos, text.data() + s.offset, out);
+      pos = text.data() + s.offset;
+      const auto value = values[s.value];
+      detail::write_canonical_header_value(
+          value.data(), value.data() + value.size(), out);
+    }
+    write(pos, text.data() + text.size(), out);
+  }
+};
+
+namespace detail {
+
+template <typename Hash, // sha256 or named_hash
+          typename OutputStream>
+void sign_request(const Hash& hash_algorithm,
+                  std::string_view access_key_id,
+                  const signing_key& key,
+                  std::string_view method,
+                  std::string_view uri_path,
+                  std::string_view query,
+                  const header_template& headers,
+                  const std::string_view* values,
+                  std::string_view payload_hash,
+                  std::string_view date,
+                  std::string_view region,
+                  std::string_view service,
+                  OutputStream&& out)
+{
+  constexpr std::size_t digest_size = Hash::digest_size;
+
+  auto write_headers = [&] (auto& stream) {
+    headers.write_canonical_headers(values, stream);
+  };
+  char signature_buffer[digest_size * 2]; // hex encoded
+  const auto signature = sign_canonical_request(
+      hash_algorithm, key, date, region, service,
+      [&] (auto&& stream) {
+        if (service == "s3") {
+          write_canonical_request(std::true_type{}, method, uri_path, query,
+                                  write_headers, payload_hash, stream);
+        } else {
+          write_canonical_request(std::false_type{}, method, uri_path, query,
+                                  write_headers, payload_hash, stream);
+        }
+      }, signature_buffer);
+
+  // write the Authorization header value
+  return write_authorization_header_value(
+      hash_algorithm, access_key_id, date, region, service,
+      [&] (auto& stream) {
+        awssign::detail::write(headers.signed_headers(), stream);
+      }, signature, out);
+}
+
+} // namespace detail
+
+// generate a signature for a request with the template's headers and the
+// given dynamic values, with a signing key that was derived for the same
+// date, region and service, and write the Authorization header's value to
+// output
+template <typename OutputStream>
+void sign(const char* hash_algorithm,
+          std::string_view access_key_id,
+          const signing_key& key,
+          std::string_view method,
+          std::string_view uri_path,
+          std::string_view query,
+          const header_template& headers,
+          const std::string_view* values, // headers.dynamic_count()
+          std::string_view payload_hash,
+          std::string_view date,
+          std::string_view region,
+          std::string_view service,
+          OutputStream&& out)
+{
+  return detail::sign_request(detail::named_hash{hash_algorithm},
+                              access_key_id, key, method, uri_path, query,
+                              headers, values, payload_hash,
+                              date, region, service,
+                              std::forward<OutputStream>(out));
+}
+
+// generate a signature for a request with the template's headers and the
+// given dynamic values, with the given hash algorithm tag and a signing key
+// that was derived for the same date, region and service, and write the
+// Authorization header's value to output
+template <typename Hash, // sha256
+          typename OutputStream>
+void sign(std::string_view access_key_id,
+          const signing_key& key,
+          std::string_view method,
+          std::string_view uri_path,
+          std::string_view query,
+          const header_template& headers,
+          const std::string_view* values, // headers.dynamic_count()
+          std::string_view payload_hash,
+          std::string_view date,
+          std::string_view region,
+          std::string_view service,
+          OutputStream&& out)
+{
+  return detail::sign_request(Hash{}, access_key_id, key, method, uri_path,
+                              query, headers, values, payload_hash,
+                              date, region, service,
+                              std::forward<OutputStream>(out));
+}
+
+} // namespace awssign::v4
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <awssign/detail/multi_digest.hpp>
+#include <awssign/thread_pool.hpp>
+#include <awssign/v4/checksum.hpp>
+#include <awssign/v4/payload_hasher.hpp>
+
+namespace awssign::v4 {
+
+// the hashes of one part of a multipart upload
+struct part_hash {
+  std::uint64_t offset = 0; // in the object
+  std::uint64_t size = 0;
+  char payload_hash[64]; // hex sha256 for x-amz-content-sha256
+  char checksum_base64[checksum::max_base64_size]; // x-amz-checksum-*
+  std::size_t checksum_size = 0; // 0 without a checksum algorithm
+
+  std::string_view payload_hash_view() const {
+    return {payload_hash, sizeof(payload_hash)};
+  }
+  std::string_view checksum_view() const {
+    return {checksum_base64, checksum_size};
+  }
+};
+
+namespace detail {
+
+inline awssign::detail::payload_digest to_payload_digest(
+    checksum_algorithm algorithm)
+{
+  using awssign::detail::payload_digest;
+  switch (algorithm) {
+    case checksum_algorithm::crc32: return payload_digest::crc32;
+    case checksum_algorithm::crc32c: return payload_digest::crc32c;
+    case checksum_algorithm::crc64nvme: return payload_digest::crc64nvme;
+  }
+  return payload_digest::crc32;
+}
+
+} // namespace detail
+
+// hashes the parts of a multipart upload in parallel on a thread pool. each
+// part gets the sha256 payload hash to sign its UploadPart request with, and
+// optionally its x-amz-checksum-* value. for the x-amz-checksum-* of
+// CompleteMultipartUpload, the composite checksum is the checksum of the
+// parts' checksums, and the full object checksum is the checksum of the
+// whole object. s3 has no composite checksums for crc64nvme
+//
+// example:
+//
+//   auto pool = thread_pool{};
+//   auto hashes = multipart_hashes{pool, fd, 64 * 1024 * 1024,
+//                                  checksum_algorithm::crc32c};
+//   for (const auto& part : hashes.parts()) {
+//     sign(..., part.payload_hash_view(), date, region, service, out);
+//   }
+//   const auto composite = hashes.composite_checksum();
+//   const auto full_object = hashes.full_object_checksum();
+//
+class multipart_hashes {
+  std::optional<checksum_algorithm> algorithm;
+  std::vector<part_hash> parts_;
+  std::vector<std::uint64_t> checksums; // the value of each part's checksum
+  // base64 checksum, '-' and up to 20 digits of the part count
+  char composite[checksum::max_base64_size + 21];
+  std::size_t composite_size = 0;
+  char full_object[checksum::max_base64_size];
+  std::size_t full_object_size = 0;
+
+  // hash each part with the given function, and wait for all of them
+  template <typename HashPart>
+  void hash_parts(thread_pool& pool, HashPart&& hash_part)
+  {
+    pool.parallel_for(parts_.size(), [this, &hash_part] (std::size_t i) {
+        hash_part(parts_[i], checksums[i]);
+      });
+  }
+
+  // hash one part's data, which may arrive in several pieces
+  template <typename ReadPart>
+  void hash_part(part_hash& part, std::uint64_t& value, ReadPart&& read)
+  {
+    using awssign::detail::payload_digest;
+    auto hash = algorithm
+        ? awssign::detail::multi_digest{payload_digest::sha256,
+                                        detail::to_payload_digest(*algorithm)}
+        : awssign::detail::multi_digest{payload_digest::sha256};
+    read(hash);
+    hash.finish();
+    hash.hex(payload_digest::sha256, part.payload_hash);
+    if (algorithm) {
+      const auto crc = detail::to_payload_digest(*algorithm);
+      part.checksum_size = hash.base64(crc, part.checksum_base64);
+      unsigned char bytes[8];
+      const auto size = hash.bytes(crc, bytes);
+      value = 0;
+      for (std::size_t i = 0; i < size; i++) {
+        value = (value << 8) | bytes[i];
+      }
+    }
+  }
+
+  void init_parts(std::uint64_t size, std::uint64_t part_size) {
+    if (part_size == 0) {
+      throw std::invalid_argument("multipart_hashes: part_size is 0");
+    }
+    const std::uint64_t count = std::max<std::uint64_t>(
+        1, (size + part_size - 1) / part_size);
+    parts_.resize(count);
+    checksums.resize(count);
+    for (std::uint64_t i = 0; i < count; i++) {
+      parts_[i].offset = i * part_size;
+      parts_[i].size = std::min(part_size, size - parts_[i].offset);
+    }
+  }
+
+  // the checksum of the whole object, combined from the part checksums
+  void finish_full_object() {
+    auto crc = checksum{*algorithm};
+    for (std::size_t i = 0; i < parts_.size(); i++) {
+      crc.combine(checksums[i], parts_[i].size);
+    }
+    full_object_size = crc.finish(full_object);
+  }
+
+  // the checksum of the big-endian part checksums, then the part count
+  void finish_composite() {
+    auto crc = checksum{*algorithm};
+    for (auto value : checksums) {
+      unsigned char buffer[8] = {};
+      crc.update(buffer, awssign::detail::crc_encode(
+              detail::to_crc_algorithm(*algorithm), value, buffer));
+    }
+    composite_size = crc.finish(composite);
+    char digits[20];
+    char* end = std::end(digits);
+    char* pos = end;
+    for (auto n = parts_.size(); pos == end || n; n /= 10) {
+      *--pos = '0' + n % 10;
+    }
+    composite[composite_size++] = '-';
+    composite_size = std::distance(composite,
+                                   std::copy(pos, end,
+                                             composite + composite_size));
+  }
+
+  void finish_checksums() {
+    if (!algorithm) {
+      return;
+    }
+    finish_full_object();
+    if (*algorithm != checksum_algorithm::crc64nvme) {
+      finish_composite();
+    }
+  }
+
+  void hash_memory(thread_pool& pool, const char* data) {
+    hash_parts(pool, [this, data] (part_hash& part, std::uint64_t& value) {
+        hash_part(part, value, [&part, data] (auto& hash) {
+            hash.update(data + part.offset, part.size);
+          });
+      });
+    finish_checksums();
+  }
+
+  void hash_file(thread_pool& pool, int fd, std::uint64_t size) {
+    if (size >= payload_hasher::map_threshold) {
+      void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        // parts are read concurrently, so don't ask for sequential readahead
+        ::madvise(addr, size, MADV_WILLNEED);
+        try {
+          hash_memory(pool, static_cast<const char*>(addr));
+        } catch (...) {
+          ::munmap(addr, size);
+          throw;
+        }
+        ::munmap(addr, size);
+        return;
+      }
+    }
+    // each task reads its own part with pread()
+    hash_parts(pool, [this, fd] (part_hash& part, std::uint64_t& value) {
+        hash_part(part, value, [&part, fd] (auto& hash) {
+            const auto buffer_size = static_cast<std::size_t>(std::min<
+                std::uint64_t>(part.size, payload_hasher::read_size));
+            auto buffer = std::make_unique<char[]>(buffer_size);
+            std::uint64_t offset = part.offset;
+            const std::uint64_t end = part.offset + part.size;
+            while (offset < end) {
+              const auto count = ::pread(fd, buffer.get(),
+                  std::min<std::uint64_t>(buffer_size, end - offset), offset);
+              if (count > 0) {
+                hash.update(buffer.get(), count);
+                offset += count;
+              } else if (count == 0) {
+                throw std::system_error(
+                    std::make_error_code(std::errc::io_error));
+              } else if (errno != EINTR) {
+                throw std::system_error(errno, std::system_category());
+              }
+            }
+          });
+      });
+    finish_checksums();
+  }
+
+  static std::uint64_t file_size(int fd) {
+    struct ::stat st;
+    if (::fstat(fd, &st) == -1) {
+      throw std::system_error(errno, std::system_category());
+    }
+    if (!S_ISREG(st.st_mode)) {
+      throw std::system_error(std::make_error_code(std::errc::invalid_argument));
+    }
+    return st.st_size;
+  }
+ public:
+  // hash the parts of an object in memory, like a mapped file
+  multipart_hashes(thread_pool& pool, const void* data, std::uint64_t size,
+                   std::uint64_t part_size)
+  {
+    init_parts(size, part_size);
+    hash_memory(pool, static_cast<const char*>(data));
+  }
+  multipart_hashes(thread_pool& pool, const void* data, std::uint64_t size,
+                   std::uint64_t part_size, checksum_algorithm part_checksum)
+      : algorithm(part_checksum)
+  {
+    init_parts(size, part_size);
+    hash_memory(pool, static_cast<const char*>(data));
+  }
+
+  // hash the parts of a regular file. large files are mapped into memory if
+  // possible, otherwise each part is read with pread(). throws
+  // std::system_error on errors
+  multipart_hashes(thread_pool& pool, int fd, std::uint64_t part_size)
+  {
+    const auto size = file_size(fd);
+    init_parts(size, part_size);
+    hash_file(pool, fd, size);
+  }
+  multipart_hashes(thread_pool& pool, int fd, std::uint64_t part_size,
+                   checksum_algorithm part_checksum)
+      : algorithm(part_checksum)
+  {
+    const auto size = file_size(fd);
+    init_parts(size, part_size);
+    hash_file(pool, fd, size);
+  }
+
+  // the parts in order. part numbers start at 1, so parts()[0] is part 1
+  const std::vector<part_hash>& parts() const { return parts_; }
+
+  // return the composite checksum as "<base64>-<part count>", or an empty
+  // string without a checksum algorithm or with crc64nvme
+  std::string_view composite_checksum() const {
+    return {composite, composite_size};
+  }
+
+  // return the base64 checksum of the whole object, or an empty string
+  // without a checksum algorithm
+  std::string_view full_object_checksum() const {
+    return {full_object, full_object_size};
+  }
+};
+
+} // namespace awssign::v4
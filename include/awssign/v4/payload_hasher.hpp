@@ -0,0 +1,198 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <awssign/detail/digest.hpp>
+#include <awssign/detail/hex_encode.hpp>
+#include <awssign/detail/output_stream.hpp>
+#include <awssign/v4/hash_algorithm.hpp>
+
+namespace awssign::v4 {
+
+namespace detail {
+
+// detect a single buffer with data() and size(), like asio::const_buffer
+template <typename T, typename = void>
+struct is_buffer : std::false_type {};
+
+template <typename T>
+struct is_buffer<T, std::void_t<decltype(std::declval<const T&>().data()),
+                                decltype(std::declval<const T&>().size())>>
+    : std::true_type {};
+
+// detect a sequence of buffers, like asio's ConstBufferSequence. a container
+// of characters is a single buffer, not a sequence
+template <typename T, typename = void>
+struct is_buffer_sequence : std::false_type {};
+
+template <typename T>
+struct is_buffer_sequence<T, std::void_t<decltype(
+    std::begin(std::declval<const T&>()))>>
+    : is_buffer<std::decay_t<decltype(*std::begin(std::declval<const T&>()))>> {};
+
+struct free_deleter {
+  void operator()(void* p) const { std::free(p); }
+};
+
+} // namespace detail
+
+// hashes a request payload for the x-amz-content-sha256 header, or for the
+// 'payload_hash' argument of sign(), presign() and verify()
+//
+// example:
+//
+//   auto hasher = payload_hasher{};
+//   hasher.update_file(fd);
+//   char payload_hash[payload_hasher::max_hex_size];
+//   const auto size = hasher.finish(payload_hash);
+//
+class payload_hasher {
+  awssign::detail::digest hash;
+ public:
+  static constexpr std::size_t max_hex_size =
+      2 * awssign::detail::digest::max_size;
+  // the size of the aligned buffer for read() when a file can't be mapped
+  static constexpr std::size_t read_size = 1024 * 1024;
+  // the minimum file size for update_file() to map instead of read
+  static constexpr std::size_t map_threshold = 256 * 1024;
+
+  payload_hasher()
+      : hash(sha256::type())
+  {}
+  template <typename Hash, // sha256 or named_hash
+            typename = std::enable_if_t<detail::is_hash_algorithm_v<Hash>>>
+  explicit payload_hasher(const Hash& hash_algorithm)
+      : hash(hash_algorithm.type())
+  {}
+  explicit payload_hasher(const char* hash_algorithm)
+      : hash(hash_algorithm)
+  {}
+
+  void update(const void* data, std::size_t size) {
+    hash.update(data, size);
+  }
+  void update(std::string_view data) {
+    hash.update(data.data(), data.size());
+  }
+
+  // hash scatter-gather input
+  void update_iovec(const ::iovec* iov, int count) {
+    for (int i = 0; i < count; i++) {
+      hash.update(iov[i].iov_base, iov[i].iov_len);
+    }
+  }
+
+  // hash a buffer with data() and size(), or a sequence of such buffers
+  // (like asio's ConstBufferSequence)
+  template <typename Buffers>
+  void update_buffers(const Buffers& buffers) {
+    if constexpr (detail::is_buffer_sequence<Buffers>::value) {
+      for (auto i = std::begin(buffers); i != std::end(buffers); ++i) {
+        update_buffers(*i);
+      }
+    } else {
+      static_assert(detail::is_buffer<Buffers>::value,
+                    "expected a buffer with data() and size()");
+      hash.update(buffers.data(), buffers.size());
+    }
+  }
+
+  // hash a regular file from its current offset to the end by mapping it
+  // into memory, and advance the offset. returns false without hashing
+  // anything if the file can't be mapped
+  bool update_mapped(int fd) {
+    struct ::stat st;
+    if (::fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)) {
+      return false;
+    }
+    const auto offset = ::lseek(fd, 0, SEEK_CUR);
+    if (offset == -1) {
+      return false;
+    }
+    if (offset >= st.st_size) {
+      return true; // nothing to hash
+    }
+    // the mapping must start on a page boundary
+    const auto page_size = ::sysconf(_SC_PAGESIZE);
+    const auto map_offset = offset - offset % page_size;
+    const std::size_t map_size = st.st_size - map_offset;
+    void* addr = ::mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE,
+                        fd, map_offset);
+    if (addr == MAP_FAILED) {
+      return false;
+    }
+    ::madvise(addr, map_size, MADV_SEQUENTIAL);
+    const auto data = static_cast<const char*>(addr) + (offset - map_offset);
+    try {
+      hash.update(data, st.st_size - offset);
+    } catch (...) {
+      ::munmap(addr, map_size);
+      throw;
+    }
+    ::munmap(addr, map_size);
+    ::lseek(fd, st.st_size, SEEK_SET);
+    return true;
+  }
+
+  // hash a file, pipe or socket until end of file with large reads into an
+  // aligned buffer. throws std::system_error on read errors
+  void update_read(int fd) {
+#ifdef POSIX_FADV_SEQUENTIAL
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    void* p = nullptr;
+    if (::posix_memalign(&p, 4096, read_size) != 0) {
+      throw std::bad_alloc{};
+    }
+    auto buffer = std::unique_ptr<char, detail::free_deleter>{
+        static_cast<char*>(p)};
+    for (;;) {
+      const auto count = ::read(fd, buffer.get(), read_size);
+      if (count > 0) {
+        hash.update(buffer.get(), count);
+      } else if (count == 0) {
+        break;
+      } else if (errno != EINTR) {
+        throw std::system_error(errno, std::system_category());
+      }
+    }
+  }
+
+  // hash a file from its current offset to the end. regular files with a lot
+  // left to hash are mapped into memory if possible, because reads are
+  // cheaper for the rest
+  void update_file(int fd) {
+    struct ::stat st;
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+      const auto offset = ::lseek(fd, 0, SEEK_CUR);
+      if (offset != -1 && offset < st.st_size &&
+          static_cast<std::uint64_t>(st.st_size - offset) >= map_threshold &&
+          update_mapped(fd)) {
+        return;
+      }
+    }
+    update_read(fd);
+  }
+
+  // write the hex-encoded digest to the buffer, which must hold at least
+  // max_hex_size bytes. returns the number of characters written
+  std::size_t finish(char* hex) {
+    unsigned char buffer[awssign::detail::digest::max_size];
+    const auto size = hash.finish(buffer);
+    char* pos = awssign::detail::hex_encode(buffer, buffer + size, hex);
+    return std::distance(hex, pos);
+  }
+};
+
+} // namespace awssign::v4
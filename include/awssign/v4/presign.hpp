@@ -9,6 +9,8 @@
 #include <awssign/v4/detail/canonical_request.hpp>
 #include <awssign/v4/detail/signing_key.hpp>
 #include <awssign/v4/detail/string_to_sign.hpp>
+#include <awssign/v4/hash_algorithm.hpp>
+#include <awssign/v4/signing_key.hpp>
 
 namespace awssign::v4 {
 
@@ -34,9 +36,10 @@ void write_credential(std::string_view access_key_id,
   write_scope(date, region, service, out);
 }
 
-template <typename HeaderIterator, // forward canonical_header iterator
+template <typename Hash, // sha256 or named_hash
+          typename HeaderIterator, // forward canonical_header iterator
           typename OutputStream>
-void write_signed_params(const char* hash_algorithm,
+void write_signed_params(const Hash& hash_algorithm,
                          std::string_view access_key_id,
                          std::string_view region,
                          std::string_view service,
@@ -52,8 +55,8 @@ void write_signed_params(const char* hash_algorithm,
   };
 
   // querystring += &X-Amz-Algorithm=algorithm
-  write("X-Amz-Algorithm=AWS4-HMAC-", out);
-  write(hash_algorithm, out);
+  write("X-Amz-Algorithm=", out);
+  hash_algorithm.write_signing_algorithm(out);
   // querystring += &X-Amz-Credential= urlencode(access_key_ID + '/' + credential_scope)
   write("&X-Amz-Credential=", out);
   write_credential(access_key_id, date, region, service,
@@ -103,56 +106,51 @@ class query_length_error : public std::length_error {
   constexpr std::size_t required_capacity() const { return capacity; }
 };
 
-// add query parameters to presign the given request. the caller must provide
-// additional capacity at the end of the query string. returns a pointer past
-// the last byte written, or throws a query_length_error exception that contains
-// the number of bytes of extra query string capacity required
-template <typename HeaderIterator> // forward canonical_header iterator
-char* presign(const char* hash_algorithm,
-              std::string_view access_key_id,
-              std::string_view secret_access_key,
-              std::string_view region,
-              std::string_view service,
-              std::string_view date,
-              std::string_view expiration,
-              std::string_view method,
-              std::string_view uri_path,
-              HeaderIterator header0,
-              HeaderIterator headerN,
-              std::string_view payload_hash,
-              char* query_begin,
-              char* query_end,
-              char* query_capacity)
+namespace detail {
+
+template <typename Hash, // sha256 or named_hash
+          typename HeaderIterator> // forward canonical_header iterator
+char* presign_request(const Hash& hash_algorithm,
+                      std::string_view access_key_id,
+                      const signing_key& key,
+                      std::string_view region,
+                      std::string_view service,
+                      std::string_view date,
+                      std::string_view expiration,
+                      std::string_view method,
+                      std::string_view uri_path,
+                      HeaderIterator header0,
+                      HeaderIterator headerN,
+                      std::string_view payload_hash,
+                      char* query_begin,
+                      char* query_end,
+                      char* query_capacity)
 {
+  constexpr std::size_t digest_size = Hash::digest_size;
+
   // stack-allocate an array of canonical_header[]
   const std::size_t header_count = std::distance(header0, headerN);
-  auto canonical_header0 = static_cast<detail::canonical_header*>(
-      ::alloca(header_count * sizeof(detail::canonical_header)));
+  auto canonical_header0 = static_cast<canonical_header*>(
+      ::alloca(header_count * sizeof(canonical_header)));
   // stable sort headers by canonical name
-  const auto canonical_headerN = detail::sorted_canonical_headers(
+  const auto canonical_headerN = sorted_canonical_headers(
       header0, headerN, canonical_header0);
 
   // append the presigned query params that are part of the canonical request
   auto query_stream = detail::query_stream(query_end, query_capacity);
   if (query_begin == query_end) {
-    detail::write('?', query_stream);
+    write('?', query_stream);
   } else {
-    detail::write('&', query_stream);
+    write('&', query_stream);
   }
-  detail::write_signed_params(hash_algorithm, access_key_id,
-                              region, service, date, expiration,
-                              canonical_header0, canonical_headerN,
-                              query_stream);
-
-  // generate the signing key
-  unsigned char signing_key[detail::hmac::max_size];
-  const int signing_key_size = detail::build_signing_key(
-      hash_algorithm, secret_access_key,
-      date, region, service, signing_key);
+  write_signed_params(hash_algorithm, access_key_id,
+                      region, service, date, expiration,
+                      canonical_header0, canonical_headerN,
+                      query_stream);
 
   // check that we have the capacity to write the signature param
   constexpr auto signature_param = std::string_view{"&X-Amz-Signature="};
-  const std::size_t signature_value_size = signing_key_size * 2; // hex encoded
+  const std::size_t signature_value_size = key.size() * 2; // hex encoded
   std::size_t required_capacity = query_stream.bytes +
       signature_param.size() + signature_value_size;
   if (required_capacity > query_stream.capacity) {
@@ -163,43 +161,152 @@ char* presign(const char* hash_algorithm,
   const auto query = std::string_view{query_begin, query_size};
 
   // generate the canonical request hash
-  char canonical_buffer[detail::digest::max_size * 2]; // hex encoded
+  char canonical_buffer[digest_size * 2]; // hex encoded
   std::string_view canonical_request_hash;
   {
-    auto hash = detail::digest{hash_algorithm};
-    detail::write_canonical_request(service, method, uri_path,
-                                    query.substr(1), // skip '?'
-                                    canonical_header0, canonical_headerN,
-                                    payload_hash,
-                                    detail::buffered_digest_stream(hash));
-    unsigned char buffer[detail::digest::max_size];
+    auto hash = digest{hash_algorithm.type()};
+    write_canonical_request(service, method, uri_path,
+                            query.substr(1), // skip '?'
+                            canonical_header0, canonical_headerN,
+                            payload_hash, buffered_digest_stream(hash));
+    unsigned char buffer[digest_size];
     const auto size = hash.finish(buffer);
-    char* pos = canonical_buffer;
-    detail::hex_encode(buffer, buffer + size, detail::output_stream{pos});
+    char* pos = hex_encode(buffer, buffer + size, canonical_buffer);
     const std::size_t len = std::distance(canonical_buffer, pos);
     canonical_request_hash = std::string_view{canonical_buffer, len};
   }
 
   // sign the string-to-sign
-  char signature_buffer[detail::hmac::max_size * 2]; // hex encoded
+  char signature_buffer[digest_size * 2]; // hex encoded
   std::string_view signature;
   {
-    auto hash = detail::hmac{hash_algorithm, signing_key, signing_key_size};
-    detail::write_string_to_sign(hash_algorithm, date, region, service,
-                                 canonical_request_hash,
-                                 detail::buffered_digest_stream(hash));
-    unsigned char buffer[detail::hmac::max_size];
+    auto hash = key.hmac();
+    write_string_to_sign(hash_algorithm, date, region, service,
+                         canonical_request_hash,
+                         buffered_digest_stream(hash));
+    unsigned char buffer[digest_size];
     const auto size = hash.finish(buffer);
-    char* pos = signature_buffer;
-    detail::hex_encode(buffer, buffer + size, detail::output_stream{pos});
+    char* pos = hex_encode(buffer, buffer + size, signature_buffer);
     const std::size_t len = std::distance(signature_buffer, pos);
     signature = std::string_view{signature_buffer, len};
   }
 
   // append the X-Amz-Signature param
-  detail::write(signature_param, query_stream);
-  detail::write(signature, query_stream);
+  write(signature_param, query_stream);
+  write(signature, query_stream);
   return query_stream.pos;
 }
 
+} // namespace detail
+
+// add query parameters to presign the given request with a signing key that
+// was derived for the same date, region and service. the caller must provide
+// additional capacity at the end of the query string. returns a pointer past
+// the last byte written, or throws a query_length_error exception that contains
+// the number of bytes of extra query string capacity required
+template <typename HeaderIterator> // forward canonical_header iterator
+char* presign(const char* hash_algorithm,
+              std::string_view access_key_id,
+              const signing_key& key,
+              std::string_view region,
+              std::string_view service,
+              std::string_view date,
+              std::string_view expiration,
+              std::string_view method,
+              std::string_view uri_path,
+              HeaderIterator header0,
+              HeaderIterator headerN,
+              std::string_view payload_hash,
+              char* query_begin,
+              char* query_end,
+              char* query_capacity)
+{
+  return detail::presign_request(detail::named_hash{hash_algorithm},
+                                 access_key_id, key, region, service, date,
+                                 expiration, method, uri_path,
+                                 header0, headerN, payload_hash,
+                                 query_begin, query_end, query_capacity);
+}
+
+// add query parameters to presign the given request. the caller must provide
+// additional capacity at the end of the query string. returns a pointer past
+// the last byte written, or throws a query_length_error exception that contains
+// the number of bytes of extra query string capacity required
+template <typename HeaderIterator> // forward canonical_header iterator
+char* presign(const char* hash_algorithm,
+              std::string_view access_key_id,
+              std::string_view secret_access_key,
+              std::string_view region,
+              std::string_view service,
+              std::string_view date,
+              std::string_view expiration,
+              std::string_view method,
+              std::string_view uri_path,
+              HeaderIterator header0,
+              HeaderIterator headerN,
+              std::string_view payload_hash,
+              char* query_begin,
+              char* query_end,
+              char* query_capacity)
+{
+  const auto key = make_signing_key(hash_algorithm, secret_access_key,
+                                    date, region, service);
+  return presign(hash_algorithm, access_key_id, key, region, service, date,
+                 expiration, method, uri_path, header0, headerN, payload_hash,
+                 query_begin, query_end, query_capacity);
+}
+
+// add query parameters to presign the given request with the given hash
+// algorithm tag and a signing key that was derived for the same date, region
+// and service. see presign() above for the handling of query capacity
+template <typename Hash, // sha256
+          typename HeaderIterator> // forward canonical_header iterator
+char* presign(std::string_view access_key_id,
+              const signing_key& key,
+              std::string_view region,
+              std::string_view service,
+              std::string_view date,
+              std::string_view expiration,
+              std::string_view method,
+              std::string_view uri_path,
+              HeaderIterator header0,
+              HeaderIterator headerN,
+              std::string_view payload_hash,
+              char* query_begin,
+              char* query_end,
+              char* query_capacity)
+{
+  return detail::presign_request(Hash{}, access_key_id, key, region, service,
+                                 date, expiration, method, uri_path,
+                                 header0, headerN, payload_hash,
+                                 query_begin, query_end, query_capacity);
+}
+
+// add query parameters to presign the given request with the given hash
+// algorithm tag. see presign() above for the handling of query capacity
+template <typename Hash, // sha256
+          typename HeaderIterator> // forward canonical_header iterator
+char* presign(std::string_view access_key_id,
+              std::string_view secret_access_key,
+              std::string_view region,
+              std::string_view service,
+              std::string_view date,
+              std::string_view expiration,
+              std::string_view method,
+              std::string_view uri_path,
+              HeaderIterator header0,
+              HeaderIterator headerN,
+              std::string_view payload_hash,
+              char* query_begin,
+              char* query_end,
+              char* query_capacity)
+{
+  const auto key = make_signing_key<Hash>(secret_access_key,
+                                          date, region, service);
+  return detail::presign_request(Hash{}, access_key_id, key, region, service,
+                                 date, expiration, method, uri_path,
+                                 header0, headerN, payload_hash,
+                                 query_begin, query_end, query_capacity);
+}
+
 } // namespace awssign::v4
@@ -1,13 +1,20 @@
 #pragma once
 
+#include <algorithm>
+#include <string>
+#include <type_traits>
+#include <vector>
 #include <awssign/detail/digest.hpp>
 #include <awssign/detail/digest_stream.hpp>
 #include <awssign/detail/hex_encode.hpp>
 #include <awssign/detail/output_stream.hpp>
+#include <awssign/detail/sha256_mb.hpp>
 #include <awssign/v4/detail/canonical_headers.hpp>
 #include <awssign/v4/detail/canonical_request.hpp>
 #include <awssign/v4/detail/signing_key.hpp>
 #include <awssign/v4/detail/string_to_sign.hpp>
+#include <awssign/v4/hash_algorithm.hpp>
+#include <awssign/v4/signing_key.hpp>
 
 namespace awssign::v4 {
 
@@ -19,33 +26,160 @@ using awssign::detail::hex_encode;
 using awssign::detail::hmac;
 using awssign::detail::output_stream;
 
-// write the Authorization header value
-template <typename HeaderIterator,
+// write the Authorization header value, where write_signed_headers(out)
+// writes the SignedHeaders
+template <typename Hash,
+          typename WriteSignedHeaders,
           typename OutputStream>
-void write_authorization_header_value(std::string_view hash_algorithm,
+void write_authorization_header_value(const Hash& hash_algorithm,
                                       std::string_view access_key_id,
                                       std::string_view date,
                                       std::string_view region,
                                       std::string_view service,
-                                      HeaderIterator canonical_header0,
-                                      HeaderIterator canonical_headerN,
+                                      WriteSignedHeaders&& write_signed_headers,
                                       std::string_view signature,
                                       OutputStream&& out)
 {
-  write("AWS4-HMAC-", out);
-  write(hash_algorithm, out);
+  hash_algorithm.write_signing_algorithm(out);
   write(" Credential=", out);
   write(access_key_id, out);
   write('/', out);
   write_scope(date, region, service, out);
   write(", SignedHeaders=", out);
-  write_signed_headers(canonical_header0, canonical_headerN, out);
+  write_signed_headers(out);
   write(", Signature=", out);
   write(signature, out);
 }
 
+// write the Authorization header value
+template <typename Hash,
+          typename HeaderIterator,
+          typename OutputStream>
+void write_authorization_header_value(const Hash& hash_algorithm,
+                                      std::string_view access_key_id,
+                                      std::string_view date,
+                                      std::string_view region,
+                                      std::string_view service,
+                                      HeaderIterator canonical_header0,
+                                      HeaderIterator canonical_headerN,
+                                      std::string_view signature,
+                                      OutputStream&& out)
+{
+  write_authorization_header_value(
+      hash_algorithm, access_key_id, date, region, service,
+      [&] (auto& stream) {
+        write_signed_headers(canonical_header0, canonical_headerN, stream);
+      }, signature, out);
+}
+
+// hash the canonical request that write_canonical_request(stream) writes,
+// sign the string-to-sign, and return the hex-encoded signature
+template <typename Hash, // sha256 or named_hash
+          typename WriteCanonicalRequest>
+std::string_view sign_canonical_request(const Hash& hash_algorithm,
+                                        const signing_key& key,
+                                        std::string_view date,
+                                        std::string_view region,
+                                        std::string_view service,
+                                        WriteCanonicalRequest&& write_canonical_request,
+                                        char* signature_buffer) // hex encoded
+{
+  constexpr std::size_t digest_size = Hash::digest_size;
+
+  // generate the canonical request hash
+  char canonical_buffer[digest_size * 2]; // hex encoded
+  std::string_view canonical_request_hash;
+  {
+    auto hash = digest{hash_algorithm.type()};
+    write_canonical_request(buffered_digest_stream(hash));
+    unsigned char buffer[digest_size];
+    const auto size = hash.finish(buffer);
+    char* pos = hex_encode(buffer, buffer + size, canonical_buffer);
+    const std::size_t len = std::distance(canonical_buffer, pos);
+    canonical_request_hash = std::string_view{canonical_buffer, len};
+  }
+
+  // sign the string-to-sign
+  auto hash = key.hmac();
+  write_string_to_sign(hash_algorithm, date, region, service,
+                       canonical_request_hash, buffered_digest_stream(hash));
+  unsigned char buffer[digest_size];
+  const auto size = hash.finish(buffer);
+  char* pos = hex_encode(buffer, buffer + size, signature_buffer);
+  const std::size_t len = std::distance(signature_buffer, pos);
+  return std::string_view{signature_buffer, len};
+}
+
+template <typename Hash, // sha256 or named_hash
+          typename HeaderIterator,
+          typename OutputStream>
+void sign_request(const Hash& hash_algorithm,
+                  std::string_view access_key_id,
+                  const signing_key& key,
+                  std::string_view method,
+                  std::string_view uri_path,
+                  std::string_view query,
+                  HeaderIterator header0,
+                  HeaderIterator headerN,
+                  std::string_view payload_hash,
+                  std::string_view date,
+                  std::string_view region,
+                  std::string_view service,
+                  OutputStream&& out)
+{
+  constexpr std::size_t digest_size = Hash::digest_size;
+
+  // stack-allocate an array of canonical_header[]
+  const std::size_t header_count = std::distance(header0, headerN);
+  auto canonical_header0 = static_cast<canonical_header*>(
+      ::alloca(header_count * sizeof(canonical_header)));
+  // stable sort headers by canonical name
+  const auto canonical_headerN = sorted_canonical_headers(
+      header0, headerN, canonical_header0);
+
+  char signature_buffer[digest_size * 2]; // hex encoded
+  const auto signature = sign_canonical_request(
+      hash_algorithm, key, date, region, service,
+      [&] (auto&& stream) {
+        write_canonical_request(service, method, uri_path, query,
+                                canonical_header0, canonical_headerN,
+                                payload_hash, stream);
+      }, signature_buffer);
+
+  // write the Authorization header value
+  return write_authorization_header_value(
+      hash_algorithm, access_key_id, date, region, service,
+      canonical_header0, canonical_headerN, signature, out);
+}
+
 } // namespace detail
 
+// generate a signature for the given request with a signing key that was
+// derived for the same date, region and service, and write the Authorization
+// header's value to output
+template <typename HeaderIterator,
+          typename OutputStream>
+void sign(const char* hash_algorithm,
+          std::string_view access_key_id,
+          const signing_key& key,
+          std::string_view method,
+          std::string_view uri_path,
+          std::string_view query,
+          HeaderIterator header0,
+          HeaderIterator headerN,
+          std::string_view payload_hash,
+          std::string_view date,
+          std::string_view region,
+          std::string_view service,
+          OutputStream&& out)
+{
+  return detail::sign_request(detail::named_hash{hash_algorithm},
+                              access_key_id, key, method, uri_path, query,
+                              header0, headerN, payload_hash,
+                              date, region, service,
+                              std::forward<OutputStream>(out));
+}
+
 // generate a signature for the given request, and write the Authorization
 // header's value to output
 template <typename HeaderIterator,
@@ -64,58 +198,224 @@ void sign(const char* hash_algorithm,
           std::string_view service,
           OutputStream&& out)
 {
-  // stack-allocate an array of canonical_header[]
-  const std::size_t header_count = std::distance(header0, headerN);
-  auto canonical_header0 = static_cast<detail::canonical_header*>(
-      ::alloca(header_count * sizeof(detail::canonical_header)));
-  // stable sort headers by canonical name
-  const auto canonical_headerN = detail::sorted_canonical_headers(
-      header0, headerN, canonical_header0);
+  const auto key = make_signing_key(hash_algorithm, secret_access_key,
+                                    date, region, service);
+  return sign(hash_algorithm, access_key_id, key, method, uri_path, query,
+              header0, headerN, payload_hash, date, region, service,
+              std::forward<OutputStream>(out));
+}
 
-  // generate the canonical request hash
-  char canonical_buffer[detail::digest::max_size * 2]; // hex encoded
-  std::string_view canonical_request_hash;
-  {
-    auto hash = detail::digest{hash_algorithm};
-    detail::write_canonical_request(service, method, uri_path, query,
-                                    canonical_header0, canonical_headerN,
-                                    payload_hash,
-                                    detail::buffered_digest_stream(hash));
-    unsigned char buffer[detail::digest::max_size];
-    const auto size = hash.finish(buffer);
-    char* pos = canonical_buffer;
-    detail::hex_encode(buffer, buffer + size, detail::output_stream{pos});
-    const std::size_t len = std::distance(canonical_buffer, pos);
-    canonical_request_hash = std::string_view{canonical_buffer, len};
+// generate a signature with the given hash algorithm tag and a signing key
+// that was derived for the same date, region and service, and write the
+// Authorization header's value to output
+template <typename Hash, // sha256
+          typename HeaderIterator,
+          typename OutputStream>
+void sign(std::string_view access_key_id,
+          const signing_key& key,
+          std::string_view method,
+          std::string_view uri_path,
+          std::string_view query,
+          HeaderIterator header0,
+          HeaderIterator headerN,
+          std::string_view payload_hash,
+          std::string_view date,
+          std::string_view region,
+          std::string_view service,
+          OutputStream&& out)
+{
+  return detail::sign_request(Hash{}, access_key_id, key, method, uri_path,
+                              query, header0, headerN, payload_hash,
+                              date, region, service,
+                              std::forward<OutputStream>(out));
+}
+
+// generate a signature with the given hash algorithm tag, and write the
+// Authorization header's value to output
+template <typename Hash, // sha256
+          typename HeaderIterator,
+          typename OutputStream>
+void sign(std::string_view access_key_id,
+          std::string_view secret_access_key,
+          std::string_view method,
+          std::string_view uri_path,
+          std::string_view query,
+          HeaderIterator header0,
+          HeaderIterator headerN,
+          std::string_view payload_hash,
+          std::string_view date,
+          std::string_view region,
+          std::string_view service,
+          OutputStream&& out)
+{
+  const auto key = make_signing_key<Hash>(secret_access_key,
+                                          date, region, service);
+  return detail::sign_request(Hash{}, access_key_id, key, method, uri_path,
+                              query, header0, headerN, payload_hash,
+                              date, region, service,
+                              std::forward<OutputStream>(out));
+}
+
+// a request for sign_batch()
+template <typename HeaderIterator,
+          typename OutputStream>
+struct sign_batch_request {
+  std::string_view method;
+  std::string_view uri_path;
+  std::string_view query;
+  HeaderIterator header0;
+  HeaderIterator headerN;
+  std::string_view payload_hash;
+  std::string_view date; // on the day that the signing key was derived for
+  OutputStream out; // receives the Authorization header's value
+};
+
+namespace detail {
+
+template <bool S3,
+          typename HeaderIterator,
+          typename OutputStream>
+void sign_batch(std::bool_constant<S3> s3,
+                std::string_view access_key_id,
+                const signing_key& key,
+                std::string_view region,
+                std::string_view service,
+                sign_batch_request<HeaderIterator, OutputStream>* begin,
+                sign_batch_request<HeaderIterator, OutputStream>* end)
+{
+  using awssign::detail::sha256_hmac;
+  using awssign::detail::sha256_hmac_job;
+  using awssign::detail::sha256_job;
+  constexpr std::size_t batch_size = 64;
+  constexpr std::size_t digest_size = sha256::digest_size;
+
+  // every request shares the key's pad states, and the scratch memory for
+  // canonical headers and hash input is reused for each group of requests
+  const auto prototype = sha256_hmac{key.data(), static_cast<int>(key.size())};
+  std::string arena; // canonical requests, then strings to sign
+  std::vector<canonical_header> headers;
+  std::vector<canonical_header> scratch; // for sorting
+  std::size_t offsets[batch_size + 1];
+  std::size_t header_offsets[batch_size + 1];
+  unsigned char digests[batch_size][digest_size];
+  sha256_job jobs[batch_size];
+  sha256_hmac_job hmac_jobs[batch_size];
+
+  auto append = [&arena] (const char* begin, const char* end) {
+    arena.append(begin, end);
+  };
+
+  while (begin != end) {
+    const std::size_t count = std::min<std::size_t>(
+        std::distance(begin, end), batch_size);
+
+    // hash the canonical requests
+    arena.clear();
+    headers.clear();
+    for (std::size_t i = 0; i < count; i++) {
+      const auto& r = begin[i];
+      header_offsets[i] = headers.size();
+      const std::size_t header_count = std::distance(r.header0, r.headerN);
+      headers.resize(headers.size() + header_count);
+      if (scratch.size() < header_count) {
+        scratch.resize(header_count);
+      }
+      const auto canonical_header0 = headers.data() + header_offsets[i];
+      const auto canonical_headerN = sorted_canonical_headers(
+          r.header0, r.headerN, canonical_header0, scratch.data());
+      offsets[i] = arena.size();
+      write_canonical_request(s3, r.method, r.uri_path, r.query,
+                              canonical_header0, canonical_headerN,
+                              r.payload_hash, append);
+    }
+    header_offsets[count] = headers.size();
+    offsets[count] = arena.size();
+    for (std::size_t i = 0; i < count; i++) {
+      jobs[i] = sha256_job{arena.data() + offsets[i],
+                           offsets[i + 1] - offsets[i], digests[i]};
+    }
+    awssign::detail::sha256_multi(jobs, jobs + count);
+
+    // write the strings to sign
+    arena.clear();
+    for (std::size_t i = 0; i < count; i++) {
+      char hex[digest_size * 2];
+      hex_encode(digests[i], digests[i] + digest_size, hex);
+      offsets[i] = arena.size();
+      write_string_to_sign(sha256{}, begin[i].date, region, service,
+                           std::string_view{hex, sizeof(hex)}, append);
+    }
+    offsets[count] = arena.size();
+
+    // sign them and write the Authorization header values
+    for (std::size_t i = 0; i < count; i++) {
+      hmac_jobs[i] = sha256_hmac_job{&prototype, arena.data() + offsets[i],
+                                     offsets[i + 1] - offsets[i], digests[i]};
+    }
+    awssign::detail::sha256_hmac_multi(hmac_jobs, hmac_jobs + count);
+    for (std::size_t i = 0; i < count; i++) {
+      auto& r = begin[i];
+      char hex[digest_size * 2];
+      hex_encode(digests[i], digests[i] + digest_size, hex);
+      write_authorization_header_value(
+          sha256{}, access_key_id, r.date, region, service,
+          headers.data() + header_offsets[i],
+          headers.data() + header_offsets[i + 1],
+          std::string_view{hex, sizeof(hex)}, r.out);
+    }
+    begin += count;
   }
+}
 
-  // generate the signing key
-  unsigned char signing_key[detail::hmac::max_size];
-  const int signing_key_size = detail::build_signing_key(
-      hash_algorithm, secret_access_key,
-      date, region, service,
-      signing_key);
+} // namespace detail
 
-  // sign the string-to-sign
-  char signature_buffer[detail::hmac::max_size * 2]; // hex encoded
-  std::string_view signature;
-  {
-    auto hash = detail::hmac{hash_algorithm, signing_key, signing_key_size};
-    detail::write_string_to_sign(hash_algorithm, date, region, service,
-                                 canonical_request_hash,
-                                 detail::buffered_digest_stream(hash));
-    unsigned char buffer[detail::hmac::max_size];
-    const auto size = hash.finish(buffer);
-    char* pos = signature_buffer;
-    detail::hex_encode(buffer, buffer + size, detail::output_stream{pos});
-    const std::size_t len = std::distance(signature_buffer, pos);
-    signature = std::string_view{signature_buffer, len};
+// sign a batch of requests for the same credential scope with the multi-buffer
+// sha256 engine, and write each Authorization header's value to the request's
+// output stream. only the sha256 tag is supported
+template <typename Hash, // sha256
+          typename HeaderIterator,
+          typename OutputStream>
+void sign_batch(std::string_view access_key_id,
+                const signing_key& key,
+                std::string_view region,
+                std::string_view service,
+                sign_batch_request<HeaderIterator, OutputStream>* begin,
+                sign_batch_request<HeaderIterator, OutputStream>* end)
+{
+  static_assert(std::is_same_v<Hash, sha256>,
+                "the multi-buffer engine only implements sha256");
+  if (service == "s3") {
+    detail::sign_batch(std::true_type{}, access_key_id, key,
+                       region, service, begin, end);
+  } else {
+    detail::sign_batch(std::false_type{}, access_key_id, key,
+                       region, service, begin, end);
   }
+}
 
-  // write the Authorization header value
-  return detail::write_authorization_header_value(
-      hash_algorithm, access_key_id, date, region, service,
-      canonical_header0, canonical_headerN, signature, out);
+// sign a batch of requests for the same region and service, deriving the
+// signing key once for each run of requests with the same YYYYMMDD date. a
+// batch that crosses midnight derives a second key
+template <typename Hash, // sha256
+          typename HeaderIterator,
+          typename OutputStream>
+void sign_batch(std::string_view access_key_id,
+                std::string_view secret_access_key,
+                std::string_view region,
+                std::string_view service,
+                sign_batch_request<HeaderIterator, OutputStream>* begin,
+                sign_batch_request<HeaderIterator, OutputStream>* end)
+{
+  while (begin != end) {
+    const auto day = begin->date.substr(0, 8);
+    const auto run_end = std::find_if(begin, end, [day] (const auto& r) {
+        return r.date.substr(0, 8) != day;
+      });
+    const auto key = make_signing_key<Hash>(secret_access_key, begin->date,
+                                            region, service);
+    sign_batch<Hash>(access_key_id, key, region, service, begin, run_end);
+    begin = run_end;
+  }
 }
 
 } // namespace awssign::v4
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <string_view>
+#include <type_traits>
+#include <awssign/v4/detail/signing_key.hpp>
+
+namespace awssign::v4 {
+
+// a signing key that was derived from the secret access key for a specific
+// date, region and service. a signing key can be reused for any request that
+// is signed with the same hash algorithm and credential scope
+class signing_key {
+  unsigned char key[detail::hmac::max_size];
+  std::size_t key_size;
+  // an hmac that was initialized with the key. each signature starts from a
+  // copy of this prototype, so the key's pads are only hashed once
+  detail::hmac prototype;
+
+  template <typename Hash>
+  static detail::hmac make_prototype(const Hash& hash_algorithm,
+                                     const unsigned char* key,
+                                     std::size_t key_size)
+  {
+    return detail::hmac{hash_algorithm.type(), key,
+                        static_cast<int>(key_size)};
+  }
+ public:
+  template <typename Hash, // sha256 or named_hash
+            typename = std::enable_if_t<detail::is_hash_algorithm_v<Hash>>>
+  signing_key(const Hash& hash_algorithm,
+              std::string_view secret_access_key,
+              std::string_view date,
+              std::string_view region,
+              std::string_view service)
+      : key_size(detail::build_signing_key(hash_algorithm, secret_access_key,
+                                           date, region, service, key)),
+        prototype(make_prototype(hash_algorithm, key, key_size))
+  {}
+  signing_key(const char* hash_algorithm,
+              std::string_view secret_access_key,
+              std::string_view date,
+              std::string_view region,
+              std::string_view service)
+      : signing_key(detail::named_hash{hash_algorithm}, secret_access_key,
+                    date, region, service)
+  {}
+
+  // wrap a signing key that was already derived with the given algorithm
+  template <typename Hash, // sha256 or named_hash
+            typename = std::enable_if_t<detail::is_hash_algorithm_v<Hash>>>
+  signing_key(const Hash& hash_algorithm,
+              const unsigned char* data,
+              std::size_t size)
+      : key_size(std::min(size, sizeof(key))),
+        prototype(make_prototype(hash_algorithm, data, key_size))
+  {
+    std::copy_n(data, key_size, key);
+  }
+
+  const unsigned char* data() const { return key; }
+  std::size_t size() const { return key_size; }
+
+  // return an hmac that is ready to sign with this key
+  detail::hmac hmac() const { return prototype; }
+};
+
+// derive the signing key for the given credential scope
+template <typename Hash> // sha256
+signing_key make_signing_key(std::string_view secret_access_key,
+                             std::string_view date,
+                             std::string_view region,
+                             std::string_view service)
+{
+  return {Hash{}, secret_access_key, date, region, service};
+}
+
+// derive the signing key for the given credential scope
+inline signing_key make_signing_key(const char* hash_algorithm,
+                                    std::string_view secret_access_key,
+                                    std::string_view date,
+                                    std::string_view region,
+                                    std::string_view service)
+{
+  return {hash_algorithm, secret_access_key, date, region, service};
+}
+
+// a credential scope for make_signing_keys()
+struct signing_key_scope {
+  std::string_view secret_access_key;
+  std::string_view date;
+  std::string_view region;
+  std::string_view service;
+};
+
+// derive the signing keys for a range of credential scopes (for example,
+// signing_key_scope) with the multi-buffer sha256 engine, and write them to
+// the output iterator. only the sha256 tag is supported
+template <typename Hash, // sha256
+          typename ScopeIterator,
+          typename OutputIterator>
+OutputIterator make_signing_keys(ScopeIterator begin,
+                                 ScopeIterator end,
+                                 OutputIterator out)
+{
+  static_assert(std::is_same_v<Hash, sha256>,
+                "the multi-buffer engine only implements sha256");
+  constexpr std::size_t batch_size = 64;
+  unsigned char keys[batch_size * sha256::digest_size];
+  while (begin != end) {
+    auto batch_end = begin;
+    std::size_t count = 0;
+    for (; batch_end != end && count < batch_size; ++batch_end, ++count) {}
+    detail::build_signing_keys(Hash{}, begin, batch_end, keys);
+    for (std::size_t i = 0; i < count; i++) {
+      *out++ = signing_key{Hash{}, keys + i * sha256::digest_size,
+                           sha256::digest_size};
+    }
+    begin = batch_end;
+  }
+  return out;
+}
+
+} // namespace awssign::v4
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string_view>
+#include <awssign/detail/sharded_cache.hpp>
+#include <awssign/v4/signing_key.hpp>
+
+namespace awssign::v4 {
+
+// a bounded, thread-safe cache of derived signing keys. entries are spread
+// over independently-locked shards to limit contention between threads, and
+// each shard evicts entries with the CLOCK algorithm once it reaches capacity
+//
+// example:
+//
+//   auto cache = signing_key_cache{1024};
+//   ...
+//   const auto key = cache.get("SHA256", secret_access_key,
+//                              date, region, service);
+//   bool ok = verify("SHA256", date, region, service, signed_headers,
+//                    method, uri_path, query, header0, headerN,
+//                    payload_hash, key, signature);
+//
+class signing_key_cache {
+  awssign::detail::sharded_cache<signing_key> cache;
+
+  template <typename Hash>
+  signing_key lookup(const Hash& hash_algorithm,
+                     std::string_view name,
+                     std::string_view secret_access_key,
+                     std::string_view date,
+                     std::string_view region,
+                     std::string_view service)
+  {
+    // the secret is included so that a rotated secret can never return a
+    // stale key, and only the YYYYMMDD part of the date is
+    const auto key = awssign::detail::make_cache_key({
+        name, secret_access_key, date.substr(0, 8), region, service});
+    // copy the key and its hmac context outside of the cache's lock
+    return *cache.get(key, [&] {
+        return signing_key{hash_algorithm, secret_access_key,
+                           date, region, service};
+      });
+  }
+ public:
+  // construct a cache that holds up to 'capacity' signing keys, divided
+  // evenly between 'shard_count' shards
+  explicit signing_key_cache(std::size_t capacity,
+                             std::size_t shard_count = 16)
+      : cache(capacity, shard_count)
+  {}
+
+  // return the signing key for the given credential scope. on a cache miss,
+  // the key is derived and inserted into the cache
+  signing_key get(const char* hash_algorithm,
+                  std::string_view secret_access_key,
+                  std::string_view date,
+                  std::string_view region,
+                  std::string_view service)
+  {
+    return lookup(detail::named_hash{hash_algorithm}, hash_algorithm,
+                  secret_access_key, date, region, service);
+  }
+
+  // return the signing key for the given hash algorithm tag and credential
+  // scope. on a cache miss, the key is derived and inserted into the cache
+  template <typename Hash> // sha256
+  signing_key get(std::string_view secret_access_key,
+                  std::string_view date,
+                  std::string_view region,
+                  std::string_view service)
+  {
+    return lookup(Hash{}, Hash::name, secret_access_key,
+                  date, region, service);
+  }
+
+  // remove all entries from the cache
+  void clear() { cache.clear(); }
+
+  // return the maximum number of cached entries
+  std::size_t capacity() const { return cache.capacity(); }
+};
+
+} // namespace awssign::v4
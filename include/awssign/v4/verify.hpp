@@ -1,14 +1,21 @@
 #pragma once
 
+#include <string>
+#include <vector>
+#include <openssl/crypto.h>
 #include <awssign/detail/digest.hpp>
 #include <awssign/detail/digest_stream.hpp>
+#include <awssign/detail/hex_decode.hpp>
 #include <awssign/detail/hex_encode.hpp>
 #include <awssign/detail/output_stream.hpp>
+#include <awssign/detail/sha256_mb.hpp>
 #include <awssign/v4/detail/canonical_headers.hpp>
 #include <awssign/v4/detail/canonical_request.hpp>
-#include <awssign/v4/detail/signed_header_iterator.hpp>
+#include <awssign/v4/detail/signed_headers.hpp>
 #include <awssign/v4/detail/signing_key.hpp>
 #include <awssign/v4/detail/string_to_sign.hpp>
+#include <awssign/v4/hash_algorithm.hpp>
+#include <awssign/v4/signing_key.hpp>
 
 namespace awssign::v4 {
 
@@ -16,12 +23,156 @@ namespace detail {
 
 using awssign::detail::buffered_digest_stream;
 using awssign::detail::digest;
+using awssign::detail::hex_decode;
 using awssign::detail::hex_encode;
 using awssign::detail::hmac;
 using awssign::detail::output_stream;
 
+// decode a hex signature of up to max_size bytes, and return its size. returns
+// 0 if the signature is empty, too long, or not lowercase hex
+inline std::size_t decode_signature(std::string_view signature,
+                                    unsigned char* buffer,
+                                    std::size_t max_size)
+{
+  if (signature.empty() || signature.size() > 2 * max_size ||
+      !hex_decode(signature.data(), signature.data() + signature.size(),
+                  buffer)) {
+    return 0;
+  }
+  return signature.size() / 2;
+}
+
+// compare the computed digest with the decoded signature in constant time
+inline bool signature_equal(const unsigned char* digest, std::size_t size,
+                            const unsigned char* signature,
+                            std::size_t signature_size)
+{
+  return size == signature_size &&
+      ::CRYPTO_memcmp(digest, signature, size) == 0;
+}
+
+// write the canonical request, including only the headers whose names are
+// in signed_headers. returns false without writing anything if
+// signed_headers lists more than max_missing_signed_headers names beyond the
+// number of headers
+template <typename HeaderIterator,
+          typename OutputStream>
+bool write_signed_canonical_request(std::string_view service,
+                                    std::string_view signed_headers,
+                                    std::string_view method,
+                                    std::string_view uri_path,
+                                    std::string_view query,
+                                    HeaderIterator header0,
+                                    HeaderIterator headerN,
+                                    std::string_view payload_hash,
+                                    OutputStream&& out)
+{
+  const std::size_t header_count = std::distance(header0, headerN);
+  const std::size_t name_count = max_signed_headers(signed_headers);
+  if (name_count > header_count + max_missing_signed_headers) {
+    return false;
+  }
+
+  // stack-allocate an array of canonical_header[]
+  auto canonical_header0 = static_cast<canonical_header*>(
+      ::alloca(header_count * sizeof(canonical_header)));
+  // stable sort headers by canonical name
+  const auto canonical_headerN = sorted_canonical_headers(
+      header0, headerN, canonical_header0);
+
+  // parse signed_headers once, and merge it with the sorted headers to
+  // drop the ones that aren't signed
+  auto name0 = static_cast<signed_header_name*>(
+      ::alloca(name_count * sizeof(signed_header_name)));
+  const auto nameN = parse_signed_headers(signed_headers, name0);
+  const auto signed_headerN = select_signed_headers(
+      canonical_header0, canonical_headerN, name0, nameN);
+
+  write_canonical_request(service, method, uri_path, query,
+                          canonical_header0, signed_headerN,
+                          payload_hash, out);
+  return true;
+}
+
+template <typename Hash, // sha256 or named_hash
+          typename HeaderIterator>
+bool verify_request(const Hash& hash_algorithm,
+                    std::string_view date,
+                    std::string_view region,
+                    std::string_view service,
+                    std::string_view signed_headers,
+                    std::string_view method,
+                    std::string_view uri_path,
+                    std::string_view query,
+                    HeaderIterator header0,
+                    HeaderIterator headerN,
+                    std::string_view payload_hash,
+                    const signing_key& key,
+                    std::string_view signature)
+{
+  constexpr std::size_t digest_size = Hash::digest_size;
+
+  // decode the signature first, so malformed signatures are rejected
+  // without hashing anything
+  unsigned char expected[digest_size];
+  const auto expected_size = decode_signature(signature, expected,
+                                              digest_size);
+  if (expected_size == 0) {
+    return false;
+  }
+
+  // generate the canonical request hash
+  char canonical_buffer[digest_size * 2]; // hex encoded
+  std::string_view canonical_request_hash;
+  {
+    auto hash = digest{hash_algorithm.type()};
+    if (!write_signed_canonical_request(service, signed_headers, method,
+                                        uri_path, query, header0, headerN,
+                                        payload_hash,
+                                        buffered_digest_stream(hash))) {
+      return false;
+    }
+    unsigned char buffer[digest_size];
+    const auto size = hash.finish(buffer);
+    char* pos = hex_encode(buffer, buffer + size, canonical_buffer);
+    const std::size_t len = std::distance(canonical_buffer, pos);
+    canonical_request_hash = std::string_view{canonical_buffer, len};
+  }
+
+  // sign the string-to-sign, and compare the raw digests
+  auto hash = key.hmac();
+  write_string_to_sign(hash_algorithm, date, region, service,
+                       canonical_request_hash, buffered_digest_stream(hash));
+  unsigned char buffer[digest_size];
+  const auto size = hash.finish(buffer);
+  return signature_equal(buffer, size, expected, expected_size);
+}
+
 } // namespace detail
 
+// verify that the signature matches what we generate for the given request,
+// using a signing key that was derived for the same date, region and service
+template <typename HeaderIterator>
+bool verify(const char* hash_algorithm,
+            std::string_view date,
+            std::string_view region,
+            std::string_view service,
+            std::string_view signed_headers,
+            std::string_view method,
+            std::string_view uri_path,
+            std::string_view query,
+            HeaderIterator header0,
+            HeaderIterator headerN,
+            std::string_view payload_hash,
+            const signing_key& key,
+            std::string_view signature)
+{
+  return detail::verify_request(detail::named_hash{hash_algorithm},
+                                date, region, service, signed_headers,
+                                method, uri_path, query, header0, headerN,
+                                payload_hash, key, signature);
+}
+
 // verify that the signature matches what we generate for the given request
 template <typename HeaderIterator>
 bool verify(const char* hash_algorithm,
@@ -38,57 +189,176 @@ bool verify(const char* hash_algorithm,
             std::string_view secret_access_key,
             std::string_view signature)
 {
-  // stack-allocate an array of canonical_header[]
-  const std::size_t header_count = std::distance(header0, headerN);
-  auto canonical_header0 = static_cast<detail::canonical_header*>(
-      ::alloca(header_count * sizeof(detail::canonical_header)));
-  // stable sort headers by canonical name
-  const auto canonical_headerN = detail::sorted_canonical_headers(
-      header0, headerN, canonical_header0);
+  const auto key = make_signing_key(hash_algorithm, secret_access_key,
+                                    date, region, service);
+  return verify(hash_algorithm, date, region, service, signed_headers,
+                method, uri_path, query, header0, headerN,
+                payload_hash, key, signature);
+}
 
-  // use a special header iterator for canonical_request() that filters
-  // out headers whose names aren't in signed_headers
-  auto filtered_header0 = detail::make_signed_header_iterator(
-      signed_headers, canonical_header0, canonical_headerN);
-  auto filtered_headerN = detail::signed_header_iterator<
-      detail::canonical_header*>{}; // end iterator
+// verify the signature with the given hash algorithm tag, using a signing key
+// that was derived for the same date, region and service
+template <typename Hash, // sha256
+          typename HeaderIterator>
+bool verify(std::string_view date,
+            std::string_view region,
+            std::string_view service,
+            std::string_view signed_headers,
+            std::string_view method,
+            std::string_view uri_path,
+            std::string_view query,
+            HeaderIterator header0,
+            HeaderIterator headerN,
+            std::string_view payload_hash,
+            const signing_key& key,
+            std::string_view signature)
+{
+  return detail::verify_request(Hash{}, date, region, service, signed_headers,
+                                method, uri_path, query, header0, headerN,
+                                payload_hash, key, signature);
+}
 
-  // generate the canonical request hash
-  char canonical_buffer[detail::digest::max_size * 2]; // hex encoded
-  std::string_view canonical_request_hash;
-  {
-    auto hash = detail::digest{hash_algorithm};
-    detail::write_canonical_request(service, method, uri_path, query,
-                                    filtered_header0, filtered_headerN,
-                                    payload_hash,
-                                    detail::buffered_digest_stream(hash));
-    unsigned char buffer[detail::digest::max_size];
-    const auto size = hash.finish(buffer);
-    char* pos = canonical_buffer;
-    detail::hex_encode(buffer, buffer + size, detail::output_stream{pos});
-    const std::size_t len = std::distance(canonical_buffer, pos);
-    canonical_request_hash = std::string_view{canonical_buffer, len};
-  }
+// verify the signature with the given hash algorithm tag
+template <typename Hash, // sha256
+          typename HeaderIterator>
+bool verify(std::string_view date,
+            std::string_view region,
+            std::string_view service,
+            std::string_view signed_headers,
+            std::string_view method,
+            std::string_view uri_path,
+            std::string_view query,
+            HeaderIterator header0,
+            HeaderIterator headerN,
+            std::string_view payload_hash,
+            std::string_view secret_access_key,
+            std::string_view signature)
+{
+  const auto key = make_signing_key<Hash>(secret_access_key,
+                                          date, region, service);
+  return detail::verify_request(Hash{}, date, region, service, signed_headers,
+                                method, uri_path, query, header0, headerN,
+                                payload_hash, key, signature);
+}
 
-  // generate the signing key
-  unsigned char signing_key[detail::hmac::max_size];
-  const int signing_key_size = detail::build_signing_key(
-      hash_algorithm, secret_access_key,
-      date, region, service, signing_key);
-
-  // sign the string-to-sign
-  char signature_buffer[detail::hmac::max_size * 2]; // hex encoded
-  auto hash = detail::hmac{hash_algorithm, signing_key, signing_key_size};
-  detail::write_string_to_sign(hash_algorithm, date, region, service,
-                               canonical_request_hash,
-                               detail::buffered_digest_stream(hash));
-  unsigned char buffer[detail::hmac::max_size];
-  const auto size = hash.finish(buffer);
-  char* pos = signature_buffer;
-  detail::hex_encode(buffer, buffer + size, detail::output_stream{pos});
-  const std::size_t len = std::distance(signature_buffer, pos);
+// a request for verify_batch()
+template <typename HeaderIterator>
+struct verify_batch_request {
+  std::string_view date;
+  std::string_view region;
+  std::string_view service;
+  std::string_view signed_headers;
+  std::string_view method;
+  std::string_view uri_path;
+  std::string_view query;
+  HeaderIterator header0;
+  HeaderIterator headerN;
+  std::string_view payload_hash;
+  const signing_key* key; // derived for the request's credential scope
+  std::string_view signature;
+};
+
+// verify a batch of requests with the multi-buffer sha256 engine, which hashes
+// several requests side by side in simd lanes. writes true to results[i] if
+// the signature of request i matches. only the sha256 tag is supported
+template <typename Hash, // sha256
+          typename HeaderIterator>
+void verify_batch(const verify_batch_request<HeaderIterator>* begin,
+                  const verify_batch_request<HeaderIterator>* end,
+                  bool* results)
+{
+  static_assert(std::is_same_v<Hash, sha256>,
+                "the multi-buffer engine only implements sha256");
+  using awssign::detail::sha256_hmac;
+  using awssign::detail::sha256_hmac_job;
+  using awssign::detail::sha256_job;
+  constexpr std::size_t batch_size = 64;
+  constexpr std::size_t digest_size = sha256::digest_size;
 
-  return signature == std::string_view{signature_buffer, len};
+  std::string arena; // canonical requests, then strings to sign
+  std::size_t offsets[batch_size + 1];
+  unsigned char digests[batch_size][digest_size];
+  unsigned char expected[batch_size][digest_size]; // decoded signatures
+  std::size_t expected_sizes[batch_size];
+  sha256_job jobs[batch_size];
+  sha256_hmac_job hmac_jobs[batch_size];
+  // requests that share a signing key share its pad states
+  std::vector<sha256_hmac> keys;
+  keys.reserve(batch_size);
+  std::size_t key_index[batch_size];
+  std::size_t live[batch_size]; // the requests that are hashed
+
+  auto append = [&arena] (const char* begin, const char* end) {
+    arena.append(begin, end);
+  };
+
+  while (begin != end) {
+    const std::size_t count = std::min<std::size_t>(
+        std::distance(begin, end), batch_size);
+
+    // hash the canonical requests. requests that can't match are rejected
+    // here and left out of the jobs
+    arena.clear();
+    std::size_t live_count = 0;
+    for (std::size_t i = 0; i < count; i++) {
+      const auto& r = begin[i];
+      results[i] = false;
+      expected_sizes[i] = detail::decode_signature(r.signature,
+                                                   expected[i], digest_size);
+      if (expected_sizes[i] == 0) {
+        continue;
+      }
+      const std::size_t offset = arena.size();
+      if (!detail::write_signed_canonical_request(r.service, r.signed_headers,
+                                                  r.method, r.uri_path,
+                                                  r.query, r.header0,
+                                                  r.headerN, r.payload_hash,
+                                                  append)) {
+        arena.resize(offset);
+        continue;
+      }
+      offsets[live_count] = offset;
+      live[live_count++] = i;
+    }
+    offsets[live_count] = arena.size();
+    for (std::size_t j = 0; j < live_count; j++) {
+      jobs[j] = sha256_job{arena.data() + offsets[j],
+                           offsets[j + 1] - offsets[j], digests[j]};
+    }
+    awssign::detail::sha256_multi(jobs, jobs + live_count);
+
+    // write the strings to sign
+    arena.clear();
+    keys.clear();
+    for (std::size_t j = 0; j < live_count; j++) {
+      const auto& r = begin[live[j]];
+      char hex[digest_size * 2];
+      detail::hex_encode(digests[j], digests[j] + digest_size, hex);
+      offsets[j] = arena.size();
+      detail::write_string_to_sign(Hash{}, r.date, r.region, r.service,
+                                   std::string_view{hex, sizeof(hex)}, append);
+      if (j == 0 || r.key != begin[live[j - 1]].key) {
+        keys.emplace_back(r.key->data(), static_cast<int>(r.key->size()));
+      }
+      key_index[j] = keys.size() - 1;
+    }
+    offsets[live_count] = arena.size();
+
+    // sign them and compare
+    for (std::size_t j = 0; j < live_count; j++) {
+      hmac_jobs[j] = sha256_hmac_job{&keys[key_index[j]],
+                                     arena.data() + offsets[j],
+                                     offsets[j + 1] - offsets[j], digests[j]};
+    }
+    awssign::detail::sha256_hmac_multi(hmac_jobs, hmac_jobs + live_count);
+    for (std::size_t j = 0; j < live_count; j++) {
+      const std::size_t i = live[j];
+      results[i] = detail::signature_equal(digests[j], digest_size,
+                                           expected[i], expected_sizes[i]);
+    }
+    begin += count;
+    results += count;
+  }
 }
 
 } // namespace awssign::v4
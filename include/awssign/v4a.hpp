@@ -0,0 +1,6 @@
+#pragma once
+
+#include <awssign/v4a/key.hpp>
+#include <awssign/v4a/key_cache.hpp>
+#include <awssign/v4a/sign.hpp>
+#include <awssign/v4a/verify.hpp>
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <openssl/ec.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <awssign/detail/digest.hpp>
+#include <awssign/v4/hash_algorithm.hpp>
+
+namespace awssign::v4a::detail {
+
+using awssign::detail::make_digest_error;
+
+// the size of a p-256 private scalar, and of each public coordinate
+inline constexpr std::size_t scalar_size = 32;
+// an uncompressed public point: 0x04, x and y
+inline constexpr std::size_t point_size = 1 + 2 * scalar_size;
+// the largest DER-encoded ECDSA-Sig-Value for p-256
+inline constexpr std::size_t max_signature_size = 72;
+
+// a reference-counted EVP_PKEY. copies share the key, which openssl allows
+// to be used for signing and verification from several threads at once
+class pkey {
+  ::EVP_PKEY* key = nullptr;
+ public:
+  pkey() = default;
+  explicit pkey(::EVP_PKEY* key) noexcept : key(key) {}
+  ~pkey() {
+    ::EVP_PKEY_free(key);
+  }
+  pkey(const pkey& o) noexcept : key(o.key) {
+    if (key) {
+      ::EVP_PKEY_up_ref(key);
+    }
+  }
+  pkey& operator=(const pkey& o) noexcept {
+    pkey tmp{o};
+    std::swap(key, tmp.key);
+    return *this;
+  }
+  pkey(pkey&& o) noexcept : key(std::exchange(o.key, nullptr)) {}
+  pkey& operator=(pkey&& o) noexcept {
+    std::swap(key, o.key);
+    return *this;
+  }
+
+  ::EVP_PKEY* get() const { return key; }
+};
+
+// the order of p-256 minus 2, big-endian
+inline constexpr unsigned char order_minus_two[scalar_size] = {
+  0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xbc, 0xe6, 0xfa, 0xad, 0xa7, 0x17, 0x9e, 0x84,
+  0xf3, 0xb9, 0xca, 0xc2, 0xfc, 0x63, 0x25, 0x4f,
+};
+
+// derive the private scalar from the credentials. this is the NIST SP 800-108
+// counter-mode KDF with HMAC-SHA256, whose fixed input is:
+//
+//   00000001 || "AWS4-ECDSA-P256-SHA256" || 00 || access_key_id || counter
+//     || 00000100
+//
+// with the key "AWS4A" || secret_access_key. a candidate c that's greater
+// than n-2 is rejected and the counter is incremented, otherwise the scalar
+// is c+1 so that it falls in [1, n-1]
+inline void derive_private_scalar(std::string_view access_key_id,
+                                  std::string_view secret_access_key,
+                                  unsigned char* scalar)
+{
+  constexpr std::string_view label = "AWS4-ECDSA-P256-SHA256";
+  auto key = std::string{"AWS4A"};
+  key.append(secret_access_key);
+  const auto prototype = awssign::detail::hmac{
+      v4::sha256::type(), reinterpret_cast<const unsigned char*>(key.data()),
+      static_cast<int>(key.size())};
+
+  for (unsigned counter = 1; counter < 255; counter++) {
+    auto hash = prototype;
+    const unsigned char one[] = {0, 0, 0, 1};
+    hash.update(one, sizeof(one));
+    hash.update(label.data(), label.size());
+    hash.update("", 1);
+    hash.update(access_key_id.data(), access_key_id.size());
+    const unsigned char tail[] = {static_cast<unsigned char>(counter),
+                                  0, 0, 1, 0}; // counter, then 256 bits
+    hash.update(tail, sizeof(tail));
+    unsigned char candidate[awssign::detail::hmac::max_size];
+    hash.finish(candidate);
+
+    if (!std::lexicographical_compare(order_minus_two,
+                                      order_minus_two + scalar_size,
+                                      candidate, candidate + scalar_size)) {
+      // add one to the big-endian candidate. it's at most n-2, so this can't
+      // carry out of the top byte
+      for (int i = scalar_size - 1; i >= 0; i--) {
+        if (++candidate[i] != 0) {
+          break;
+        }
+      }
+      std::copy_n(candidate, scalar_size, scalar);
+      return;
+    }
+  }
+  throw awssign::detail::digest_error{"ecdsa key derivation failed"};
+}
+
+// create a p-256 key pair from its private scalar. the scalar is wrapped in
+// a DER-encoded ECPrivateKey (RFC 5915) without the optional public key,
+// which openssl computes while parsing it
+inline pkey make_private_pkey(const unsigned char* scalar)
+{
+  unsigned char der[51] = {
+    0x30, 0x31, // SEQUENCE
+    0x02, 0x01, 0x01, // version 1
+    0x04, 0x20, // privateKey OCTET STRING
+  };
+  std::copy_n(scalar, scalar_size, der + 7);
+  constexpr unsigned char parameters[] = {
+    0xa0, 0x0a, 0x06, 0x08, // [0] OID prime256v1
+    0x2a, 0x86, 0x48, 0xce, 0x3d, 0x03, 0x01, 0x07,
+  };
+  std::copy(std::begin(parameters), std::end(parameters), der + 39);
+
+  const unsigned char* p = der;
+  auto key = ::d2i_PrivateKey(EVP_PKEY_EC, nullptr, &p, sizeof(der));
+  if (!key) {
+    throw make_digest_error(::ERR_get_error());
+  }
+  return pkey{key};
+}
+
+// create a p-256 public key from its uncompressed point, wrapped in a
+// DER-encoded SubjectPublicKeyInfo. openssl rejects points off the curve
+inline pkey make_public_pkey(const unsigned char* point)
+{
+  unsigned char der[26 + point_size] = {
+    0x30, 0x59, // SEQUENCE
+    0x30, 0x13, // AlgorithmIdentifier
+    0x06, 0x07, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x02, 0x01, // id-ecPublicKey
+    0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x03, 0x01, 0x07, // prime256v1
+    0x03, 0x42, 0x00, // subjectPublicKey BIT STRING
+  };
+  std::copy_n(point, point_size, der + 26);
+
+  const unsigned char* p = der;
+  auto key = ::d2i_PUBKEY(nullptr, &p, sizeof(der));
+  if (!key) {
+    throw make_digest_error(::ERR_get_error());
+  }
+  return pkey{key};
+}
+
+// write the key's uncompressed public point
+inline void write_public_point(const pkey& key, unsigned char* point)
+{
+  unsigned char* p = point;
+  if (::i2d_PublicKey(key.get(), &p) != static_cast<int>(point_size)) {
+    throw make_digest_error(::ERR_get_error());
+  }
+}
+
+// an EVP_PKEY_CTX that's freed on destruction
+struct pkey_ctx {
+  ::EVP_PKEY_CTX* ctx;
+  explicit pkey_ctx(const pkey& key)
+      : ctx(::EVP_PKEY_CTX_new(key.get(), nullptr)) {
+    if (!ctx) {
+      throw make_digest_error(::ERR_get_error());
+    }
+  }
+  ~pkey_ctx() { ::EVP_PKEY_CTX_free(ctx); }
+  pkey_ctx(const pkey_ctx&) = delete;
+  pkey_ctx& operator=(const pkey_ctx&) = delete;
+};
+
+// sign a sha256 digest, and return the size of the DER-encoded signature
+inline std::size_t sign_digest(const pkey& key, const unsigned char* digest,
+                               unsigned char* signature)
+{
+  auto ctx = pkey_ctx{key};
+  std::size_t size = max_signature_size;
+  if (::EVP_PKEY_sign_init(ctx.ctx) <= 0 ||
+      ::EVP_PKEY_CTX_set_signature_md(ctx.ctx, ::EVP_sha256()) <= 0 ||
+      ::EVP_PKEY_sign(ctx.ctx, signature, &size, digest, scalar_size) <= 0) {
+    throw make_digest_error(::ERR_get_error());
+  }
+  return size;
+}
+
+// verify the DER-encoded signature of a sha256 digest
+inline bool verify_digest(const pkey& key, const unsigned char* digest,
+                          const unsigned char* signature, std::size_t size)
+{
+  auto ctx = pkey_ctx{key};
+  if (::EVP_PKEY_verify_init(ctx.ctx) <= 0 ||
+      ::EVP_PKEY_CTX_set_signature_md(ctx.ctx, ::EVP_sha256()) <= 0) {
+    throw make_digest_error(::ERR_get_error());
+  }
+  const int result = ::EVP_PKEY_verify(ctx.ctx, signature, size,
+                                       digest, scalar_size);
+  if (result != 1) {
+    ::ERR_clear_error(); // a malformed signature leaves errors behind
+  }
+  return result == 1;
+}
+
+} // namespace awssign::v4a::detail
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string_view>
+#include <awssign/v4a/detail/ecdsa.hpp>
+
+namespace awssign::v4a {
+
+// a p-256 public key that verifies SigV4a signatures. the point is decoded
+// and validated once on construction, and copies share the parsed key, so a
+// cached public_key makes each verification a single ECDSA verify
+class public_key {
+  detail::pkey key;
+ public:
+  static constexpr std::size_t point_size = detail::point_size;
+
+  // construct from an uncompressed point of point_size bytes. throws
+  // digest_error if the point isn't on the curve
+  explicit public_key(const unsigned char* point)
+      : key(detail::make_public_pkey(point))
+  {}
+  // share the public half of a private_key
+  explicit public_key(detail::pkey key) noexcept
+      : key(std::move(key))
+  {}
+
+  // write the uncompressed point of point_size bytes
+  void write_point(unsigned char* point) const {
+    detail::write_public_point(key, point);
+  }
+
+  // verify the DER-encoded signature of a sha256 digest
+  bool verify(const unsigned char* digest,
+              const unsigned char* signature, std::size_t size) const {
+    return detail::verify_digest(key, digest, signature, size);
+  }
+};
+
+// a p-256 private key that was derived from the access key id and secret
+// access key. unlike a SigV4 signing_key, it doesn't depend on the date,
+// region or service, so one key signs every request for the credentials.
+// the derivation includes a point multiplication for the public key, so
+// keys should be cached, see key_cache
+//
+// example:
+//
+//   const auto key = private_key{access_key_id, secret_access_key};
+//   v4a::sign(access_key_id, key, method, uri_path, query, header0, headerN,
+//             payload_hash, date, service, out);
+//
+class private_key {
+  detail::pkey key;
+ public:
+  static constexpr std::size_t max_signature_size =
+      detail::max_signature_size;
+
+  private_key(std::string_view access_key_id,
+              std::string_view secret_access_key)
+  {
+    unsigned char scalar[detail::scalar_size];
+    detail::derive_private_scalar(access_key_id, secret_access_key, scalar);
+    key = detail::make_private_pkey(scalar);
+  }
+
+  // wrap a private scalar that was already derived
+  explicit private_key(const unsigned char* scalar)
+      : key(detail::make_private_pkey(scalar))
+  {}
+
+  // sign a sha256 digest, and write the DER-encoded signature of up to
+  // max_signature_size bytes. returns the size of the signature
+  std::size_t sign(const unsigned char* digest,
+                   unsigned char* signature) const {
+    return detail::sign_digest(key, digest, signature);
+  }
+
+  // return the public key, which shares this key's openssl key
+  v4a::public_key public_key() const {
+    return v4a::public_key{key};
+  }
+};
+
+} // namespace awssign::v4a
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string_view>
+#include <awssign/detail/sharded_cache.hpp>
+#include <awssign/v4a/key.hpp>
+
+namespace awssign::v4a {
+
+// a bounded, thread-safe cache of derived SigV4a keys, keyed by credentials.
+// like v4::signing_key_cache, entries are spread over independently-locked
+// shards and each shard evicts with the CLOCK algorithm. a cached key's
+// public_key() is ready for verification without decoding or deriving it
+//
+// example:
+//
+//   auto cache = key_cache{1024};
+//   ...
+//   const auto key = cache.get(access_key_id, secret_access_key);
+//   bool ok = v4a::verify(date, service, signed_headers, method, uri_path,
+//                         query, header0, headerN, payload_hash,
+//                         key.public_key(), signature);
+//
+class key_cache {
+  awssign::detail::sharded_cache<private_key> cache;
+ public:
+  // construct a cache that holds up to 'capacity' keys, divided evenly
+  // between 'shard_count' shards
+  explicit key_cache(std::size_t capacity, std::size_t shard_count = 16)
+      : cache(capacity, shard_count)
+  {}
+
+  // return the key for the given credentials. on a cache miss, the key is
+  // derived and inserted into the cache
+  private_key get(std::string_view access_key_id,
+                  std::string_view secret_access_key)
+  {
+    // the secret is included so that a rotated secret can never return a
+    // stale key
+    const auto key = awssign::detail::make_cache_key({
+        access_key_id, secret_access_key});
+    return *cache.get(key, [&] {
+        return private_key{access_key_id, secret_access_key};
+      });
+  }
+
+  // remove all entries from the cache
+  void clear() { cache.clear(); }
+
+  // return the maximum number of cached entries
+  std::size_t capacity() const { return cache.capacity(); }
+};
+
+} // namespace awssign::v4a
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <iterator>
+#include <string_view>
+#include <awssign/detail/digest.hpp>
+#include <awssign/detail/digest_stream.hpp>
+#include <awssign/detail/hex_encode.hpp>
+#include <awssign/detail/output_stream.hpp>
+#include <awssign/detail/write.hpp>
+#include <awssign/v4/detail/canonical_headers.hpp>
+#include <awssign/v4/detail/canonical_request.hpp>
+#include <awssign/v4/hash_algorithm.hpp>
+#include <awssign/v4a/key.hpp>
+
+namespace awssign::v4a {
+
+// the algorithm of SigV4a signatures
+inline constexpr std::string_view signing_algorithm = "AWS4-ECDSA-P256-SHA256";
+
+// SigV4a signatures are valid in a set of regions instead of one. this
+// header lists them, like "us-east-1,us-west-2" or "*", and must be signed
+inline constexpr std::string_view region_set_header = "x-amz-region-set";
+
+namespace detail {
+
+using awssign::detail::buffered_digest_stream;
+using awssign::detail::digest;
+using awssign::detail::hex_encode;
+using awssign::detail::output_stream;
+using awssign::detail::write;
+using v4::detail::canonical_header;
+
+// the credential scope has no region
+template <typename OutputStream>
+void write_scope(std::string_view date, std::string_view service,
+                 OutputStream&& out)
+{
+  write(date.substr(0, 8), out); // YYYYMMDD
+  write('/', out);
+  write(service, out);
+  write("/aws4_request", out);
+}
+
+template <typename OutputStream>
+void write_string_to_sign(std::string_view date,
+                          std::string_view service,
+                          std::string_view canonical_request_hash,
+                          OutputStream&& out)
+{
+  write(signing_algorithm, out);
+  write('\n', out);
+  write(date, out);
+  write('\n', out);
+  write_scope(date, service, out);
+  write('\n', out);
+  write(canonical_request_hash, out);
+}
+
+// hash the canonical request and then the string to sign, and write the
+// sha256 digest that's signed with ecdsa
+template <typename WriteCanonicalRequest>
+void string_to_sign_digest(std::string_view date,
+                           std::string_view service,
+                           WriteCanonicalRequest&& write_canonical_request,
+                           unsigned char* result)
+{
+  constexpr std::size_t digest_size = v4::sha256::digest_size;
+  char canonical_buffer[digest_size * 2]; // hex encoded
+  {
+    auto hash = digest{v4::sha256::type()};
+    write_canonical_request(buffered_digest_stream(hash));
+    unsigned char buffer[digest_size];
+    hash.finish(buffer);
+    hex_encode(buffer, buffer + digest_size, canonical_buffer);
+  }
+  auto hash = digest{v4::sha256::type()};
+  write_string_to_sign(date, service,
+                       std::string_view{canonical_buffer, sizeof(canonical_buffer)},
+                       buffered_digest_stream(hash));
+  hash.finish(result);
+}
+
+} // namespace detail
+
+// generate a SigV4a signature for the given request with a key that was
+// derived for the access key id, and write the Authorization header's value
+// to output. the headers must include region_set_header
+template <typename HeaderIterator,
+          typename OutputStream>
+void sign(std::string_view access_key_id,
+          const private_key& key,
+          std::string_view method,
+          std::string_view uri_path,
+          std::string_view query,
+          HeaderIterator header0,
+          HeaderIterator headerN,
+          std::string_view payload_hash,
+          std::string_view date,
+          std::string_view service,
+          OutputStream&& out)
+{
+  using detail::canonical_header;
+  using detail::write;
+
+  // stack-allocate an array of canonical_header[]
+  const std::size_t header_count = std::distance(header0, headerN);
+  auto canonical_header0 = static_cast<canonical_header*>(
+      ::alloca(header_count * sizeof(canonical_header)));
+  // stable sort headers by canonical name
+  const auto canonical_headerN = v4::detail::sorted_canonical_headers(
+      header0, headerN, canonical_header0);
+
+  unsigned char digest[v4::sha256::digest_size];
+  detail::string_to_sign_digest(date, service, [&] (auto&& stream) {
+        v4::detail::write_canonical_request(service, method, uri_path, query,
+                                            canonical_header0,
+                                            canonical_headerN,
+                                            payload_hash, stream);
+      }, digest);
+  unsigned char signature[private_key::max_signature_size];
+  const auto signature_size = key.sign(digest, signature);
+
+  write(signing_algorithm, out);
+  write(" Credential=", out);
+  write(access_key_id, out);
+  write('/', out);
+  detail::write_scope(date, service, out);
+  write(", SignedHeaders=", out);
+  v4::detail::write_signed_headers(canonical_header0, canonical_headerN, out);
+  write(", Signature=", out);
+  detail::hex_encode(signature, signature + signature_size, out);
+}
+
+// generate a SigV4a signature for the given request, and write the
+// Authorization header's value to output. this derives the key on every
+// call, so prefer a private_key from key_cache
+template <typename HeaderIterator,
+          typename OutputStream>
+void sign(std::string_view access_key_id,
+          std::string_view secret_access_key,
+          std::string_view method,
+          std::string_view uri_path,
+          std::string_view query,
+          HeaderIterator header0,
+          HeaderIterator headerN,
+          std::string_view payload_hash,
+          std::string_view date,
+          std::string_view service,
+          OutputStream&& out)
+{
+  const auto key = private_key{access_key_id, secret_access_key};
+  return sign(access_key_id, key, method, uri_path, query, header0, headerN,
+              payload_hash, date, service, std::forward<OutputStream>(out));
+}
+
+} // namespace awssign::v4a
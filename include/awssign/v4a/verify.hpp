@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string_view>
+#include <awssign/v4/verify.hpp>
+#include <awssign/v4a/key.hpp>
+#include <awssign/v4a/sign.hpp>
+
+namespace awssign::v4a {
+
+namespace detail {
+
+// decode a hex-encoded DER signature, and return its size. returns 0 if the
+// input isn't lowercase hex, or is too long for p-256
+inline std::size_t decode_signature(std::string_view hex,
+                                    unsigned char* signature)
+{
+  return v4::detail::decode_signature(hex, signature, max_signature_size);
+}
+
+} // namespace detail
+
+// verify that the SigV4a signature of the given request was made by the
+// public key's private key. signed_headers is the SignedHeaders= of the
+// Authorization header, and the caller must also check that the request's
+// region is in its region_set_header
+template <typename HeaderIterator>
+bool verify(std::string_view date,
+            std::string_view service,
+            std::string_view signed_headers,
+            std::string_view method,
+            std::string_view uri_path,
+            std::string_view query,
+            HeaderIterator header0,
+            HeaderIterator headerN,
+            std::string_view payload_hash,
+            const public_key& key,
+            std::string_view signature)
+{
+  unsigned char der[detail::max_signature_size];
+  const auto der_size = detail::decode_signature(signature, der);
+  if (der_size == 0) {
+    return false;
+  }
+  unsigned char digest[v4::sha256::digest_size];
+  bool written = false;
+  detail::string_to_sign_digest(date, service, [&] (auto&& stream) {
+        written = v4::detail::write_signed_canonical_request(
+            service, signed_headers, method, uri_path, query,
+            header0, headerN, payload_hash, stream);
+      }, digest);
+  return written && key.verify(digest, der, der_size);
+}
+
+} // namespace awssign::v4a
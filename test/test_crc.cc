@@ -0,0 +1,108 @@
+#include <awssign/detail/crc.hpp>
+#include <string>
+#include <gtest/gtest.h>
+
+namespace awssign::detail {
+
+static constexpr std::string_view check = "123456789";
+
+constexpr crc_backend backends[] = {
+  crc_backend::scalar, crc_backend::sse42, crc_backend::pclmul
+};
+
+std::string make_input(std::size_t size)
+{
+  std::string input(size, '\0');
+  std::uint32_t x = 12345;
+  for (auto& c : input) {
+    x = x * 1103515245 + 12345;
+    c = static_cast<char>(x >> 16);
+  }
+  return input;
+}
+
+TEST(crc, check_values)
+{
+  for (auto backend : backends) {
+    if (!crc_supported(backend)) {
+      continue;
+    }
+    SCOPED_TRACE(static_cast<int>(backend));
+    EXPECT_EQ(0xcbf43926u, crc32(0, check.data(), check.size(), backend));
+    EXPECT_EQ(0xe3069283u, crc32c(0, check.data(), check.size(), backend));
+    EXPECT_EQ(0xae8b14860a799888u,
+              crc64nvme(0, check.data(), check.size(), backend));
+    EXPECT_EQ(0u, crc32(0, nullptr, 0, backend));
+    EXPECT_EQ(0u, crc32c(0, nullptr, 0, backend));
+    EXPECT_EQ(0u, crc64nvme(0, nullptr, 0, backend));
+  }
+}
+
+TEST(crc, backends_match_scalar)
+{
+  const auto input = make_input(4096 + 64);
+  for (auto backend : backends) {
+    if (!crc_supported(backend)) {
+      continue;
+    }
+    SCOPED_TRACE(static_cast<int>(backend));
+    // every size up to a few folds, at unaligned offsets
+    for (std::size_t offset : {0, 1, 7}) {
+      for (std::size_t size = 0; size < 300; size++) {
+        SCOPED_TRACE(size);
+        const auto p = input.data() + offset;
+        ASSERT_EQ(crc32(0, p, size, crc_backend::scalar),
+                  crc32(0, p, size, backend));
+        ASSERT_EQ(crc32c(0, p, size, crc_backend::scalar),
+                  crc32c(0, p, size, backend));
+        ASSERT_EQ(crc64nvme(0, p, size, crc_backend::scalar),
+                  crc64nvme(0, p, size, backend));
+      }
+    }
+    EXPECT_EQ(crc32(0, input.data(), 4096, crc_backend::scalar),
+              crc32(0, input.data(), 4096, backend));
+    EXPECT_EQ(crc32c(0, input.data(), 4096, crc_backend::scalar),
+              crc32c(0, input.data(), 4096, backend));
+    EXPECT_EQ(crc64nvme(0, input.data(), 4096, crc_backend::scalar),
+              crc64nvme(0, input.data(), 4096, backend));
+  }
+}
+
+TEST(crc, continuation)
+{
+  const auto input = make_input(1000);
+  const auto expected32 = crc32(0, input.data(), input.size());
+  const auto expected32c = crc32c(0, input.data(), input.size());
+  const auto expected64 = crc64nvme(0, input.data(), input.size());
+  for (std::size_t split : {0, 1, 63, 64, 65, 500, 999}) {
+    SCOPED_TRACE(split);
+    const auto rest = input.size() - split;
+    EXPECT_EQ(expected32, crc32(crc32(0, input.data(), split),
+                                input.data() + split, rest));
+    EXPECT_EQ(expected32c, crc32c(crc32c(0, input.data(), split),
+                                  input.data() + split, rest));
+    EXPECT_EQ(expected64, crc64nvme(crc64nvme(0, input.data(), split),
+                                    input.data() + split, rest));
+  }
+}
+
+TEST(crc, combine)
+{
+  const auto input = make_input(1000);
+  const auto expected32 = crc32(0, input.data(), input.size());
+  const auto expected32c = crc32c(0, input.data(), input.size());
+  const auto expected64 = crc64nvme(0, input.data(), input.size());
+  for (std::size_t split : {0, 1, 63, 64, 65, 500, 999, 1000}) {
+    SCOPED_TRACE(split);
+    const auto rest = input.size() - split;
+    const auto second = input.data() + split;
+    EXPECT_EQ(expected32, crc32_combine(crc32(0, input.data(), split),
+                                        crc32(0, second, rest), rest));
+    EXPECT_EQ(expected32c, crc32c_combine(crc32c(0, input.data(), split),
+                                          crc32c(0, second, rest), rest));
+    EXPECT_EQ(expected64, crc64nvme_combine(crc64nvme(0, input.data(), split),
+                                            crc64nvme(0, second, rest), rest));
+  }
+}
+
+} // namespace awssign::detail
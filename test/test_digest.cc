@@ -1,7 +1,11 @@
 #include <awssign/detail/digest.hpp>
 #include <string>
+#include <vector>
 #include <gtest/gtest.h>
 #include <awssign/detail/hex_encode.hpp>
+#include <awssign/detail/sha256.hpp>
+#include <awssign/detail/sha256_mb.hpp>
+#include <openssl/hmac.h>
 
 namespace awssign {
 
@@ -69,4 +73,192 @@ TEST(digest, hmac_sha256)
   }
 }
 
+TEST(digest, hmac_sha256_prototype)
+{
+  const unsigned char key[] = {'b','a','r'};
+  constexpr std::string_view expected{
+      "147933218aaabc0b8b10a2b3a5c34684c8d94341bcf10a4736dc7270f7741851"};
+  const auto prototype = hmac{"SHA256", key, sizeof(key)};
+  {
+    auto hash = prototype; // copy construct
+    hash.update("foo", 3);
+    unsigned char digest[digest::max_size];
+    const auto bytes = hash.finish(digest);
+    EXPECT_EQ(expected, hex_encode(digest, bytes));
+  }
+  {
+    const unsigned char other_key[] = {'b','a','z'};
+    auto hash = hmac{"SHA256", other_key, sizeof(other_key)};
+    hash = prototype; // copy assign
+    hash.update("f", 1);
+    hash.update("oo", 2);
+    unsigned char digest[digest::max_size];
+    const auto bytes = hash.finish(digest);
+    EXPECT_EQ(expected, hex_encode(digest, bytes));
+  }
+}
+
+TEST(digest, hmac_sha256_init_key)
+{
+  const unsigned char key[] = {'b','a','r'};
+  constexpr std::string_view expected{
+      "147933218aaabc0b8b10a2b3a5c34684c8d94341bcf10a4736dc7270f7741851"};
+  auto hash = hmac{"SHA256"}; // no key
+  hash.init(key, sizeof(key));
+  hash.update("foo", 3);
+  unsigned char digest[digest::max_size];
+  const auto bytes = hash.finish(digest);
+  EXPECT_EQ(expected, hex_encode(digest, bytes));
+}
+
+TEST(digest_type, cached)
+{
+  const auto type = detail::get_digest_type("SHA256");
+  ASSERT_TRUE(type);
+  EXPECT_EQ(type, detail::get_digest_type("SHA256"));
+  EXPECT_NE(type, detail::get_digest_type("SHA1"));
+}
+
+TEST(digest_type, unknown)
+{
+  EXPECT_FALSE(detail::get_digest_type("NOT-A-DIGEST"));
+  EXPECT_THROW(digest{"NOT-A-DIGEST"}, detail::digest_error);
+  EXPECT_THROW(hmac{"NOT-A-DIGEST"}, detail::digest_error);
+}
+
+constexpr detail::sha256_backend sha256_backends[] = {
+  detail::sha256_backend::scalar,
+  detail::sha256_backend::avx2,
+  detail::sha256_backend::shani,
+};
+
+// a message that covers every byte value and several blocks
+std::string make_message(std::size_t size)
+{
+  std::string message(size, '\0');
+  for (std::size_t i = 0; i < size; i++) {
+    message[i] = static_cast<char>(i * 131 + 7);
+  }
+  return message;
+}
+
+TEST(sha256_digest, matches_openssl)
+{
+  const auto message = make_message(300);
+  for (auto backend : sha256_backends) {
+    if (!detail::sha256_supported(backend)) {
+      continue;
+    }
+    SCOPED_TRACE(static_cast<int>(backend));
+    auto hash = detail::sha256_digest{backend};
+    for (std::size_t size = 0; size <= message.size(); size++) {
+      unsigned char expected[EVP_MAX_MD_SIZE];
+      unsigned int expected_size = 0;
+      ASSERT_TRUE(::EVP_Digest(message.data(), size, expected, &expected_size,
+                               ::EVP_sha256(), nullptr));
+      unsigned char digest[detail::sha256_digest::size];
+      hash.init();
+      hash.update(message.data(), size);
+      ASSERT_EQ(expected_size, hash.finish(digest));
+      ASSERT_EQ(hex_encode(expected, expected_size),
+                hex_encode(digest, sizeof(digest))) << size;
+      // update in uneven pieces
+      hash.init();
+      for (std::size_t pos = 0; pos < size; pos += 7) {
+        hash.update(message.data() + pos, std::min<std::size_t>(7, size - pos));
+      }
+      hash.finish(digest);
+      ASSERT_EQ(hex_encode(expected, expected_size),
+                hex_encode(digest, sizeof(digest))) << size;
+    }
+  }
+}
+
+TEST(sha256_hmac, matches_openssl)
+{
+  const auto key = make_message(200);
+  const auto message = make_message(150);
+  for (auto backend : sha256_backends) {
+    if (!detail::sha256_supported(backend)) {
+      continue;
+    }
+    SCOPED_TRACE(static_cast<int>(backend));
+    for (int key_size : {0, 3, 32, 63, 64, 65, 200}) {
+      auto k = reinterpret_cast<const unsigned char*>(key.data());
+      auto hash = detail::sha256_hmac{k, key_size, backend};
+      for (std::size_t size : {0, 8, 55, 56, 64, 120, 150}) {
+        unsigned char expected[EVP_MAX_MD_SIZE];
+        unsigned int expected_size = 0;
+        ASSERT_TRUE(::HMAC(::EVP_sha256(), k, key_size,
+                           reinterpret_cast<const unsigned char*>(message.data()),
+                           size, expected, &expected_size));
+        unsigned char digest[detail::sha256_hmac::size];
+        hash.init();
+        hash.update(message.data(), size);
+        ASSERT_EQ(expected_size, hash.finish(digest));
+        ASSERT_EQ(hex_encode(expected, expected_size),
+                  hex_encode(digest, sizeof(digest)))
+            << key_size << ' ' << size;
+      }
+    }
+  }
+}
+
+TEST(sha256_multi, matches_sha256_digest)
+{
+  // messages of different lengths, so lanes finish at different times
+  const auto message = make_message(300);
+  std::vector<std::string> expected;
+  for (std::size_t size = 0; size <= message.size(); size += 13) {
+    unsigned char digest[detail::sha256_digest::size];
+    auto hash = detail::sha256_digest{};
+    hash.update(message.data(), size);
+    hash.finish(digest);
+    expected.push_back(hex_encode(digest, sizeof(digest)));
+  }
+  for (int lanes : {4, 8, 16}) {
+    if (!detail::sha256_lanes_supported(lanes)) {
+      continue;
+    }
+    SCOPED_TRACE(lanes);
+    std::vector<detail::sha256_job> jobs;
+    std::vector<unsigned char> digests(expected.size() * detail::sha256_digest::size);
+    for (std::size_t i = 0; i < expected.size(); i++) {
+      jobs.push_back({message.data(), i * 13,
+                      digests.data() + i * detail::sha256_digest::size});
+    }
+    detail::sha256_multi(jobs.data(), jobs.data() + jobs.size(), lanes);
+    for (std::size_t i = 0; i < expected.size(); i++) {
+      EXPECT_EQ(expected[i], hex_encode(jobs[i].digest,
+                                        detail::sha256_digest::size)) << i;
+    }
+  }
+}
+
+TEST(sha256_hmac_multi, matches_sha256_hmac)
+{
+  const unsigned char key[] = {'b','a','r'};
+  const unsigned char other_key[] = {'b','a','z'};
+  const auto keys = std::vector<detail::sha256_hmac>{
+      detail::sha256_hmac{key, sizeof(key)},
+      detail::sha256_hmac{other_key, sizeof(other_key)}};
+  const auto message = make_message(150);
+
+  std::vector<detail::sha256_hmac_job> jobs;
+  std::vector<unsigned char> digests(100 * detail::sha256_hmac::size);
+  for (std::size_t i = 0; i < 100; i++) {
+    jobs.push_back({&keys[i % 2], message.data(), i + 50,
+                    digests.data() + i * detail::sha256_hmac::size});
+  }
+  detail::sha256_hmac_multi(jobs.data(), jobs.data() + jobs.size());
+  for (const auto& job : jobs) {
+    auto hash = *job.key;
+    hash.update(job.data, job.size);
+    unsigned char digest[detail::sha256_hmac::size];
+    hash.finish(digest);
+    EXPECT_EQ(hex_encode(digest, sizeof(digest)),
+              hex_encode(job.digest, sizeof(digest)));
+  }
+}
+
 } // namespace awssign
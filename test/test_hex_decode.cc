@@ -0,0 +1,122 @@
+#include <awssign/detail/hex_decode.hpp>
+#include <string>
+#include <gtest/gtest.h>
+#include <awssign/detail/hex_encode.hpp>
+
+namespace awssign::detail {
+
+std::string encode(const std::string& bytes)
+{
+  std::string result;
+  const auto data = reinterpret_cast<const unsigned char*>(bytes.data());
+  hex_encode(data, data + bytes.size(),
+      [&result] (const char* begin, const char* end) {
+        result.append(begin, end);
+      });
+  return result;
+}
+
+bool decode(std::string_view hex, std::string& bytes)
+{
+  bytes.assign(hex.size() / 2, '\0');
+  return hex_decode(hex.data(), hex.data() + hex.size(),
+                    reinterpret_cast<unsigned char*>(bytes.data()));
+}
+
+TEST(hex_decode, round_trip)
+{
+  // cover the vector loop and the scalar tail
+  for (std::size_t size = 0; size <= 80; size++) {
+    SCOPED_TRACE(size);
+    std::string bytes(size, '\0');
+    for (std::size_t i = 0; i < size; i++) {
+      bytes[i] = static_cast<char>(i * 37 + size);
+    }
+    std::string decoded;
+    ASSERT_TRUE(decode(encode(bytes), decoded));
+    EXPECT_EQ(bytes, decoded);
+  }
+}
+
+TEST(hex_decode, all_digits)
+{
+  std::string decoded;
+  ASSERT_TRUE(decode("0123456789abcdef0123456789abcdef", decoded));
+  EXPECT_EQ(encode(decoded), "0123456789abcdef0123456789abcdef");
+}
+
+TEST(hex_decode, odd_length)
+{
+  std::string decoded;
+  EXPECT_FALSE(decode("abc", decoded));
+}
+
+TEST(hex_decode, invalid_characters)
+{
+  // place each invalid character in the vector loop and in the tail
+  const auto valid = std::string(70, 'a');
+  std::string decoded;
+  ASSERT_TRUE(decode(valid, decoded));
+  for (int c = 0; c < 256; c++) {
+    if (hex_digit(static_cast<char>(c)) >= 0) {
+      continue;
+    }
+    for (std::size_t pos : {0, 1, 15, 16, 31, 32, 63, 64, 69}) {
+      auto hex = valid;
+      hex[pos] = static_cast<char>(c);
+      EXPECT_FALSE(decode(hex, decoded)) << c << " at " << pos;
+    }
+  }
+}
+
+TEST(hex_decode, backends)
+{
+  // every backend must agree with the scalar kernels
+  for (auto backend : {hex_backend::scalar, hex_backend::ssse3,
+                       hex_backend::avx2}) {
+    if (!hex_supported(backend)) {
+      continue;
+    }
+    SCOPED_TRACE(static_cast<int>(backend));
+    for (std::size_t size = 0; size <= 80; size++) {
+      SCOPED_TRACE(size);
+      std::string bytes(size, '\0');
+      for (std::size_t i = 0; i < size; i++) {
+        bytes[i] = static_cast<char>(i * 101 + size);
+      }
+      const auto data = reinterpret_cast<const unsigned char*>(bytes.data());
+      std::string hex(2 * size, '\0');
+      std::string expected(2 * size, '\0');
+      EXPECT_EQ(hex.data() + hex.size(),
+                hex_encode(data, data + size, hex.data(), backend));
+      hex_encode(data, data + size, expected.data(), hex_backend::scalar);
+      EXPECT_EQ(expected, hex);
+
+      std::string decoded(size, '\0');
+      ASSERT_TRUE(hex_decode(hex.data(), hex.data() + hex.size(),
+                             reinterpret_cast<unsigned char*>(decoded.data()),
+                             backend));
+      EXPECT_EQ(bytes, decoded);
+      if (size) {
+        hex[size] = 'A';
+        EXPECT_FALSE(hex_decode(hex.data(), hex.data() + hex.size(),
+                                reinterpret_cast<unsigned char*>(decoded.data()),
+                                backend));
+      }
+    }
+  }
+}
+
+TEST(hex_decode, digits)
+{
+  EXPECT_EQ(0, hex_digit('0'));
+  EXPECT_EQ(9, hex_digit('9'));
+  EXPECT_EQ(10, hex_digit('a'));
+  EXPECT_EQ(15, hex_digit('f'));
+  EXPECT_EQ(-1, hex_digit('A'));
+  EXPECT_EQ(-1, hex_digit('g'));
+  EXPECT_EQ(-1, hex_digit('/'));
+  EXPECT_EQ(-1, hex_digit(':'));
+}
+
+} // namespace awssign::detail
@@ -0,0 +1,167 @@
+#include <awssign/detail/lower_case.hpp>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <gtest/gtest.h>
+
+namespace awssign::detail {
+
+constexpr lower_case_backend backends[] = {
+  lower_case_backend::scalar,
+  lower_case_backend::avx2,
+  lower_case_backend::avx512,
+};
+
+std::string expected_lower(std::string s)
+{
+  for (auto& c : s) {
+    c = to_lower(c);
+  }
+  return s;
+}
+
+// random characters around the edges of 'A'..'Z'
+std::string random_string(std::default_random_engine& rng, std::size_t size)
+{
+  constexpr std::string_view alphabet = "@AZ[`az{-09Mm\x80\xc1\xe1";
+  auto index = std::uniform_int_distribution<std::size_t>{0, alphabet.size() - 1};
+  std::string s(size, '\0');
+  for (auto& c : s) {
+    c = alphabet[index(rng)];
+  }
+  return s;
+}
+
+TEST(lower_case, find_upper)
+{
+  for (std::size_t size = 0; size <= 150; size++) {
+    SCOPED_TRACE(size);
+    const auto lower = std::string(size, 'a');
+    for (auto backend : backends) {
+      if (!lower_case_supported(backend)) {
+        continue;
+      }
+      EXPECT_EQ(size, find_upper(lower.data(), size, backend));
+      for (std::size_t pos = 0; pos < size; pos++) {
+        auto s = lower;
+        s[pos] = 'A' + pos % 26;
+        EXPECT_EQ(pos, find_upper(s.data(), size, backend));
+      }
+    }
+  }
+}
+
+TEST(lower_case, lower_case)
+{
+  std::default_random_engine rng;
+  for (std::size_t size = 0; size <= 150; size++) {
+    SCOPED_TRACE(size);
+    const auto s = random_string(rng, size);
+    for (auto backend : backends) {
+      if (!lower_case_supported(backend)) {
+        continue;
+      }
+      std::string out(size + 1, '!'); // must not write past size
+      lower_case(out.data(), s.data(), size, backend);
+      EXPECT_EQ(expected_lower(s) + '!', out);
+    }
+  }
+}
+
+TEST(lower_case, mismatch)
+{
+  std::default_random_engine rng;
+  for (std::size_t size = 0; size <= 150; size++) {
+    SCOPED_TRACE(size);
+    const auto l = random_string(rng, size);
+    for (std::size_t pos = 0; pos <= size; pos++) {
+      auto r = expected_lower(l);
+      if (pos < size) {
+        r[pos] = '#';
+      }
+      for (auto backend : backends) {
+        if (!lower_case_supported(backend)) {
+          continue;
+        }
+        EXPECT_EQ(pos, (lower_case_mismatch<true, false>(
+                    l.data(), r.data(), size, backend)));
+        EXPECT_EQ(pos, (lower_case_mismatch<false, true>(
+                    r.data(), l.data(), size, backend)));
+        EXPECT_EQ(pos, (lower_case_mismatch<true, true>(
+                    l.data(), r.data(), size, backend)));
+      }
+    }
+  }
+}
+
+TEST(lower_case, compare)
+{
+  std::default_random_engine rng;
+  auto sizes = std::uniform_int_distribution<std::size_t>{0, 70};
+  for (int n = 0; n < 2000; n++) {
+    auto l = random_string(rng, sizes(rng));
+    auto r = n % 2 ? random_string(rng, sizes(rng)) : l;
+    if (n % 4 == 0 && !r.empty()) {
+      r.back() ^= 0x20; // differ by case only
+    }
+    const auto ll = expected_lower(l);
+    const auto lr = expected_lower(r);
+    const auto sl = lower_case_string{l};
+    const auto sr = lower_case_string{r};
+    EXPECT_EQ(ll == lr, sl == sr);
+    EXPECT_EQ(ll < lr, sl < sr);
+    EXPECT_EQ(ll > lr, sl > sr);
+    EXPECT_EQ(ll == r, sl == std::string_view{r});
+    EXPECT_EQ(ll < r, sl < std::string_view{r});
+    EXPECT_EQ(l < lr, std::string_view{l} < sr);
+    EXPECT_EQ(l > lr, std::string_view{l} > sr);
+  }
+}
+
+TEST(lower_case, prefix)
+{
+  EXPECT_EQ(0u, lower_case_prefix(""));
+  EXPECT_EQ(0x6100000000000000u, lower_case_prefix("A"));
+  EXPECT_EQ(lower_case_prefix("x-amz-da"), lower_case_prefix("X-Amz-Date"));
+  for (int c = 0; c < 256; c++) {
+    const char s[1] = {static_cast<char>(c)};
+    EXPECT_EQ(std::uint64_t{static_cast<unsigned char>(to_lower(s[0]))} << 56,
+              lower_case_prefix({s, 1})) << c;
+  }
+
+  // prefixes that differ must order like the lowercase strings
+  std::default_random_engine rng;
+  auto sizes = std::uniform_int_distribution<std::size_t>{0, 12};
+  for (int n = 0; n < 5000; n++) {
+    const auto l = random_string(rng, sizes(rng));
+    const auto r = random_string(rng, sizes(rng));
+    const auto pl = lower_case_prefix(l);
+    const auto pr = lower_case_prefix(r);
+    const auto ll = expected_lower(l);
+    const auto lr = expected_lower(r);
+    if (pl != pr) {
+      EXPECT_EQ(ll < lr, pl < pr) << l << ' ' << r;
+    } else {
+      EXPECT_EQ(ll.substr(0, 8), lr.substr(0, 8));
+    }
+  }
+}
+
+TEST(lower_case, stream)
+{
+  const auto lower = [] (std::string_view str) {
+    std::string result;
+    auto out = [&result] (const char* begin, const char* end) {
+      result.append(begin, end);
+    };
+    write(lower_case_string{str}, out);
+    return result;
+  };
+  EXPECT_EQ("", lower(""));
+  EXPECT_EQ("x-amz-date", lower("x-amz-date"));
+  EXPECT_EQ("x-amz-date", lower("X-Amz-Date"));
+  const auto upper = std::string(300, 'X');
+  EXPECT_EQ(std::string(300, 'x'), lower(upper));
+}
+
+} // namespace awssign::detail
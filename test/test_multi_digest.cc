@@ -0,0 +1,135 @@
+#include <awssign/detail/multi_digest.hpp>
+#include <string>
+#include <gtest/gtest.h>
+
+namespace awssign::detail {
+
+std::string make_input(std::size_t size)
+{
+  std::string input(size, '\0');
+  std::uint32_t x = 12345;
+  for (auto& c : input) {
+    x = x * 1103515245 + 12345;
+    c = static_cast<char>(x >> 16);
+  }
+  return input;
+}
+
+constexpr payload_digest all[] = {
+  payload_digest::sha256, payload_digest::md5, payload_digest::sha1,
+  payload_digest::crc32, payload_digest::crc32c, payload_digest::crc64nvme
+};
+
+std::string hex(const multi_digest& hash, payload_digest algorithm)
+{
+  char buffer[multi_digest::max_hex_size];
+  return std::string(buffer, hash.hex(algorithm, buffer));
+}
+
+std::string base64(const multi_digest& hash, payload_digest algorithm)
+{
+  char buffer[multi_digest::max_base64_size];
+  return std::string(buffer, hash.base64(algorithm, buffer));
+}
+
+TEST(multi_digest, known_values)
+{
+  auto hash = multi_digest{payload_digest::sha256, payload_digest::md5,
+                           payload_digest::sha1, payload_digest::crc32,
+                           payload_digest::crc32c, payload_digest::crc64nvme};
+  hash.update("123456789", 9);
+  hash.finish();
+  EXPECT_EQ("15e2b0d3c33891ebb0f1ef609ec419420c20e320ce94c65fbc8c3312448eb225",
+            hex(hash, payload_digest::sha256));
+  EXPECT_EQ("25f9e794323b453885f5181f1b624d0b",
+            hex(hash, payload_digest::md5));
+  EXPECT_EQ("f7c3bc1d808e04732adf679965ccc34ca7ae3441",
+            hex(hash, payload_digest::sha1));
+  EXPECT_EQ("cbf43926", hex(hash, payload_digest::crc32));
+  EXPECT_EQ("e3069283", hex(hash, payload_digest::crc32c));
+  EXPECT_EQ("ae8b14860a799888", hex(hash, payload_digest::crc64nvme));
+  EXPECT_EQ("JfnnlDI7RTiF9RgfG2JNCw==", base64(hash, payload_digest::md5));
+  EXPECT_EQ("y/Q5Jg==", base64(hash, payload_digest::crc32));
+}
+
+TEST(multi_digest, only_requested)
+{
+  auto hash = multi_digest{payload_digest::md5, payload_digest::crc32c};
+  hash.update("123456789", 9);
+  hash.finish();
+  EXPECT_EQ("", hex(hash, payload_digest::sha256));
+  EXPECT_EQ("", base64(hash, payload_digest::crc32));
+  EXPECT_EQ("25f9e794323b453885f5181f1b624d0b",
+            hex(hash, payload_digest::md5));
+  EXPECT_EQ("e3069283", hex(hash, payload_digest::crc32c));
+}
+
+// hex encode the result of a separate pass over the input
+std::string separate_pass(payload_digest algorithm, const std::string& input)
+{
+  unsigned char buffer[digest::max_size];
+  std::size_t size = 0;
+  auto crc_bytes = [&] (std::uint64_t crc, std::size_t bytes) {
+    for (std::size_t i = 0; i < bytes; i++) {
+      buffer[i] = crc >> (8 * (bytes - 1 - i));
+    }
+    return bytes;
+  };
+  switch (algorithm) {
+    case payload_digest::sha256:
+    case payload_digest::md5:
+    case payload_digest::sha1: {
+      constexpr const char* names[] = {"SHA256", "MD5", "SHA1"};
+      auto hash = digest{names[static_cast<int>(algorithm)]};
+      hash.update(input.data(), input.size());
+      size = hash.finish(buffer);
+      break;
+    }
+    case payload_digest::crc32:
+      size = crc_bytes(crc32(0, input.data(), input.size()), 4);
+      break;
+    case payload_digest::crc32c:
+      size = crc_bytes(crc32c(0, input.data(), input.size()), 4);
+      break;
+    case payload_digest::crc64nvme:
+      size = crc_bytes(crc64nvme(0, input.data(), input.size()), 8);
+      break;
+  }
+  std::string result;
+  hex_encode(buffer, buffer + size,
+      [&result] (const char* begin, const char* end) {
+        result.append(begin, end);
+      });
+  return result;
+}
+
+TEST(multi_digest, matches_separate_passes)
+{
+  // cover partial blocks and updates that straddle block boundaries
+  const auto input = make_input(3 * multi_digest::block_size + 1000);
+  const std::size_t splits[] = {0, 1, 4095, multi_digest::block_size + 7};
+  for (auto split : splits) {
+    SCOPED_TRACE(split);
+    auto hash = multi_digest{payload_digest::sha256, payload_digest::md5,
+                             payload_digest::sha1, payload_digest::crc32,
+                             payload_digest::crc32c, payload_digest::crc64nvme};
+    hash.update(input.data(), split);
+    hash.update(input.data() + split, input.size() - split);
+    hash.finish();
+    for (auto algorithm : all) {
+      SCOPED_TRACE(static_cast<int>(algorithm));
+      EXPECT_EQ(separate_pass(algorithm, input), hex(hash, algorithm));
+    }
+  }
+}
+
+TEST(multi_digest, bytes)
+{
+  auto hash = multi_digest{payload_digest::crc64nvme};
+  hash.finish();
+  unsigned char buffer[digest::max_size];
+  EXPECT_EQ(8u, hash.bytes(payload_digest::crc64nvme, buffer));
+  EXPECT_EQ(0u, hash.bytes(payload_digest::sha1, buffer));
+}
+
+} // namespace awssign::detail
@@ -0,0 +1,72 @@
+#include <awssign/detail/radix_sort.hpp>
+#include <random>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace awssign::detail {
+
+std::string_view identity(const std::string_view& s) { return s; }
+
+void expect_sorted(std::vector<std::string> strings)
+{
+  auto expected = std::vector<std::string_view>(strings.begin(), strings.end());
+  std::sort(expected.begin(), expected.end());
+  auto actual = std::vector<std::string_view>(strings.begin(), strings.end());
+  auto scratch = std::vector<std::string_view>(actual.size());
+  radix_sort(actual.data(), actual.data() + actual.size(), scratch.data(),
+             identity);
+  EXPECT_EQ(expected, actual);
+}
+
+TEST(radix_sort, empty)
+{
+  radix_sort<std::string_view>(nullptr, nullptr, nullptr, identity);
+}
+
+TEST(radix_sort, random)
+{
+  std::default_random_engine rng;
+  // cover comparison sorts, and radix sorts with buckets of every size
+  for (std::size_t size : {1, 2, 63, 64, 65, 100, 257, 1000, 5000}) {
+    SCOPED_TRACE(size);
+    // few distinct characters, so there are long common prefixes and ties
+    auto lengths = std::uniform_int_distribution<std::size_t>{0, 12};
+    auto chars = std::uniform_int_distribution<int>{'a', 'd'};
+    std::vector<std::string> strings(size);
+    for (auto& s : strings) {
+      std::generate_n(std::back_inserter(s), lengths(rng),
+                      [&] { return static_cast<char>(chars(rng)); });
+    }
+    expect_sorted(std::move(strings));
+  }
+}
+
+TEST(radix_sort, common_prefix)
+{
+  // keys that only differ after a long shared prefix
+  std::vector<std::string> strings;
+  for (int i = 0; i < 200; i++) {
+    strings.push_back(std::string(1000, 'x') + std::to_string(i * 7919 % 200));
+  }
+  strings.push_back(std::string(1000, 'x'));
+  strings.push_back(std::string(999, 'x'));
+  expect_sorted(std::move(strings));
+}
+
+TEST(radix_sort, equal)
+{
+  expect_sorted(std::vector<std::string>(100, "same"));
+}
+
+TEST(radix_sort, bytes)
+{
+  // bytes sort as unsigned
+  std::vector<std::string> strings;
+  for (int i = 0; i < 512; i++) {
+    strings.push_back({static_cast<char>(i * 37), static_cast<char>(i)});
+  }
+  expect_sorted(std::move(strings));
+}
+
+} // namespace awssign::detail
@@ -0,0 +1,92 @@
+#include <awssign/detail/stable_sort.hpp>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace awssign::detail {
+
+// sort by key only, so that stability is observable through the index
+struct element {
+  int key;
+  int index;
+};
+
+bool operator<(const element& l, const element& r)
+{
+  return l.key < r.key;
+}
+
+std::vector<element> expected_sort(std::vector<element> v)
+{
+  std::stable_sort(v.begin(), v.end());
+  return v;
+}
+
+void expect_sorted(const std::vector<element>& expected,
+                   const std::vector<element>& actual)
+{
+  ASSERT_EQ(expected.size(), actual.size());
+  for (std::size_t i = 0; i < expected.size(); i++) {
+    EXPECT_EQ(expected[i].key, actual[i].key) << i;
+    EXPECT_EQ(expected[i].index, actual[i].index) << i;
+  }
+}
+
+TEST(stable_sort, empty)
+{
+  stable_sort<element>(nullptr, nullptr, nullptr);
+}
+
+TEST(stable_sort, random)
+{
+  std::default_random_engine rng;
+  // cover insertion sort, and merge sort with an odd number of passes
+  for (std::size_t size : {1, 2, 15, 16, 17, 31, 33, 64, 100, 257, 1000}) {
+    SCOPED_TRACE(size);
+    // few distinct keys, so there are lots of ties
+    auto keys = std::uniform_int_distribution<int>{0, 7};
+    std::vector<element> v(size);
+    for (std::size_t i = 0; i < size; i++) {
+      v[i] = element{keys(rng), static_cast<int>(i)};
+    }
+    const auto expected = expected_sort(v);
+    std::vector<element> scratch(size);
+    stable_sort(v.data(), v.data() + size, scratch.data());
+    expect_sorted(expected, v);
+  }
+}
+
+TEST(stable_sort, sorted)
+{
+  std::vector<element> v(100);
+  for (std::size_t i = 0; i < v.size(); i++) {
+    v[i] = element{static_cast<int>(i / 3), static_cast<int>(i)};
+  }
+  const auto expected = v;
+  // sorted input doesn't need the scratch buffer
+  stable_sort<element>(v.data(), v.data() + v.size(), nullptr);
+  expect_sorted(expected, v);
+}
+
+TEST(stable_sort, reversed)
+{
+  std::vector<element> v(100);
+  for (std::size_t i = 0; i < v.size(); i++) {
+    v[i] = element{static_cast<int>(v.size() - i), static_cast<int>(i)};
+  }
+  const auto expected = expected_sort(v);
+  std::vector<element> scratch(v.size());
+  stable_sort(v.data(), v.data() + v.size(), scratch.data());
+  expect_sorted(expected, v);
+}
+
+TEST(stable_sort, compare)
+{
+  std::vector<int> v = {3, 1, 4, 1, 5, 9, 2, 6, 5, 3, 5, 8, 9, 7, 9, 3,
+                        2, 3, 8, 4, 6, 2, 6, 4, 3, 3, 8, 3, 2, 7, 9, 5};
+  std::vector<int> scratch(v.size());
+  stable_sort(v.data(), v.data() + v.size(), scratch.data(), std::greater<>{});
+  EXPECT_TRUE(std::is_sorted(v.begin(), v.end(), std::greater<>{}));
+}
+
+} // namespace awssign::detail
@@ -0,0 +1,189 @@
+#include <awssign/tree_hash.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace awssign {
+
+using hash_type = std::array<unsigned char, tree_hash_size>;
+
+hash_type sha256(const void* data, std::size_t size)
+{
+  auto hash = detail::digest{"SHA256"};
+  hash.update(data, size);
+  hash_type result;
+  hash.finish(result.data());
+  return result;
+}
+
+// the tree hash as documented: hash each chunk, then combine each level
+// pairwise and carry an odd hash up to the next level
+hash_type reference_tree_hash(const std::string& data)
+{
+  std::vector<hash_type> level;
+  for (std::size_t i = 0; i < data.size(); i += tree_hash_chunk_size) {
+    const auto size = std::min(tree_hash_chunk_size, data.size() - i);
+    level.push_back(sha256(data.data() + i, size));
+  }
+  if (level.empty()) {
+    level.push_back(sha256(data.data(), 0));
+  }
+  while (level.size() > 1) {
+    std::vector<hash_type> parents;
+    for (std::size_t i = 0; i < level.size(); i += 2) {
+      if (i + 1 < level.size()) {
+        unsigned char pair[2 * tree_hash_size];
+        std::copy(level[i].begin(), level[i].end(), pair);
+        std::copy(level[i + 1].begin(), level[i + 1].end(),
+                  pair + tree_hash_size);
+        parents.push_back(sha256(pair, sizeof(pair)));
+      } else {
+        parents.push_back(level[i]);
+      }
+    }
+    level = std::move(parents);
+  }
+  return level.front();
+}
+
+std::string make_payload(std::size_t size)
+{
+  std::string payload(size, '\0');
+  for (std::size_t i = 0; i < size; i++) {
+    payload[i] = static_cast<char>(i * 31 + (i >> 12));
+  }
+  return payload;
+}
+
+hash_type serial_tree_hash(const std::string& data)
+{
+  hash_type result;
+  EXPECT_EQ(tree_hash_size, tree_hash(data.data(), data.size(), result.data()));
+  return result;
+}
+
+hash_type streaming_tree_hash(const std::string& data, std::size_t step)
+{
+  auto hasher = tree_hasher{};
+  for (std::size_t i = 0; i < data.size(); i += step) {
+    hasher.update(data.data() + i, std::min(step, data.size() - i));
+  }
+  hash_type result;
+  hasher.finish(result.data());
+  return result;
+}
+
+hash_type parallel_tree_hash(thread_pool& pool, const std::string& data)
+{
+  hash_type result;
+  EXPECT_EQ(tree_hash_size, tree_hash(pool, data.data(), data.size(),
+                                      result.data()));
+  return result;
+}
+
+TEST(tree_hash, empty)
+{
+  const auto expected = sha256("", 0);
+  EXPECT_EQ(expected, serial_tree_hash(""));
+  EXPECT_EQ(expected, streaming_tree_hash("", 1));
+  auto pool = thread_pool{2};
+  EXPECT_EQ(expected, parallel_tree_hash(pool, ""));
+}
+
+TEST(tree_hash, finish_hex)
+{
+  auto hasher = tree_hasher{};
+  char hex[2 * tree_hash_size];
+  ASSERT_EQ(sizeof(hex), hasher.finish_hex(hex));
+  EXPECT_EQ("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+            std::string_view(hex, sizeof(hex)));
+}
+
+TEST(tree_hash, sizes)
+{
+  auto pool = thread_pool{4};
+  constexpr std::size_t mib = tree_hash_chunk_size;
+  for (std::size_t size : {std::size_t{1}, mib - 1, mib, mib + 1,
+                           2 * mib, 3 * mib + 5, 5 * mib, 7 * mib,
+                           8 * mib, 9 * mib + 17}) {
+    SCOPED_TRACE(size);
+    const auto payload = make_payload(size);
+    const auto expected = reference_tree_hash(payload);
+    EXPECT_EQ(expected, serial_tree_hash(payload));
+    EXPECT_EQ(expected, streaming_tree_hash(payload, 4093));
+    EXPECT_EQ(expected, streaming_tree_hash(payload, mib));
+    EXPECT_EQ(expected, parallel_tree_hash(pool, payload));
+  }
+}
+
+TEST(tree_hash, single_worker)
+{
+  auto pool = thread_pool{1};
+  const auto payload = make_payload(6 * tree_hash_chunk_size + 3);
+  EXPECT_EQ(reference_tree_hash(payload), parallel_tree_hash(pool, payload));
+}
+
+TEST(thread_pool, nested_submit)
+{
+  std::atomic<int> count{0};
+  {
+    auto pool = thread_pool{3};
+    EXPECT_EQ(3u, pool.size());
+    for (int i = 0; i < 16; i++) {
+      pool.submit([&] {
+          for (int j = 0; j < 16; j++) {
+            pool.submit([&] { count++; });
+          }
+        });
+    }
+  } // destructor drains the queues
+  EXPECT_EQ(256, count.load());
+}
+
+TEST(thread_pool, parallel_for)
+{
+  auto pool = thread_pool{3};
+  std::vector<int> values(100);
+  pool.parallel_for(values.size(), [&] (std::size_t i) { values[i] = i; });
+  for (std::size_t i = 0; i < values.size(); i++) {
+    EXPECT_EQ(static_cast<int>(i), values[i]);
+  }
+  pool.parallel_for(0, [] (std::size_t) { FAIL(); });
+}
+
+TEST(thread_pool, parallel_for_exception)
+{
+  auto pool = thread_pool{2};
+  std::atomic<int> count{0};
+  EXPECT_THROW(pool.parallel_for(8, [&] (std::size_t i) {
+                   count++;
+                   if (i == 3) {
+                     throw std::runtime_error("oops");
+                   }
+                 }), std::runtime_error);
+  EXPECT_EQ(8, count.load());
+}
+
+TEST(tree_hash, from_worker)
+{
+  // the only worker waits on the tree hash's tasks, so it has to run them
+  auto pool = thread_pool{1};
+  const auto payload = make_payload(4 * tree_hash_chunk_size + 1);
+  hash_type result{};
+  std::atomic<bool> done{false};
+  pool.submit([&] {
+      result = parallel_tree_hash(pool, payload);
+      done = true;
+    });
+  while (!done) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(reference_tree_hash(payload), result);
+}
+
+} // namespace awssign
@@ -1,4 +1,6 @@
 #include <awssign/v4/detail/canonical_headers.hpp>
+#include <string>
+#include <vector>
 #include <gtest/gtest.h>
 
 namespace awssign::v4 {
@@ -181,4 +183,65 @@ TEST(canonical_headers, aws4_testsuite_get_header_value_trim)
             "x-amz-date:20150830T123600Z\n", result);
 }
 
+TEST(canonical_headers, known_names)
+{
+  // well-known names sort by rank among unrecognized names
+  const header_type headers[] = {
+    {"X-Amz-Date", "20150830T123600Z"},
+    {"x-amz-custom", "custom"},
+    {"HOST", "example.amazonaws.com"},
+    {"Content-Type", "text/plain"},
+    {"hosts", "other"},
+    {"host", "second"},
+    {"Content-Type-Extra", "extra"},
+  };
+  detail::canonical_header canonical[std::size(headers)];
+  const auto canonical_end = detail::sorted_canonical_headers(
+      std::begin(headers), std::end(headers), canonical);
+  std::string result;
+  detail::write_canonical_headers(canonical, canonical_end, capture{result});
+  EXPECT_EQ("content-type:text/plain\n"
+            "content-type-extra:extra\n"
+            "host:example.amazonaws.com,second\n"
+            "hosts:other\n"
+            "x-amz-custom:custom\n"
+            "x-amz-date:20150830T123600Z\n", result);
+  std::string signed_headers;
+  detail::write_signed_headers(canonical, canonical_end,
+                               capture{signed_headers});
+  EXPECT_EQ("content-type;content-type-extra;host;hosts;x-amz-custom;x-amz-date",
+            signed_headers);
+}
+
+TEST(canonical_headers, many)
+{
+  // enough headers to merge sort, with values that must keep their order
+  std::vector<std::string> names;
+  std::vector<std::string> values;
+  for (int i = 0; i < 40; i++) {
+    names.push_back("X-Header-" + std::to_string(9 - i % 10));
+    values.push_back(std::to_string(i));
+  }
+  std::vector<header_type> headers;
+  for (int i = 0; i < 40; i++) {
+    headers.emplace_back(names[i], values[i]);
+  }
+  std::vector<detail::canonical_header> canonical(headers.size());
+  const auto canonical_end = detail::sorted_canonical_headers(
+      headers.begin(), headers.end(), canonical.data());
+  std::string result;
+  detail::write_canonical_headers(canonical.data(), canonical_end,
+                                  capture{result});
+  EXPECT_EQ("x-header-0:9,19,29,39\n"
+            "x-header-1:8,18,28,38\n"
+            "x-header-2:7,17,27,37\n"
+            "x-header-3:6,16,26,36\n"
+            "x-header-4:5,15,25,35\n"
+            "x-header-5:4,14,24,34\n"
+            "x-header-6:3,13,23,33\n"
+            "x-header-7:2,12,22,32\n"
+            "x-header-8:1,11,21,31\n"
+            "x-header-9:0,10,20,30\n", result);
+}
+
 } // namespace awssign::v4
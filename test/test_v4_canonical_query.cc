@@ -1,4 +1,7 @@
 #include <awssign/v4/detail/canonical_query.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
 #include <gtest/gtest.h>
 
 namespace awssign::v4 {
@@ -41,6 +44,55 @@ TEST(canonical_query, sort_name_spaces)
   EXPECT_EQ("na%20me=value1&na%20me=value2", canonicalize("na me=value2&na+me=value1"));
 }
 
+TEST(canonical_query, sort_encoded_plus)
+{
+  // an encoded '+' sorts as a space too
+  EXPECT_EQ("a%20b=1&a%20b=2&a%20b=3", canonicalize("a%2Bb=3&a+b=2&a b=1"));
+}
+
+TEST(canonical_query, sort_bytes)
+{
+  // decoded bytes sort as unsigned, so utf-8 sorts after ascii
+  EXPECT_EQ("name=z&name=%C3%A9", canonicalize("name=%C3%A9&name=z"));
+}
+
+TEST(canonical_query, truncated_escape)
+{
+  EXPECT_EQ("a=1&b=", canonicalize("b=%&a=1"));
+}
+
+TEST(canonical_query, many)
+{
+  // enough parameters for the radix sort, with shared prefixes and escapes
+  std::vector<std::string> params;
+  for (int i = 0; i < 200; i++) {
+    const int n = i * 7919 % 200;
+    params.push_back("Entry.member." + std::to_string(n) +
+                     (n % 2 ? ".Id=id%2F" : ".Id=id/") + std::to_string(n));
+  }
+  std::string query;
+  for (const auto& p : params) {
+    if (!query.empty()) {
+      query += '&';
+    }
+    query += p;
+  }
+  std::vector<std::string> expected;
+  for (int i = 0; i < 200; i++) {
+    expected.push_back("Entry.member." + std::to_string(i) +
+                       ".Id=id%2F" + std::to_string(i));
+  }
+  std::sort(expected.begin(), expected.end());
+  std::string expected_query;
+  for (const auto& p : expected) {
+    if (!expected_query.empty()) {
+      expected_query += '&';
+    }
+    expected_query += p;
+  }
+  EXPECT_EQ(expected_query, canonicalize(query));
+}
+
 TEST(canonical_query, aws4_testsuite_vanilla_empty_query_key)
 {
   EXPECT_EQ("Param1=value1", canonicalize("Param1=value1"));
@@ -0,0 +1,89 @@
+#include <awssign/v4/checksum.hpp>
+#include <string>
+#include <gtest/gtest.h>
+
+namespace awssign::v4 {
+
+std::string base64(std::string_view input)
+{
+  std::string result;
+  auto p = reinterpret_cast<const unsigned char*>(input.data());
+  awssign::detail::base64_encode(p, p + input.size(),
+      [&result] (const char* begin, const char* end) {
+        result.append(begin, end);
+      });
+  return result;
+}
+
+TEST(base64_encode, rfc4648)
+{
+  EXPECT_EQ("", base64(""));
+  EXPECT_EQ("Zg==", base64("f"));
+  EXPECT_EQ("Zm8=", base64("fo"));
+  EXPECT_EQ("Zm9v", base64("foo"));
+  EXPECT_EQ("Zm9vYg==", base64("foob"));
+  EXPECT_EQ("Zm9vYmE=", base64("fooba"));
+  EXPECT_EQ("Zm9vYmFy", base64("foobar"));
+  EXPECT_EQ("/+8=", base64("\xff\xef"));
+}
+
+std::string finish(const checksum& crc)
+{
+  char buffer[checksum::max_base64_size];
+  return std::string(buffer, crc.finish(buffer));
+}
+
+TEST(checksum, header_names)
+{
+  EXPECT_EQ("x-amz-checksum-crc32",
+            checksum{checksum_algorithm::crc32}.header_name());
+  EXPECT_EQ("x-amz-checksum-crc32c",
+            checksum{checksum_algorithm::crc32c}.header_name());
+  EXPECT_EQ("x-amz-checksum-crc64nvme",
+            checksum{checksum_algorithm::crc64nvme}.header_name());
+}
+
+TEST(checksum, check_values)
+{
+  struct test_case {
+    checksum_algorithm algorithm;
+    std::uint64_t value;
+    std::string_view base64;
+  };
+  const test_case cases[] = {
+    {checksum_algorithm::crc32, 0xcbf43926, "y/Q5Jg=="},
+    {checksum_algorithm::crc32c, 0xe3069283, "4waSgw=="},
+    {checksum_algorithm::crc64nvme, 0xae8b14860a799888, "rosUhgp5mIg="},
+  };
+  for (const auto& c : cases) {
+    auto crc = checksum{c.algorithm};
+    crc.update("1234", 4);
+    crc.update("56789", 5);
+    EXPECT_EQ(c.value, crc.value());
+    EXPECT_EQ(c.base64, finish(crc));
+  }
+}
+
+TEST(checksum, empty)
+{
+  EXPECT_EQ("AAAAAA==", finish(checksum{checksum_algorithm::crc32}));
+  EXPECT_EQ("AAAAAAAAAAA=", finish(checksum{checksum_algorithm::crc64nvme}));
+}
+
+TEST(checksum, combine)
+{
+  for (auto algorithm : {checksum_algorithm::crc32, checksum_algorithm::crc32c,
+                         checksum_algorithm::crc64nvme}) {
+    SCOPED_TRACE(static_cast<int>(algorithm));
+    auto whole = checksum{algorithm};
+    whole.update("123456789", 9);
+    auto first = checksum{algorithm};
+    first.update("1234", 4);
+    auto second = checksum{algorithm};
+    second.update("56789", 5);
+    first.combine(second.value(), 5);
+    EXPECT_EQ(whole.value(), first.value());
+  }
+}
+
+} // namespace awssign::v4
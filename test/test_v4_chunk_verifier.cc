@@ -0,0 +1,350 @@
+#include <awssign/v4/chunk_verifier.hpp>
+#include <awssign/v4/chunk_signer.hpp>
+#include <string>
+#include <gtest/gtest.h>
+
+namespace awssign::v4 {
+
+// the aws-chunked example from the s3 documentation
+static constexpr auto secret_access_key =
+    "wJalrXUtnFEMI/K7MDENG/bPxRfiCYEXAMPLEKEY";
+static constexpr auto date = "20130524T000000Z";
+static constexpr auto region = "us-east-1";
+static constexpr auto service = "s3";
+static constexpr std::string_view seed_signature =
+    "4f232c4386841ef735655705268965c44a0e4690baa4adea153f7db9fa80a0a9";
+
+const signing_key& example_key()
+{
+  static const auto key = make_signing_key<sha256>(secret_access_key, date,
+                                                   region, service);
+  return key;
+}
+
+chunk_verifier make_verifier()
+{
+  return {sha256{}, example_key(), date, region, service, seed_signature};
+}
+
+// encode the payload as aws-chunked chunks of up to chunk_size bytes
+std::string encode(std::string_view payload, std::size_t chunk_size)
+{
+  auto signer = chunk_signer{sha256{}, example_key(), date, region, service,
+                             seed_signature};
+  std::string body;
+  char header[chunk_signer::max_header_size];
+  for (std::size_t i = 0; i < payload.size(); i += chunk_size) {
+    const auto data = payload.substr(i, chunk_size);
+    body.append(header, signer.write_header(data.data(), data.size(), header));
+    body.append(data).append(chunk_trailer);
+  }
+  body.append(header, signer.write_header(nullptr, 0, header));
+  body.append(chunk_trailer);
+  return body;
+}
+
+struct capture {
+  std::string& value;
+
+  void operator()(const char* begin, const char* end) {
+    value.append(begin, end);
+  }
+};
+
+// parse the whole body in pieces of the given size, and return the last status
+chunk_status parse(chunk_verifier& verifier, std::string_view body,
+                   std::size_t step, std::string& output, int* chunks)
+{
+  auto status = chunk_status::partial;
+  for (std::size_t i = 0; i < body.size(); i += step) {
+    const auto piece = body.substr(i, step);
+    const char* pos = piece.data();
+    const char* end = pos + piece.size();
+    while (pos != end) {
+      status = verifier.parse(pos, end, capture{output});
+      if (failed(status)) {
+        return status;
+      }
+      if (status == chunk_status::chunk) {
+        ++*chunks;
+      }
+    }
+  }
+  return status;
+}
+
+TEST(chunk_verifier, example)
+{
+  const auto payload = std::string(66560, 'a');
+  const auto body = encode(payload, 65536);
+  ASSERT_EQ(66824u, body.size());
+
+  for (std::size_t step : {body.size(), std::size_t{1}, std::size_t{7},
+                           std::size_t{4096}}) {
+    SCOPED_TRACE(step);
+    auto verifier = make_verifier();
+    std::string output;
+    int chunks = 0;
+    EXPECT_EQ(chunk_status::complete,
+              parse(verifier, body, step, output, &chunks));
+    EXPECT_EQ(2, chunks);
+    EXPECT_TRUE(verifier.is_complete());
+    EXPECT_EQ(payload.size(), verifier.decoded_size());
+    EXPECT_EQ(payload, output);
+    EXPECT_EQ("b6c6ea8a5354eaf15b3cb7646744f4275b71ea724fed81ceb9323e279d449df9",
+              verifier.signature());
+  }
+}
+
+TEST(chunk_verifier, empty_payload)
+{
+  auto verifier = make_verifier();
+  std::string output;
+  int chunks = 0;
+  EXPECT_EQ(chunk_status::complete,
+            parse(verifier, encode("", 1024), 16, output, &chunks));
+  EXPECT_EQ(0, chunks);
+  EXPECT_EQ(0u, verifier.decoded_size());
+}
+
+TEST(chunk_verifier, tampered_data)
+{
+  const auto payload = std::string(10 * 1024, 'a');
+  auto body = encode(payload, 1024);
+  // modify the data of the third chunk
+  const auto header_size = body.find("\r\n") + 2;
+  const auto chunk_size = header_size + 1024 + 2;
+  body[2 * chunk_size + header_size + 100] = 'b';
+
+  auto verifier = make_verifier();
+  std::string output;
+  int chunks = 0;
+  EXPECT_EQ(chunk_status::signature_mismatch,
+            parse(verifier, body, 512, output, &chunks));
+  EXPECT_EQ(2, chunks);
+  EXPECT_EQ(2048u, verifier.decoded_size());
+  EXPECT_FALSE(verifier.is_complete());
+
+  // the error sticks
+  const char* pos = body.data();
+  EXPECT_EQ(chunk_status::signature_mismatch,
+            verifier.parse(pos, pos + body.size(), capture{output}));
+}
+
+TEST(chunk_verifier, reordered_chunks)
+{
+  const auto payload = std::string(1024, 'a') + std::string(1024, 'b');
+  const auto body = encode(payload, 1024);
+  const auto chunk_size = body.find("\r\n") + 2 + 1024 + 2;
+  const auto swapped = body.substr(chunk_size, chunk_size) +
+      body.substr(0, chunk_size) + body.substr(2 * chunk_size);
+
+  auto verifier = make_verifier();
+  std::string output;
+  int chunks = 0;
+  EXPECT_EQ(chunk_status::signature_mismatch,
+            parse(verifier, swapped, swapped.size(), output, &chunks));
+  EXPECT_EQ(0, chunks);
+}
+
+chunk_status parse_body(std::string_view body)
+{
+  auto verifier = make_verifier();
+  std::string output;
+  int chunks = 0;
+  return parse(verifier, body, body.size(), output, &chunks);
+}
+
+TEST(chunk_verifier, malformed)
+{
+  const auto body = encode("abc", 1024);
+  const auto signature = body.substr(body.find('=') + 1, 64);
+
+  EXPECT_EQ(chunk_status::invalid_size, parse_body(";chunk-signature="));
+  EXPECT_EQ(chunk_status::invalid_size, parse_body("x"));
+  EXPECT_EQ(chunk_status::invalid_size, parse_body("00000000000000003;"));
+  EXPECT_EQ(chunk_status::invalid_extension, parse_body("3;chunk-sig="));
+  EXPECT_EQ(chunk_status::invalid_extension, parse_body("3\r\n"));
+  EXPECT_EQ(chunk_status::invalid_signature,
+            parse_body("3;chunk-signature=xyz"));
+  EXPECT_EQ(chunk_status::invalid_signature,
+            parse_body("3;chunk-signature=" + std::string(signature) + "0"));
+  EXPECT_EQ(chunk_status::missing_crlf,
+            parse_body("3;chunk-signature=" + std::string(signature) + "\n"));
+  EXPECT_EQ(chunk_status::missing_crlf,
+            parse_body("3;chunk-signature=" + std::string(signature) +
+                       "\r\nabcd"));
+  EXPECT_EQ(chunk_status::partial,
+            parse_body("3;chunk-signature=" + std::string(signature) +
+                       "\r\nab"));
+  EXPECT_EQ(chunk_status::unexpected_data, parse_body(body + "x"));
+}
+
+// encode the payload with a signed checksum trailer
+std::string encode_trailer(std::string_view payload, std::size_t chunk_size,
+                           checksum_algorithm algorithm)
+{
+  auto signer = chunk_signer{sha256{}, example_key(), date, region, service,
+                             seed_signature, algorithm};
+  std::string body;
+  char header[chunk_signer::max_header_size];
+  for (std::size_t i = 0; i < payload.size(); i += chunk_size) {
+    const auto data = payload.substr(i, chunk_size);
+    body.append(header, signer.write_header(data.data(), data.size(), header));
+    body.append(data).append(chunk_trailer);
+  }
+  body.append(header, signer.write_header(nullptr, 0, header));
+  signer.write_trailer(capture{body});
+  EXPECT_EQ(signer.encoded_size(payload.size(), chunk_size), body.size());
+  return body;
+}
+
+chunk_verifier make_trailer_verifier(checksum_algorithm algorithm)
+{
+  return {sha256{}, example_key(), date, region, service, seed_signature,
+          algorithm};
+}
+
+TEST(chunk_verifier, signed_trailer)
+{
+  const auto payload = std::string(5000, 'x');
+  for (auto algorithm : {checksum_algorithm::crc32,
+                         checksum_algorithm::crc32c,
+                         checksum_algorithm::crc64nvme}) {
+    const auto body = encode_trailer(payload, 1024, algorithm);
+    auto crc = checksum{algorithm};
+    crc.update(payload.data(), payload.size());
+    char value[checksum::max_base64_size];
+    const auto trailer = std::string(crc.header_name()) + ":" +
+        std::string(value, crc.finish(value)) + "\r\n";
+    EXPECT_NE(body.npos, body.find("\r\n0;chunk-signature="));
+    EXPECT_NE(body.npos, body.find(trailer + "x-amz-trailer-signature:"));
+    EXPECT_EQ("\r\n\r\n", body.substr(body.size() - 4));
+
+    for (std::size_t step : {body.size(), std::size_t{1}, std::size_t{100}}) {
+      SCOPED_TRACE(step);
+      auto verifier = make_trailer_verifier(algorithm);
+      std::string output;
+      int chunks = 0;
+      EXPECT_EQ(chunk_status::complete,
+                parse(verifier, body, step, output, &chunks));
+      EXPECT_EQ(5, chunks);
+      EXPECT_EQ(payload, output);
+    }
+  }
+}
+
+// the example with a crc32c trailer from the s3 documentation, "Signature
+// calculation: Including trailing headers (chunked upload)"
+TEST(chunk_verifier, trailer_example)
+{
+  const auto payload = std::string(66560, 'a');
+  const auto body =
+      "10000;chunk-signature=b474d8862b1487a5145d686f57f013e54db672cee1c953b3010fb58501ef5aa2\r\n" +
+      payload.substr(0, 65536) + "\r\n" +
+      "400;chunk-signature=1c1344b170168f8e65b41376b44b20fe354e373826ccbbe2c1d40a8cae51e5c7\r\n" +
+      payload.substr(65536) + "\r\n" +
+      "0;chunk-signature=2ca2aba2005185cf7159c6277faf83795951dd77a3a99e6e65d5c9f85863f992\r\n"
+      "x-amz-checksum-crc32c:sOO8/Q==\r\n"
+      "x-amz-trailer-signature:d81f82fc3505edab99d459891051a732e8730629a2e4a59689829ca17fe2e435\r\n\r\n";
+  for (std::size_t step : {body.size(), std::size_t{7}}) {
+    SCOPED_TRACE(step);
+    auto verifier = chunk_verifier{sha256{}, example_key(), date, region,
+        service,
+        "106e2a8a18243abcf37539882f36619c00e2dfc72633413f02d3b74544bfeb8e",
+        checksum_algorithm::crc32c};
+    std::string output;
+    int chunks = 0;
+    EXPECT_EQ(chunk_status::complete,
+              parse(verifier, body, step, output, &chunks));
+    EXPECT_EQ(2, chunks);
+    EXPECT_EQ(payload, output);
+  }
+}
+
+TEST(chunk_verifier, signed_trailer_tampered)
+{
+  const auto payload = std::string(3000, 'x');
+  const auto body = encode_trailer(payload, 1024, checksum_algorithm::crc32c);
+  const auto trailer = body.find("x-amz-checksum-crc32c:");
+  const auto signature = body.find("x-amz-trailer-signature:");
+  std::string output;
+  int chunks = 0;
+
+  { // the checksum value
+    auto tampered = body;
+    tampered[trailer + 23] ^= 1;
+    auto verifier = make_trailer_verifier(checksum_algorithm::crc32c);
+    EXPECT_EQ(chunk_status::signature_mismatch,
+              parse(verifier, tampered, tampered.size(), output, &chunks));
+  }
+  { // the trailer signature
+    auto tampered = body;
+    tampered[signature + 30] = tampered[signature + 30] == 'a' ? 'b' : 'a';
+    auto verifier = make_trailer_verifier(checksum_algorithm::crc32c);
+    EXPECT_EQ(chunk_status::signature_mismatch,
+              parse(verifier, tampered, tampered.size(), output, &chunks));
+  }
+  { // no trailer signature
+    const auto tampered = body.substr(0, signature) + "\r\n";
+    auto verifier = make_trailer_verifier(checksum_algorithm::crc32c);
+    EXPECT_EQ(chunk_status::invalid_trailer,
+              parse(verifier, tampered, tampered.size(), output, &chunks));
+  }
+  { // expecting a different checksum
+    auto verifier = make_trailer_verifier(checksum_algorithm::crc32);
+    EXPECT_EQ(chunk_status::invalid_trailer,
+              parse(verifier, body, body.size(), output, &chunks));
+  }
+  { // trailers without a checksum algorithm
+    auto verifier = make_verifier();
+    EXPECT_EQ(chunk_status::missing_crlf,
+              parse(verifier, body, body.size(), output, &chunks));
+  }
+}
+
+TEST(chunk_verifier, unsigned_trailer)
+{
+  const auto payload = std::string(2500, 'y');
+  auto writer = unsigned_chunk_writer{checksum_algorithm::crc64nvme};
+  std::string body;
+  char header[unsigned_chunk_writer::max_header_size];
+  for (std::size_t i = 0; i < payload.size(); i += 1024) {
+    const auto data = std::string_view{payload}.substr(i, 1024);
+    body.append(header, writer.write_header(data.data(), data.size(), header));
+    body.append(data).append(chunk_trailer);
+  }
+  body.append(header, writer.write_header(header));
+  writer.write_trailer(capture{body});
+  EXPECT_EQ(writer.encoded_size(payload.size(), 1024), body.size());
+  EXPECT_EQ("400\r\n", body.substr(0, 5));
+
+  auto crc = checksum{checksum_algorithm::crc64nvme};
+  crc.update(payload.data(), payload.size());
+  char value[checksum::max_base64_size];
+  EXPECT_EQ("0\r\nx-amz-checksum-crc64nvme:" +
+            std::string(value, crc.finish(value)) + "\r\n\r\n",
+            body.substr(body.find("\r\n0\r\n") + 2));
+
+  {
+    auto verifier = chunk_verifier{checksum_algorithm::crc64nvme};
+    std::string output;
+    int chunks = 0;
+    EXPECT_EQ(chunk_status::complete,
+              parse(verifier, body, 7, output, &chunks));
+    EXPECT_EQ(3, chunks);
+    EXPECT_EQ(payload, output);
+    EXPECT_EQ("", verifier.signature());
+  }
+  { // corrupt data is caught by the checksum
+    auto tampered = body;
+    tampered[100] = 'z';
+    auto verifier = chunk_verifier{checksum_algorithm::crc64nvme};
+    std::string output;
+    int chunks = 0;
+    EXPECT_EQ(chunk_status::checksum_mismatch,
+              parse(verifier, tampered, tampered.size(), output, &chunks));
+  }
+}
+
+} // namespace awssign::v4
@@ -0,0 +1,175 @@
+#include <awssign/v4/header_template.hpp>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace awssign::v4 {
+
+static constexpr auto access_key_id = "AKIDEXAMPLE";
+static constexpr auto secret_access_key =
+    "wJalrXUtnFEMI/K7MDENG+bPxRfiCYEXAMPLEKEY";
+static constexpr std::string_view empty_payload_hash =
+    "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855";
+
+struct capture {
+  std::string& value;
+
+  template <typename Iterator> // forward iterator with value_type=char
+  void operator()(Iterator begin, Iterator end) {
+    value.append(begin, end);
+  }
+};
+
+struct header_type {
+  header_type(std::string_view name, std::string_view value) noexcept
+      : name_(name), value_(value)
+  {}
+  std::string_view name_string() const { return name_; }
+  std::string_view value() const { return value_; }
+ private:
+  std::string_view name_;
+  std::string_view value_;
+};
+
+// write the template's headers with the given values
+std::string write(const header_template& headers,
+                  const std::vector<std::string_view>& values)
+{
+  std::string result;
+  headers.write_canonical_headers(values.data(), capture{result});
+  return result;
+}
+
+// write the same headers without a template
+std::string write(std::vector<header_type> headers)
+{
+  std::vector<detail::canonical_header> canonical(headers.size());
+  const auto end = detail::sorted_canonical_headers(
+      headers.begin(), headers.end(), canonical.data());
+  std::string result;
+  detail::write_canonical_headers(canonical.data(), end, capture{result});
+  result += '\n';
+  detail::write_signed_headers(canonical.data(), end, capture{result});
+  return result;
+}
+
+TEST(header_template, static_only)
+{
+  const header_type headers[] = {
+    {"Host", "example.amazonaws.com"},
+    {"My-Header1", "  value1\n  value2  "},
+  };
+  const auto names = std::vector<std::string_view>{};
+  const auto t = header_template{std::begin(headers), std::end(headers),
+                                 names.begin(), names.end()};
+  EXPECT_EQ(0, t.dynamic_count());
+  EXPECT_EQ("host;my-header1", t.signed_headers());
+  EXPECT_EQ("host:example.amazonaws.com\nmy-header1:value1 value2\n\n"
+            "host;my-header1", write(t, {}));
+}
+
+TEST(header_template, dynamic_only)
+{
+  const std::string_view names[] = {"X-Amz-Date", "Host"};
+  const auto headers = std::vector<header_type>{};
+  const auto t = header_template{headers.begin(), headers.end(),
+                                 std::begin(names), std::end(names)};
+  EXPECT_EQ(2, t.dynamic_count());
+  EXPECT_EQ("host;x-amz-date", t.signed_headers());
+  EXPECT_EQ(write({{"X-Amz-Date", "20150830T123600Z"},
+                   {"Host", " example.amazonaws.com"}}),
+            write(t, {"20150830T123600Z", " example.amazonaws.com"}));
+}
+
+TEST(header_template, mixed)
+{
+  const header_type headers[] = {
+    {"User-Agent", "client/1.0"},
+    {"Host", "example.amazonaws.com"},
+    {"Content-Type", "application/octet-stream"},
+    {"X-Amz-Security-Token", "token"},
+    {"My-Header1", "value1"},
+  };
+  const std::string_view names[] = {
+    "X-Amz-Date", "X-Amz-Content-SHA256", "My-Header1", "Zzz"
+  };
+  const auto t = header_template{std::begin(headers), std::end(headers),
+                                 std::begin(names), std::end(names)};
+  EXPECT_EQ(4, t.dynamic_count());
+  EXPECT_EQ("content-type;host;my-header1;user-agent;"
+            "x-amz-content-sha256;x-amz-date;x-amz-security-token;zzz",
+            t.signed_headers());
+  // a dynamic name that's also static lists its value after the static one
+  auto expected = std::vector<header_type>{std::begin(headers),
+                                           std::end(headers)};
+  expected.emplace_back("X-Amz-Date", "20150830T123600Z");
+  expected.emplace_back("X-Amz-Content-SHA256", "UNSIGNED-PAYLOAD");
+  expected.emplace_back("My-Header1", "a  b");
+  expected.emplace_back("Zzz", "");
+  EXPECT_EQ(write(expected),
+            write(t, {"20150830T123600Z", "UNSIGNED-PAYLOAD", "a  b", ""}));
+}
+
+TEST(header_template, sign)
+{
+  const header_type static_headers[] = {
+    {"Host", "bucket.s3.amazonaws.com"},
+    {"User-Agent", "client/1.0"},
+  };
+  const std::string_view names[] = {"X-Amz-Date", "X-Amz-Content-SHA256"};
+  const auto t = header_template{std::begin(static_headers),
+                                 std::end(static_headers),
+                                 std::begin(names), std::end(names)};
+  const auto key = make_signing_key<sha256>(secret_access_key, "20150830",
+                                            "us-east-1", "s3");
+  for (std::string_view date : {"20150830T123600Z", "20150830T123601Z"}) {
+    const header_type headers[] = {
+      {"Host", "bucket.s3.amazonaws.com"},
+      {"User-Agent", "client/1.0"},
+      {"X-Amz-Date", date},
+      {"X-Amz-Content-SHA256", empty_payload_hash},
+    };
+    std::string expected;
+    sign<sha256>(access_key_id, key, "GET", "/a%20b", "x=y",
+                 std::begin(headers), std::end(headers), empty_payload_hash,
+                 date, "us-east-1", "s3", capture{expected});
+
+    const std::string_view values[] = {date, empty_payload_hash};
+    std::string result;
+    sign<sha256>(access_key_id, key, "GET", "/a%20b", "x=y", t, values,
+                 empty_payload_hash, date, "us-east-1", "s3",
+                 capture{result});
+    EXPECT_EQ(expected, result);
+
+    result.clear();
+    sign("SHA256", access_key_id, key, "GET", "/a%20b", "x=y", t, values,
+         empty_payload_hash, date, "us-east-1", "s3", capture{result});
+    EXPECT_EQ(expected, result);
+  }
+}
+
+TEST(header_template, aws4_testsuite_get_header_key_duplicate)
+{
+  const header_type headers[] = {
+    {"Host", "example.amazonaws.com"},
+    {"My-Header1", "value2"},
+    {"My-Header1", "value2"},
+    {"My-Header1", "value1"},
+  };
+  const std::string_view names[] = {"X-Amz-Date"};
+  const auto t = header_template{std::begin(headers), std::end(headers),
+                                 std::begin(names), std::end(names)};
+  const auto key = make_signing_key<sha256>(secret_access_key, "20150830",
+                                            "us-east-1", "service");
+  const std::string_view values[] = {"20150830T123600Z"};
+  std::string result;
+  sign<sha256>(access_key_id, key, "GET", "/", "", t, values,
+               empty_payload_hash, "20150830T123600Z", "us-east-1",
+               "service", capture{result});
+  EXPECT_EQ(result, "AWS4-HMAC-SHA256 \
+Credential=AKIDEXAMPLE/20150830/us-east-1/service/aws4_request, \
+SignedHeaders=host;my-header1;x-amz-date, \
+Signature=c9d5ea9f3f72853aea855b47ea873832890dbdd183b4468f858259531a5138ea");
+}
+
+} // namespace awssign::v4
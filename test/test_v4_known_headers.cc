@@ -0,0 +1,46 @@
+#include <awssign/v4/detail/known_headers.hpp>
+#include <string>
+#include <gtest/gtest.h>
+
+namespace awssign::v4 {
+
+TEST(known_headers, rank)
+{
+  for (int i = 0; i < detail::known_header_count; i++) {
+    EXPECT_EQ(i, detail::known_header_rank(detail::known_header_names[i]));
+  }
+}
+
+TEST(known_headers, ignores_case)
+{
+  const int host = detail::known_header_rank("host");
+  ASSERT_LE(0, host);
+  EXPECT_EQ(host, detail::known_header_rank("Host"));
+  EXPECT_EQ(host, detail::known_header_rank("HOST"));
+  const int date = detail::known_header_rank("x-amz-date");
+  ASSERT_LE(0, date);
+  EXPECT_EQ(date, detail::known_header_rank("X-Amz-Date"));
+  EXPECT_LT(host, date);
+}
+
+TEST(known_headers, unknown)
+{
+  EXPECT_EQ(-1, detail::known_header_rank(""));
+  EXPECT_EQ(-1, detail::known_header_rank("a"));
+  EXPECT_EQ(-1, detail::known_header_rank("hosts"));
+  EXPECT_EQ(-1, detail::known_header_rank("x-amz-meta-foo"));
+  EXPECT_EQ(-1, detail::known_header_rank("my-header1"));
+  // same length and hashed characters as "host", but not equal
+  EXPECT_EQ(-1, detail::known_header_rank("hest"));
+  // case folding by 0x20 would map these onto '-' and digits
+  EXPECT_EQ(-1, detail::known_header_rank("x\rAMZ\rDATE"));
+  EXPECT_EQ(-1, detail::known_header_rank(std::string(200, 'x')));
+}
+
+TEST(known_headers, constant)
+{
+  static_assert(detail::known_header_rank("Content-Type") >= 0);
+  static_assert(detail::known_header_rank("Content-Typo") < 0);
+}
+
+} // namespace awssign::v4
@@ -0,0 +1,159 @@
+#include <awssign/v4/multipart_hashes.hpp>
+#include <cstdio>
+#include <string>
+#include <gtest/gtest.h>
+
+namespace awssign::v4 {
+
+std::string make_payload(std::size_t size)
+{
+  std::string payload(size, '\0');
+  for (std::size_t i = 0; i < size; i++) {
+    payload[i] = static_cast<char>(i * 131 + i / 4096);
+  }
+  return payload;
+}
+
+// a temporary file that's removed on destruction
+struct temp_file {
+  std::FILE* file = std::tmpfile();
+  ~temp_file() { std::fclose(file); }
+  int fd() const { return ::fileno(file); }
+};
+
+std::string payload_hash(std::string_view data)
+{
+  auto hasher = payload_hasher{};
+  hasher.update(data);
+  char buffer[payload_hasher::max_hex_size];
+  return std::string(buffer, hasher.finish(buffer));
+}
+
+std::string checksum_of(checksum_algorithm algorithm, std::string_view data)
+{
+  auto crc = checksum{algorithm};
+  crc.update(data.data(), data.size());
+  char buffer[checksum::max_base64_size];
+  return std::string(buffer, crc.finish(buffer));
+}
+
+// check each part against a serial hash of its data, the composite against
+// the checksum of the parts' big-endian checksums, and the full object
+// checksum against the checksum of the payload
+void expect_parts(const multipart_hashes& hashes, std::string_view payload,
+                  std::size_t part_size, checksum_algorithm algorithm)
+{
+  const auto& parts = hashes.parts();
+  ASSERT_EQ(std::max<std::size_t>(1, (payload.size() + part_size - 1) /
+                                     part_size), parts.size());
+  const int bytes = algorithm == checksum_algorithm::crc64nvme ? 8 : 4;
+  std::string checksums;
+  for (std::size_t i = 0; i < parts.size(); i++) {
+    SCOPED_TRACE(i);
+    const auto data = payload.substr(i * part_size, part_size);
+    EXPECT_EQ(i * part_size, parts[i].offset);
+    EXPECT_EQ(data.size(), parts[i].size);
+    EXPECT_EQ(payload_hash(data), parts[i].payload_hash_view());
+    EXPECT_EQ(checksum_of(algorithm, data), parts[i].checksum_view());
+
+    auto crc = checksum{algorithm};
+    crc.update(data.data(), data.size());
+    for (int b = bytes - 1; b >= 0; b--) {
+      checksums.push_back(static_cast<char>(crc.value() >> (8 * b)));
+    }
+  }
+  if (algorithm == checksum_algorithm::crc64nvme) {
+    EXPECT_EQ("", hashes.composite_checksum()); // not supported by s3
+  } else {
+    EXPECT_EQ(checksum_of(algorithm, checksums) + "-" +
+              std::to_string(parts.size()), hashes.composite_checksum());
+  }
+  EXPECT_EQ(checksum_of(algorithm, payload), hashes.full_object_checksum());
+}
+
+TEST(multipart_hashes, memory)
+{
+  auto pool = thread_pool{4};
+  const auto payload = make_payload(100000);
+  for (auto algorithm : {checksum_algorithm::crc32, checksum_algorithm::crc32c,
+                         checksum_algorithm::crc64nvme}) {
+    SCOPED_TRACE(static_cast<int>(algorithm));
+    for (std::size_t part_size : {1000, 4096, 99999, 100000, 200000}) {
+      SCOPED_TRACE(part_size);
+      const auto hashes = multipart_hashes{pool, payload.data(), payload.size(),
+                                           part_size, algorithm};
+      expect_parts(hashes, payload, part_size, algorithm);
+    }
+  }
+}
+
+TEST(multipart_hashes, known_composite)
+{
+  auto pool = thread_pool{2};
+  const auto hashes = multipart_hashes{pool, "123456789", 9, 5,
+                                       checksum_algorithm::crc32};
+  ASSERT_EQ(2u, hashes.parts().size());
+  EXPECT_EQ("y/U6HA==", hashes.parts()[0].checksum_view()); // crc32 "12345"
+  EXPECT_EQ("4zspdQ==-2", hashes.composite_checksum());
+  EXPECT_EQ("y/Q5Jg==", hashes.full_object_checksum()); // crc32 "123456789"
+}
+
+TEST(multipart_hashes, without_checksum)
+{
+  auto pool = thread_pool{2};
+  const auto payload = make_payload(10000);
+  const auto hashes = multipart_hashes{pool, payload.data(), payload.size(),
+                                       3000};
+  ASSERT_EQ(4u, hashes.parts().size());
+  EXPECT_EQ(payload_hash(std::string_view{payload}.substr(9000)),
+            hashes.parts()[3].payload_hash_view());
+  EXPECT_EQ("", hashes.parts()[3].checksum_view());
+  EXPECT_EQ("", hashes.composite_checksum());
+  EXPECT_EQ("", hashes.full_object_checksum());
+}
+
+TEST(multipart_hashes, empty)
+{
+  auto pool = thread_pool{1};
+  const auto hashes = multipart_hashes{pool, nullptr, 0, 1024,
+                                       checksum_algorithm::crc32c};
+  ASSERT_EQ(1u, hashes.parts().size());
+  EXPECT_EQ(payload_hash(""), hashes.parts()[0].payload_hash_view());
+  EXPECT_EQ("AAAAAA==", hashes.parts()[0].checksum_view());
+  EXPECT_EQ("AAAAAA==", hashes.full_object_checksum());
+}
+
+TEST(multipart_hashes, file)
+{
+  auto pool = thread_pool{4};
+  // small files are read with pread(), large files are mapped
+  for (std::size_t size : {std::size_t{10000},
+                           payload_hasher::map_threshold + 12345}) {
+    SCOPED_TRACE(size);
+    const auto payload = make_payload(size);
+    temp_file file;
+    ASSERT_EQ(size, std::fwrite(payload.data(), 1, size, file.file));
+    ASSERT_EQ(0, std::fflush(file.file));
+    const auto hashes = multipart_hashes{pool, file.fd(), 4096,
+                                         checksum_algorithm::crc64nvme};
+    expect_parts(hashes, payload, 4096, checksum_algorithm::crc64nvme);
+  }
+}
+
+TEST(multipart_hashes, not_a_file)
+{
+  auto pool = thread_pool{1};
+  int fds[2];
+  ASSERT_EQ(0, ::pipe(fds));
+  EXPECT_THROW(multipart_hashes(pool, fds[0], 1024), std::system_error);
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+TEST(multipart_hashes, zero_part_size)
+{
+  auto pool = thread_pool{1};
+  EXPECT_THROW(multipart_hashes(pool, "abc", 3, 0), std::invalid_argument);
+}
+
+} // namespace awssign::v4
@@ -0,0 +1,162 @@
+#include <awssign/v4/payload_hasher.hpp>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace awssign::v4 {
+
+// sha256sum of empty buffer
+static constexpr std::string_view empty_payload_hash =
+    "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855";
+
+std::string finish(payload_hasher& hasher)
+{
+  char buffer[payload_hasher::max_hex_size];
+  const auto size = hasher.finish(buffer);
+  return std::string(buffer, size);
+}
+
+std::string hash_string(std::string_view data)
+{
+  auto hasher = payload_hasher{};
+  hasher.update(data);
+  return finish(hasher);
+}
+
+std::string make_payload(std::size_t size)
+{
+  std::string payload(size, '\0');
+  for (std::size_t i = 0; i < size; i++) {
+    payload[i] = static_cast<char>(i * 131 + i / 4096);
+  }
+  return payload;
+}
+
+// a temporary file that's removed on destruction
+struct temp_file {
+  std::FILE* file = std::tmpfile();
+  ~temp_file() { std::fclose(file); }
+  int fd() const { return ::fileno(file); }
+
+  void write(std::string_view data) {
+    ASSERT_EQ(data.size(), ::write(fd(), data.data(), data.size()));
+    ::lseek(fd(), 0, SEEK_SET);
+  }
+};
+
+TEST(payload_hasher, empty)
+{
+  auto hasher = payload_hasher{};
+  EXPECT_EQ(empty_payload_hash, finish(hasher));
+}
+
+TEST(payload_hasher, foo)
+{
+  // $ echo -n 'foo' | sha256sum
+  EXPECT_EQ("2c26b46b68ffc68ff99b453c1d30413413422d706483bfa0f98a5e886266e7ae",
+            hash_string("foo"));
+}
+
+TEST(payload_hasher, named_hash)
+{
+  auto hasher = payload_hasher{"SHA256"};
+  EXPECT_EQ(empty_payload_hash, finish(hasher));
+}
+
+TEST(payload_hasher, iovec)
+{
+  const auto payload = make_payload(1000);
+  char* data = const_cast<char*>(payload.data());
+  const ::iovec iov[] = {{data, 1}, {data + 1, 0}, {data + 1, 500},
+                         {data + 501, 499}};
+  auto hasher = payload_hasher{};
+  hasher.update_iovec(iov, std::size(iov));
+  EXPECT_EQ(hash_string(payload), finish(hasher));
+}
+
+// a buffer type like asio::const_buffer
+struct const_buffer {
+  const void* data_;
+  std::size_t size_;
+  const void* data() const { return data_; }
+  std::size_t size() const { return size_; }
+};
+
+TEST(payload_hasher, buffer_sequence)
+{
+  const auto payload = make_payload(1000);
+  const auto buffers = std::vector<const_buffer>{
+    {payload.data(), 10}, {payload.data() + 10, 990}};
+  auto hasher = payload_hasher{};
+  hasher.update_buffers(buffers);
+  EXPECT_EQ(hash_string(payload), finish(hasher));
+
+  auto single = payload_hasher{};
+  single.update_buffers(const_buffer{payload.data(), payload.size()});
+  EXPECT_EQ(hash_string(payload), finish(single));
+}
+
+TEST(payload_hasher, file)
+{
+  // larger than read_size, and not a multiple of the page size
+  const auto payload = make_payload(payload_hasher::read_size * 2 + 12345);
+  temp_file file;
+  file.write(payload);
+  const auto expected = hash_string(payload);
+  {
+    auto hasher = payload_hasher{};
+    EXPECT_TRUE(hasher.update_mapped(file.fd()));
+    EXPECT_EQ(expected, finish(hasher));
+    EXPECT_EQ(payload.size(), ::lseek(file.fd(), 0, SEEK_CUR));
+  }
+  {
+    ::lseek(file.fd(), 0, SEEK_SET);
+    auto hasher = payload_hasher{};
+    hasher.update_read(file.fd());
+    EXPECT_EQ(expected, finish(hasher));
+  }
+  {
+    // from an offset that isn't page aligned
+    ::lseek(file.fd(), 5000, SEEK_SET);
+    auto hasher = payload_hasher{};
+    hasher.update_file(file.fd());
+    EXPECT_EQ(hash_string(std::string_view{payload}.substr(5000)),
+              finish(hasher));
+  }
+  {
+    // near the end, where the rest is smaller than map_threshold
+    const auto offset = payload.size() - 100;
+    ::lseek(file.fd(), offset, SEEK_SET);
+    auto hasher = payload_hasher{};
+    hasher.update_file(file.fd());
+    EXPECT_EQ(hash_string(std::string_view{payload}.substr(offset)),
+              finish(hasher));
+    EXPECT_EQ(payload.size(), ::lseek(file.fd(), 0, SEEK_CUR));
+  }
+}
+
+TEST(payload_hasher, empty_file)
+{
+  temp_file file;
+  auto hasher = payload_hasher{};
+  hasher.update_file(file.fd());
+  EXPECT_EQ(empty_payload_hash, finish(hasher));
+}
+
+TEST(payload_hasher, pipe)
+{
+  int fds[2];
+  ASSERT_EQ(0, ::pipe(fds));
+  const auto payload = make_payload(4000); // fits in the pipe buffer
+  ASSERT_EQ(payload.size(), ::write(fds[1], payload.data(), payload.size()));
+  ::close(fds[1]);
+
+  auto hasher = payload_hasher{};
+  EXPECT_FALSE(hasher.update_mapped(fds[0]));
+  hasher.update_file(fds[0]);
+  ::close(fds[0]);
+  EXPECT_EQ(hash_string(payload), finish(hasher));
+}
+
+} // namespace awssign::v4
@@ -1,4 +1,5 @@
 #include <awssign/v4/sign.hpp>
+#include <vector>
 #include <gtest/gtest.h>
 
 namespace awssign::v4 {
@@ -120,4 +121,184 @@ SignedHeaders=host;my-header1;my-header2;x-amz-date, \
 Signature=acc3ed3afb60bb290fc8d2dd0098b9911fcaa05412b367055dee359757a9c736");
 }
 
+TEST(signing_key, example_sha256)
+{
+  unsigned char signing_key[sha256::digest_size] = {};
+  const int signing_key_size = detail::build_signing_key<sha256>(
+      secret_access_key, "20150830", "us-east-1", "iam", signing_key);
+
+  std::string result;
+  detail::hex_encode(signing_key, signing_key + signing_key_size,
+                     capture{result});
+  EXPECT_EQ(result, "c4afb1cc5771d871763a393e44b703571b55cc28424d1a5e86da6ed3c154a4b9");
+}
+
+TEST(sign, sha256)
+{
+  const header_type headers[] = {
+    {"Host", "example.amazonaws.com"},
+    {"My-Header1", " value1"},
+    {"My-Header2", " \"a   b   c\""},
+    {"X-Amz-Date", "20150830T123600Z"},
+  };
+  std::string result;
+  sign<sha256>(access_key_id, secret_access_key, "GET", "/", "",
+               std::begin(headers), std::end(headers), empty_payload_hash,
+               "20150830T123600Z", "us-east-1", "service", capture{result});
+  EXPECT_EQ(result, "AWS4-HMAC-SHA256 \
+Credential=AKIDEXAMPLE/20150830/us-east-1/service/aws4_request, \
+SignedHeaders=host;my-header1;my-header2;x-amz-date, \
+Signature=acc3ed3afb60bb290fc8d2dd0098b9911fcaa05412b367055dee359757a9c736");
+}
+
+TEST(signing_key, build_signing_keys)
+{
+  const std::string long_secret(100, 'k');
+  // more scopes than lanes, with a secret that's longer than a block
+  std::vector<signing_key_scope> scopes;
+  for (int i = 0; i < 40; i++) {
+    scopes.push_back({i % 3 ? std::string_view{secret_access_key} : long_secret,
+                      i % 2 ? "20150830" : "20150830T123600Z",
+                      i % 4 ? "us-east-1" : "eu-central-1",
+                      i % 5 ? "iam" : "s3"});
+  }
+  std::vector<unsigned char> keys(scopes.size() * sha256::digest_size);
+  detail::build_signing_keys(sha256{}, scopes.begin(), scopes.end(),
+                             keys.data());
+  for (std::size_t i = 0; i < scopes.size(); i++) {
+    const auto& s = scopes[i];
+    unsigned char expected[sha256::digest_size];
+    detail::build_signing_key<sha256>(s.secret_access_key, s.date,
+                                      s.region, s.service, expected);
+    EXPECT_TRUE(std::equal(std::begin(expected), std::end(expected),
+                           keys.data() + i * sha256::digest_size)) << i;
+  }
+}
+
+TEST(signing_key, long_secret)
+{
+  // secrets that differ after 252 bytes, which used to be truncated
+  const std::string secret1 = std::string(300, 'k') + "1";
+  const std::string secret2 = std::string(300, 'k') + "2";
+  const signing_key_scope scopes[] = {
+    {secret1, "20150830", "us-east-1", "service"},
+    {secret2, "20150830", "us-east-1", "service"},
+  };
+  std::vector<signing_key> keys;
+  make_signing_keys<sha256>(std::begin(scopes), std::end(scopes),
+                            std::back_inserter(keys));
+  ASSERT_EQ(2u, keys.size());
+  for (std::size_t i = 0; i < keys.size(); i++) {
+    const auto& s = scopes[i];
+    const auto expected = make_signing_key<sha256>(s.secret_access_key, s.date,
+                                                   s.region, s.service);
+    EXPECT_TRUE(std::equal(expected.data(), expected.data() + expected.size(),
+                           keys[i].data(), keys[i].data() + keys[i].size()))
+        << i;
+  }
+  EXPECT_FALSE(std::equal(keys[0].data(), keys[0].data() + keys[0].size(),
+                          keys[1].data(), keys[1].data() + keys[1].size()));
+}
+
+TEST(signing_key, make_signing_keys)
+{
+  const signing_key_scope scopes[] = {
+    {secret_access_key, "20150830", "us-east-1", "iam"},
+    {secret_access_key, "20150830", "us-east-1", "service"},
+  };
+  std::vector<signing_key> keys;
+  make_signing_keys<sha256>(std::begin(scopes), std::end(scopes),
+                            std::back_inserter(keys));
+  ASSERT_EQ(2u, keys.size());
+
+  std::string result;
+  detail::hex_encode(keys[0].data(), keys[0].data() + keys[0].size(),
+                     capture{result});
+  EXPECT_EQ(result, "c4afb1cc5771d871763a393e44b703571b55cc28424d1a5e86da6ed3c154a4b9");
+
+  const header_type headers[] = {
+    {"Host", "example.amazonaws.com"},
+    {"X-Amz-Date", "20150830T123600Z"},
+  };
+  result.clear();
+  sign<sha256>(access_key_id, keys[1], "GET", "/", "?%E1%88%B4=bar",
+               std::begin(headers), std::end(headers), empty_payload_hash,
+               "20150830T123600Z", "us-east-1", "service", capture{result});
+  EXPECT_EQ(result, "AWS4-HMAC-SHA256 \
+Credential=AKIDEXAMPLE/20150830/us-east-1/service/aws4_request, \
+SignedHeaders=host;x-amz-date, \
+Signature=2cdec8eed098649ff3a119c94853b13c643bcf08f8b0a1d91e12c9027818dd04");
+}
+
+TEST(sign, batch)
+{
+  const header_type headers[] = {
+    {"Host", "example.amazonaws.com"},
+    {"My-Header1", "value2"},
+    {"My-Header1", "value1"},
+    {"My-Header2", " \"a   b   c\""},
+    {"X-Amz-Date", "20150830T123600Z"},
+  };
+  const std::string_view paths[] = {"/", "/a b/../c", "/example//path"};
+  const std::string_view queries[] = {"", "?b=2&a=1", "?%E1%88%B4=bar"};
+
+  for (std::string_view service : {"service", "s3"}) {
+    // more requests than fit in one batch
+    constexpr std::size_t count = 70;
+    std::vector<std::string> results(count);
+    using request_type = sign_batch_request<const header_type*, capture>;
+    std::vector<request_type> requests;
+    for (std::size_t i = 0; i < count; i++) {
+      requests.push_back(request_type{
+          i % 2 ? "GET" : "PUT", paths[i % 3], queries[i % 3],
+          std::begin(headers), std::begin(headers) + 2 + i % 4,
+          empty_payload_hash,
+          i % 5 ? "20150830T123600Z" : "20150830T235959Z",
+          capture{results[i]}});
+    }
+    sign_batch<sha256>(access_key_id, secret_access_key, "us-east-1", service,
+                       requests.data(), requests.data() + count);
+
+    for (std::size_t i = 0; i < count; i++) {
+      const auto& r = requests[i];
+      std::string expected;
+      sign<sha256>(access_key_id, secret_access_key, r.method, r.uri_path,
+                   r.query, r.header0, r.headerN, r.payload_hash, r.date,
+                   "us-east-1", service, capture{expected});
+      EXPECT_EQ(expected, results[i]) << service << ' ' << i;
+    }
+  }
+}
+
+TEST(sign, batch_across_midnight)
+{
+  const header_type headers[] = {
+    {"Host", "example.amazonaws.com"},
+  };
+  // each day's requests must be signed with that day's key
+  const std::string_view dates[] = {
+    "20150830T235959Z", "20150830T235959Z", "20150831T000000Z",
+    "20150831T000001Z", "20150830T235959Z", "20150901T000000Z",
+  };
+  constexpr std::size_t count = std::size(dates);
+  std::vector<std::string> results(count);
+  using request_type = sign_batch_request<const header_type*, capture>;
+  std::vector<request_type> requests;
+  for (std::size_t i = 0; i < count; i++) {
+    requests.push_back(request_type{
+        "GET", "/", "", std::begin(headers), std::end(headers),
+        empty_payload_hash, dates[i], capture{results[i]}});
+  }
+  sign_batch<sha256>(access_key_id, secret_access_key, "us-east-1", "service",
+                     requests.data(), requests.data() + count);
+
+  for (std::size_t i = 0; i < count; i++) {
+    std::string expected;
+    sign<sha256>(access_key_id, secret_access_key, "GET", "/", "",
+                 std::begin(headers), std::end(headers), empty_payload_hash,
+                 dates[i], "us-east-1", "service", capture{expected});
+    EXPECT_EQ(expected, results[i]) << i;
+  }
+}
+
 } // namespace awssign::v4
@@ -0,0 +1,91 @@
+#include <awssign/v4/detail/signed_headers.hpp>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace awssign::v4 {
+
+struct header_type {
+  header_type(std::string_view name, std::string_view value) noexcept
+      : name_(name), value_(value)
+  {}
+  std::string_view name_string() const { return name_; }
+  std::string_view value() const { return value_; }
+ private:
+  std::string_view name_;
+  std::string_view value_;
+};
+
+std::vector<std::string_view> parse(std::string_view signed_headers)
+{
+  std::vector<detail::signed_header_name> names(
+      detail::max_signed_headers(signed_headers));
+  const auto end = detail::parse_signed_headers(signed_headers, names.data());
+  std::vector<std::string_view> result;
+  for (auto n = names.data(); n != end; ++n) {
+    result.push_back(n->name);
+  }
+  return result;
+}
+
+// return the values of the headers that are signed, in canonical order
+std::string select(std::string_view signed_headers,
+                   std::vector<header_type> headers)
+{
+  std::vector<detail::canonical_header> canonical(headers.size());
+  const auto canonical_end = detail::sorted_canonical_headers(
+      headers.begin(), headers.end(), canonical.data());
+  std::vector<detail::signed_header_name> names(
+      detail::max_signed_headers(signed_headers));
+  const auto names_end = detail::parse_signed_headers(signed_headers,
+                                                      names.data());
+  const auto end = detail::select_signed_headers(
+      canonical.data(), canonical_end, names.data(), names_end);
+  std::string result;
+  for (auto h = canonical.data(); h != end; ++h) {
+    if (!result.empty()) {
+      result += ',';
+    }
+    result.append(h->value);
+  }
+  return result;
+}
+
+TEST(signed_headers, parse)
+{
+  using names = std::vector<std::string_view>;
+  EXPECT_EQ(names{}, parse(""));
+  EXPECT_EQ(names{}, parse(";;"));
+  EXPECT_EQ(names{"host"}, parse("host"));
+  EXPECT_EQ((names{"host", "x-amz-date"}), parse("host;x-amz-date"));
+  EXPECT_EQ((names{"host", "x-amz-date"}), parse(";host;;x-amz-date;"));
+  EXPECT_EQ((names{"a", "b", "c"}), parse("c;a;b"));
+}
+
+TEST(signed_headers, select)
+{
+  const std::vector<header_type> headers = {
+    {"X-Amz-Date", "date"},
+    {"User-Agent", "agent"},
+    {"Host", "host"},
+    {"My-Header", "first"},
+    {"my-header", "second"},
+    {"Unsigned-With-A-Long-Name", "unsigned"},
+  };
+  EXPECT_EQ("", select("", headers));
+  EXPECT_EQ("host,date", select("host;x-amz-date", headers));
+  EXPECT_EQ("host,first,second,date",
+            select("host;my-header;x-amz-date", headers));
+  // names that aren't present are skipped
+  EXPECT_EQ("host", select("a;host;missing;zzz", headers));
+  // unsorted lists are sorted first
+  EXPECT_EQ("host,date", select("x-amz-date;host", headers));
+  // signed names are matched exactly, so they must be lower case
+  EXPECT_EQ("", select("Host", headers));
+  EXPECT_EQ("", select("hos;hostt", headers));
+  // uppercase names don't match, but don't hide the lowercase ones either
+  EXPECT_EQ("host", select("Zeta;host", headers));
+  EXPECT_EQ("host,date", select("X-Amz-Date;host;x-amz-date", headers));
+}
+
+} // namespace awssign::v4
@@ -0,0 +1,165 @@
+#include <awssign/v4/signing_key_cache.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <awssign/v4/sign.hpp>
+#include <awssign/v4/verify.hpp>
+
+namespace awssign::v4 {
+
+static constexpr auto access_key_id = "AKIDEXAMPLE";
+static constexpr auto secret_access_key =
+    "wJalrXUtnFEMI/K7MDENG+bPxRfiCYEXAMPLEKEY";
+
+struct capture {
+  std::string& value;
+
+  template <typename Iterator> // forward iterator with value_type=char
+  void operator()(Iterator begin, Iterator end) {
+    value.append(begin, end);
+  }
+};
+
+struct header_type {
+  header_type(std::string_view name, std::string_view value) noexcept
+      : name_(name), value_(value)
+  {}
+  std::string_view name_string() const { return name_; }
+  std::string_view value() const { return value_; }
+ private:
+  std::string_view name_;
+  std::string_view value_;
+};
+
+// sha256sum of empty buffer
+static constexpr std::string_view empty_payload_hash =
+    "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855";
+
+std::string hex_encode(const signing_key& key)
+{
+  std::string result;
+  detail::hex_encode(key.data(), key.data() + key.size(), capture{result});
+  return result;
+}
+
+TEST(signing_key_cache, example)
+{
+  auto cache = signing_key_cache{16};
+  const auto key = cache.get("SHA256", secret_access_key,
+                             "20150830", "us-east-1", "iam");
+  EXPECT_EQ(hex_encode(key), "c4afb1cc5771d871763a393e44b703571b55cc28424d1a5e86da6ed3c154a4b9");
+  // a second lookup returns the cached key
+  const auto cached = cache.get("SHA256", secret_access_key,
+                                "20150830", "us-east-1", "iam");
+  EXPECT_EQ(hex_encode(cached), hex_encode(key));
+}
+
+TEST(signing_key_cache, date_time)
+{
+  // only the YYYYMMDD part of the date contributes to the key
+  auto cache = signing_key_cache{16};
+  const auto key = cache.get("SHA256", secret_access_key,
+                             "20150830T123600Z", "us-east-1", "iam");
+  EXPECT_EQ(hex_encode(key), "c4afb1cc5771d871763a393e44b703571b55cc28424d1a5e86da6ed3c154a4b9");
+}
+
+TEST(signing_key_cache, distinct_scopes)
+{
+  auto cache = signing_key_cache{16};
+  const auto key1 = cache.get("SHA256", secret_access_key,
+                              "20150830", "us-east-1", "iam");
+  const auto key2 = cache.get("SHA256", secret_access_key,
+                              "20150830", "us-west-2", "iam");
+  const auto key3 = cache.get("SHA256", "other",
+                              "20150830", "us-east-1", "iam");
+  EXPECT_NE(hex_encode(key1), hex_encode(key2));
+  EXPECT_NE(hex_encode(key1), hex_encode(key3));
+  EXPECT_EQ(hex_encode(key2), hex_encode(make_signing_key(
+              "SHA256", secret_access_key, "20150830", "us-west-2", "iam")));
+  EXPECT_EQ(hex_encode(key3), hex_encode(make_signing_key(
+              "SHA256", "other", "20150830", "us-east-1", "iam")));
+}
+
+TEST(signing_key_cache, eviction)
+{
+  auto cache = signing_key_cache{4, 1};
+  EXPECT_EQ(4, cache.capacity());
+  // insert more services than the cache can hold
+  for (int i = 0; i < 16; i++) {
+    const auto service = std::to_string(i);
+    const auto key = cache.get("SHA256", secret_access_key,
+                               "20150830", "us-east-1", service);
+    EXPECT_EQ(hex_encode(key), hex_encode(make_signing_key(
+                "SHA256", secret_access_key, "20150830", "us-east-1",
+                service)));
+  }
+}
+
+TEST(signing_key_cache, threads)
+{
+  auto cache = signing_key_cache{8, 2};
+  const auto expected = hex_encode(make_signing_key(
+          "SHA256", secret_access_key, "20150830", "us-east-1", "iam"));
+  std::vector<std::thread> threads;
+  std::vector<std::string> results(4);
+  for (auto& result : results) {
+    threads.emplace_back([&cache, &result] {
+        for (int i = 0; i < 64; i++) {
+          // mix in other services to exercise eviction
+          cache.get("SHA256", secret_access_key, "20150830", "us-east-1",
+                    std::to_string(i % 12));
+          result = hex_encode(cache.get("SHA256", secret_access_key,
+                                        "20150830", "us-east-1", "iam"));
+        }
+      });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (const auto& result : results) {
+    EXPECT_EQ(expected, result);
+  }
+}
+
+TEST(signing_key_cache, sign)
+{
+  const header_type headers[] = {
+    {"Host", "example.amazonaws.com"},
+    {"My-Header1", " value1"},
+    {"My-Header2", " \"a   b   c\""},
+    {"X-Amz-Date", "20150830T123600Z"},
+  };
+  auto cache = signing_key_cache{16};
+  const auto key = cache.get("SHA256", secret_access_key,
+                             "20150830T123600Z", "us-east-1", "service");
+  std::string result;
+  sign("SHA256", access_key_id, key, "GET", "/", "",
+       std::begin(headers), std::end(headers), empty_payload_hash,
+       "20150830T123600Z", "us-east-1", "service", capture{result});
+  EXPECT_EQ(result, "AWS4-HMAC-SHA256 \
+Credential=AKIDEXAMPLE/20150830/us-east-1/service/aws4_request, \
+SignedHeaders=host;my-header1;my-header2;x-amz-date, \
+Signature=acc3ed3afb60bb290fc8d2dd0098b9911fcaa05412b367055dee359757a9c736");
+}
+
+TEST(signing_key_cache, verify)
+{
+  const header_type headers[] = {
+    {"Host", "example.amazonaws.com"},
+    {"My-Header1", " value1"},
+    {"My-Header2", " \"a   b   c\""},
+    {"X-Amz-Date", "20150830T123600Z"},
+  };
+  constexpr auto signed_headers = "host;my-header1;my-header2;x-amz-date";
+  auto cache = signing_key_cache{16};
+  const auto key = cache.get("SHA256", secret_access_key,
+                             "20150830T123600Z", "us-east-1", "service");
+  EXPECT_TRUE(verify("SHA256", "20150830T123600Z", "us-east-1", "service",
+                     signed_headers, "GET", "/", "",
+                     std::begin(headers), std::end(headers),
+                     empty_payload_hash, key,
+                     "acc3ed3afb60bb290fc8d2dd0098b9911fcaa05412b367055dee359757a9c736"));
+}
+
+} // namespace awssign::v4
@@ -34,4 +34,15 @@ TEST(string_to_sign, empty_timestamp)
 abcdefg)");
 }
 
+TEST(string_to_sign, sha256)
+{
+  std::string result;
+  detail::write_string_to_sign<sha256>("20130524T000000Z", "us-east-1", "s3",
+                                       "abcdefg", capture{result});
+  EXPECT_EQ(result, R"(AWS4-HMAC-SHA256
+20130524T000000Z
+20130524/us-east-1/s3/aws4_request
+abcdefg)");
+}
+
 } // namespace awssign::v4
@@ -1,4 +1,7 @@
 #include <awssign/v4/verify.hpp>
+#include <memory>
+#include <string>
+#include <vector>
 #include <gtest/gtest.h>
 
 namespace awssign::v4 {
@@ -129,4 +132,134 @@ TEST(verify, aws4_testsuite_get_vanilla_utf8_query)
                      "2cdec8eed098649ff3a119c94853b13c643bcf08f8b0a1d91e12c9027818dd04"));
 }
 
+TEST(verify, sha256)
+{
+  const header_type headers[] = {
+    {"Host", "example.amazonaws.com"},
+    {"My-Header1", " value1"},
+    {"My-Header2", " \"a   b   c\""},
+    {"X-Amz-Date", "20150830T123600Z"},
+  };
+  constexpr auto signed_headers = "host;my-header1;my-header2;x-amz-date";
+  EXPECT_TRUE(verify<sha256>("20150830T123600Z", "us-east-1", "service",
+                             signed_headers, "GET", "/", "",
+                             std::begin(headers), std::end(headers),
+                             empty_payload_hash, secret_access_key,
+                             "acc3ed3afb60bb290fc8d2dd0098b9911fcaa05412b367055dee359757a9c736"));
+  EXPECT_FALSE(verify<sha256>("20150830T123600Z", "us-east-1", "service",
+                              signed_headers, "GET", "/", "",
+                              std::begin(headers), std::end(headers),
+                              empty_payload_hash, secret_access_key,
+                              "0000000000000000000000000000000000000000000000000000000000000000"));
+}
+
+TEST(verify, malformed_signature)
+{
+  const header_type headers[] = {
+    {"Host", "example.amazonaws.com"},
+    {"My-Header1", " value1"},
+    {"My-Header2", " \"a   b   c\""},
+    {"X-Amz-Date", "20150830T123600Z"},
+  };
+  constexpr auto signed_headers = "host;my-header1;my-header2;x-amz-date";
+  const auto key = make_signing_key<sha256>(secret_access_key, "20150830",
+                                            "us-east-1", "service");
+  auto check = [&] (std::string_view signature) {
+    return verify<sha256>("20150830T123600Z", "us-east-1", "service",
+                          signed_headers, "GET", "/", "",
+                          std::begin(headers), std::end(headers),
+                          empty_payload_hash, key, signature);
+  };
+  constexpr std::string_view good =
+      "acc3ed3afb60bb290fc8d2dd0098b9911fcaa05412b367055dee359757a9c736";
+  EXPECT_TRUE(check(good));
+  EXPECT_FALSE(check(""));
+  EXPECT_FALSE(check(good.substr(1))); // odd length
+  EXPECT_FALSE(check(good.substr(2))); // a prefix of the digest
+  EXPECT_FALSE(check(std::string{good} + "00")); // too long
+  EXPECT_FALSE(check( // uppercase
+      "ACC3ED3AFB60BB290FC8D2DD0098B9911FCAA05412B367055DEE359757A9C736"));
+  EXPECT_FALSE(check( // not hex
+      "acc3ed3afb60bb290fc8d2dd0098b9911fcaa05412b367055dee359757a9c73g"));
+}
+
+TEST(verify, too_many_signed_headers)
+{
+  const header_type headers[] = {
+    {"Host", "example.amazonaws.com"},
+    {"My-Header1", " value1"},
+    {"My-Header2", " \"a   b   c\""},
+    {"X-Amz-Date", "20150830T123600Z"},
+  };
+  const auto key = make_signing_key<sha256>(secret_access_key, "20150830",
+                                            "us-east-1", "service");
+  auto check = [&] (std::string_view signed_headers) {
+    return verify<sha256>("20150830T123600Z", "us-east-1", "service",
+                          signed_headers, "GET", "/", "",
+                          std::begin(headers), std::end(headers),
+                          empty_payload_hash, key,
+                          "acc3ed3afb60bb290fc8d2dd0098b9911fcaa05412b367055dee359757a9c736");
+  };
+  const std::string signed_headers = "host;my-header1;my-header2;x-amz-date";
+  // a few extra separators are allowed
+  EXPECT_TRUE(check(signed_headers + std::string(16, ';')));
+  // but the names aren't parsed when there are too many of them
+  EXPECT_FALSE(check(signed_headers + std::string(17, ';')));
+  EXPECT_FALSE(check(signed_headers + std::string(100000, ';')));
+}
+
+TEST(verify, batch)
+{
+  const header_type headers[] = {
+    {"Host", "example.amazonaws.com"},
+    {"My-Header1", " value1"},
+    {"My-Header2", " \"a   b   c\""},
+    {"X-Amz-Date", "20150830T123600Z"},
+  };
+  const auto key = make_signing_key<sha256>(secret_access_key, "20150830",
+                                            "us-east-1", "service");
+  const auto other_key = make_signing_key<sha256>("other", "20150830",
+                                                  "us-east-1", "service");
+  using request_type = verify_batch_request<const header_type*>;
+  const auto good = request_type{
+      "20150830T123600Z", "us-east-1", "service",
+      "host;my-header1;my-header2;x-amz-date", "GET", "/", "",
+      std::begin(headers), std::end(headers), empty_payload_hash, &key,
+      "acc3ed3afb60bb290fc8d2dd0098b9911fcaa05412b367055dee359757a9c736"};
+  auto query = good;
+  query.signed_headers = "host;x-amz-date";
+  query.query = "?%E1%88%B4=bar";
+  query.signature = "2cdec8eed098649ff3a119c94853b13c643bcf08f8b0a1d91e12c9027818dd04";
+  auto bad_signature = good;
+  bad_signature.signature = "0000000000000000000000000000000000000000000000000000000000000000";
+  auto bad_key = good;
+  bad_key.key = &other_key;
+  auto malformed = good;
+  malformed.signature = "not hex";
+  auto too_many = good;
+  const auto too_many_signed_headers =
+      std::string{good.signed_headers} + std::string(17, ';');
+  too_many.signed_headers = too_many_signed_headers;
+
+  // more requests than fit in one batch. the rejected requests aren't hashed,
+  // so the others have to line up with their results
+  std::vector<request_type> requests;
+  for (int i = 0; i < 100; i++) {
+    switch (i % 6) {
+      case 0: requests.push_back(good); break;
+      case 1: requests.push_back(malformed); break;
+      case 2: requests.push_back(query); break;
+      case 3: requests.push_back(bad_signature); break;
+      case 4: requests.push_back(too_many); break;
+      default: requests.push_back(bad_key); break;
+    }
+  }
+  auto results = std::make_unique<bool[]>(requests.size());
+  verify_batch<sha256>(requests.data(), requests.data() + requests.size(),
+                       results.get());
+  for (std::size_t i = 0; i < requests.size(); i++) {
+    EXPECT_EQ(i % 6 == 0 || i % 6 == 2, results[i]) << i;
+  }
+}
+
 } // namespace awssign::v4
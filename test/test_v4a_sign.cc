@@ -0,0 +1,168 @@
+#include <awssign/v4a.hpp>
+#include <string>
+#include <gtest/gtest.h>
+
+namespace awssign::v4a {
+
+static constexpr auto access_key_id = "AKISORANDOMAASORANDOM";
+static constexpr auto secret_access_key =
+    "q+jcrXGc+0zWN6uzclKVhvMmUsIfRPa4rlRandom";
+
+struct capture {
+  std::string& value;
+
+  template <typename Iterator> // forward iterator with value_type=char
+  void operator()(Iterator begin, Iterator end) {
+    value.append(begin, end);
+  }
+};
+
+struct header_type {
+  header_type(std::string_view name, std::string_view value) noexcept
+      : name_(name), value_(value)
+  {}
+  std::string_view name_string() const { return name_; }
+  std::string_view value() const { return value_; }
+ private:
+  std::string_view name_;
+  std::string_view value_;
+};
+
+// sha256sum of empty buffer
+static constexpr std::string_view empty_payload_hash =
+    "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855";
+
+const header_type headers[] = {
+  {"Host", "example.amazonaws.com"},
+  {"X-Amz-Date", "20150830T123600Z"},
+  {"X-Amz-Region-Set", "us-east-1,us-west-2"},
+};
+
+std::string hex(const unsigned char* data, std::size_t size)
+{
+  std::string result;
+  awssign::detail::hex_encode(data, data + size, capture{result});
+  return result;
+}
+
+TEST(v4a_private_key, derivation)
+{
+  unsigned char scalar[detail::scalar_size];
+  detail::derive_private_scalar(access_key_id, secret_access_key, scalar);
+  EXPECT_EQ("7fd3bd010c0d9c292141c2b77bfbde1042c92e6836fff749d1269ec890fca1bd",
+            hex(scalar, sizeof(scalar)));
+}
+
+TEST(v4a_public_key, point)
+{
+  const auto key = private_key{access_key_id, secret_access_key};
+  unsigned char point[public_key::point_size];
+  key.public_key().write_point(point);
+  EXPECT_EQ(0x04, point[0]); // uncompressed
+
+  // a public key decoded from the point verifies the private key's signature
+  const auto decoded = public_key{point};
+  unsigned char digest[32] = {1, 2, 3};
+  unsigned char signature[private_key::max_signature_size];
+  const auto size = key.sign(digest, signature);
+  EXPECT_TRUE(decoded.verify(digest, signature, size));
+  digest[0] ^= 1;
+  EXPECT_FALSE(decoded.verify(digest, signature, size));
+
+  point[64] ^= 1; // off the curve
+  EXPECT_THROW(public_key{point}, awssign::detail::digest_error);
+}
+
+// split the Authorization header into SignedHeaders= and Signature=
+std::pair<std::string, std::string> parse(const std::string& authorization)
+{
+  const auto headers = authorization.find("SignedHeaders=") + 14;
+  const auto signature = authorization.find("Signature=");
+  return {authorization.substr(headers, authorization.find(',', headers) -
+                                        headers),
+          authorization.substr(signature + 10)};
+}
+
+TEST(v4a_sign, authorization_header)
+{
+  const auto key = private_key{access_key_id, secret_access_key};
+  std::string result;
+  sign(access_key_id, key, "GET", "/", "", std::begin(headers),
+       std::end(headers), empty_payload_hash, "20150830T123600Z", "service",
+       capture{result});
+  const std::string_view prefix = "AWS4-ECDSA-P256-SHA256 \
+Credential=AKISORANDOMAASORANDOM/20150830/service/aws4_request, \
+SignedHeaders=host;x-amz-date;x-amz-region-set, Signature=30";
+  EXPECT_EQ(prefix, result.substr(0, prefix.size()));
+}
+
+TEST(v4a_verify, round_trip)
+{
+  auto cache = key_cache{16};
+  const auto key = cache.get(access_key_id, secret_access_key);
+  std::string result;
+  sign(access_key_id, key, "GET", "/path", "a=b", std::begin(headers),
+       std::end(headers), empty_payload_hash, "20150830T123600Z", "service",
+       capture{result});
+  const auto [signed_headers, signature] = parse(result);
+
+  const auto public_key = key.public_key();
+  EXPECT_TRUE(verify("20150830T123600Z", "service", signed_headers, "GET",
+                     "/path", "a=b", std::begin(headers), std::end(headers),
+                     empty_payload_hash, public_key, signature));
+  // a different request
+  EXPECT_FALSE(verify("20150830T123600Z", "service", signed_headers, "PUT",
+                      "/path", "a=b", std::begin(headers), std::end(headers),
+                      empty_payload_hash, public_key, signature));
+  EXPECT_FALSE(verify("20150830T123600Z", "other", signed_headers, "GET",
+                      "/path", "a=b", std::begin(headers), std::end(headers),
+                      empty_payload_hash, public_key, signature));
+  // a different key
+  const auto other = cache.get(access_key_id, "other secret");
+  EXPECT_FALSE(verify("20150830T123600Z", "service", signed_headers, "GET",
+                      "/path", "a=b", std::begin(headers), std::end(headers),
+                      empty_payload_hash, other.public_key(), signature));
+}
+
+TEST(v4a_verify, malformed_signature)
+{
+  const auto key = private_key{access_key_id, secret_access_key};
+  std::string result;
+  sign(access_key_id, key, "GET", "/", "", std::begin(headers),
+       std::end(headers), empty_payload_hash, "20150830T123600Z", "service",
+       capture{result});
+  const auto [signed_headers, signature] = parse(result);
+  auto check = [&, signed_headers = signed_headers] (std::string_view sig) {
+    return verify("20150830T123600Z", "service", signed_headers, "GET", "/",
+                  "", std::begin(headers), std::end(headers),
+                  empty_payload_hash, key.public_key(), sig);
+  };
+  EXPECT_TRUE(check(signature));
+  EXPECT_FALSE(check(""));
+  EXPECT_FALSE(check(signature.substr(1))); // odd length
+  EXPECT_FALSE(check(signature.substr(2))); // truncated der
+  EXPECT_FALSE(check("zz" + signature.substr(2)));
+  EXPECT_FALSE(check(signature + "00"));
+  EXPECT_FALSE(check(std::string(200, '0')));
+}
+
+TEST(v4a_key_cache, hit)
+{
+  auto cache = key_cache{4, 2};
+  EXPECT_EQ(4u, cache.capacity());
+  unsigned char a[public_key::point_size];
+  unsigned char b[public_key::point_size];
+  cache.get(access_key_id, secret_access_key).public_key().write_point(a);
+  cache.get(access_key_id, secret_access_key).public_key().write_point(b);
+  EXPECT_EQ(hex(a, sizeof(a)), hex(b, sizeof(b)));
+  // fill past capacity, and check the result still matches a fresh key
+  for (int i = 0; i < 10; i++) {
+    cache.get(std::to_string(i), secret_access_key);
+  }
+  private_key{access_key_id, secret_access_key}.public_key().write_point(b);
+  cache.get(access_key_id, secret_access_key).public_key().write_point(a);
+  EXPECT_EQ(hex(a, sizeof(a)), hex(b, sizeof(b)));
+  cache.clear();
+}
+
+} // namespace awssign::v4a
@@ -0,0 +1,89 @@
+#include <awssign/detail/whitespace.hpp>
+#include <random>
+#include <string>
+#include <gtest/gtest.h>
+
+namespace awssign::detail {
+
+constexpr whitespace_backend backends[] = {
+  whitespace_backend::scalar,
+  whitespace_backend::sse2,
+  whitespace_backend::avx2,
+};
+
+// byte-at-a-time reference
+std::size_t expected_run(const std::string& s)
+{
+  for (std::size_t i = 0; i < s.size(); i++) {
+    if (whitespace(s[i]) && (s[i] != ' ' || whitespace(s[i + 1]))) {
+      return i;
+    }
+  }
+  return s.size();
+}
+
+std::size_t find_run(const std::string& s, whitespace_backend backend)
+{
+  const char* begin = s.data();
+  return find_whitespace_run(begin, begin + s.size(), backend) - begin;
+}
+
+TEST(whitespace, classify)
+{
+  for (int c = 0; c < 256; c++) {
+    const bool expected = c == ' ' || (c >= '\t' && c <= '\r');
+    EXPECT_EQ(expected, whitespace(c)) << c;
+  }
+}
+
+TEST(whitespace, single_spaces)
+{
+  const auto value = std::string{"a b c d e f g h i j k l m n o p q r s t u v w x y z "
+                                 "a b c d e f g h i j k l m n o p q r s t u v w x y z"};
+  for (auto backend : backends) {
+    if (whitespace_supported(backend)) {
+      EXPECT_EQ(value.size(), find_run(value, backend));
+    }
+  }
+}
+
+TEST(whitespace, runs)
+{
+  // place each kind of run at every position of a value that spans several
+  // blocks of each backend
+  const std::string runs[] = {"  ", "\t", "\n", "\v", "\f", "\r", " \t", "\t "};
+  for (const auto& run : runs) {
+    for (std::size_t pos = 1; pos < 80; pos++) {
+      auto value = std::string(82, 'x');
+      value.replace(pos, run.size(), run);
+      SCOPED_TRACE(pos);
+      for (auto backend : backends) {
+        if (whitespace_supported(backend)) {
+          EXPECT_EQ(pos, find_run(value, backend));
+        }
+      }
+    }
+  }
+}
+
+TEST(whitespace, random)
+{
+  std::default_random_engine rng;
+  constexpr std::string_view alphabet = "abcdefgh  \t\n\v\f\r\x80";
+  auto chars = std::uniform_int_distribution<std::size_t>{0, alphabet.size() - 1};
+  for (int n = 0; n < 1000; n++) {
+    std::string value(n % 100 + 1, '\0');
+    for (auto& c : value) {
+      c = alphabet[chars(rng)];
+    }
+    value.back() = 'z'; // the last character can't be whitespace
+    SCOPED_TRACE(value);
+    for (auto backend : backends) {
+      if (whitespace_supported(backend)) {
+        EXPECT_EQ(expected_run(value), find_run(value, backend));
+      }
+    }
+  }
+}
+
+} // namespace awssign::detail